@@ -20,6 +20,10 @@ extern "C" {
  * the output to extract file information and calculate total size. All parsing
  * and progress is logged to logfile.txt.
  *
+ * A plain "lha l <archive>" is answered by reading the member headers in
+ * this process; the command only runs if that reader cannot handle the
+ * command or the archive.
+ *
  * @param cmd Complete command string to execute (e.g., "lha l archive.lha")
  * @param out_total Pointer to receive total uncompressed size in bytes
  * @return true if command executed successfully and parsing completed
@@ -34,6 +38,9 @@ bool cli_list(const char *cmd, uint32_t *out_total);
  * and parses the output line-by-line to track progress. Each extracted file
  * contributes to a cumulative byte count, with percentage calculated against
  * the expected total. All parsing and progress is logged to logfile.txt.
+ * On host (LHA_NATIVE_EXTRACT), a plain "lha x" or "lha e" command is
+ * decoded in-process instead, several members at once, with progress
+ * counted in decoded bytes.
  *
  * @param cmd Complete command string to execute (e.g., "lha x -m -n archive.lha dest/")
  * @param total_expected Total bytes expected to be extracted (from cli_list)
@@ -1,6 +1,11 @@
 #include "cli_wrapper.h"
 #include "process_control.h"
 #include "lha_wrapper.h"
+#include "lha_archive.h"
+#include "lha_extract.h"
+#include "line_splitter.h"
+#include "line_scan.h"
+#include "platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,12 +33,15 @@ static bool g_initialized = false;
 /* Internal helper functions */
 static void log_timestamp(void);
 static void log_message(const char *format, ...);
-static void strip_escape_codes(const char *input, char *output, size_t output_size);
 static bool parse_lha_list_line(const char *line, uint32_t *file_size);
 static bool parse_lha_extract_line(const char *line, uint32_t *file_size, char *filename, size_t filename_max);
 static bool parse_unzip_list_line(const char *line, uint32_t *file_size);
 static bool parse_unzip_extract_line(const char *line, uint32_t *file_size, char *filename, size_t filename_max);
 static bool check_directory_exists(const char *path);
+#if LHA_NATIVE_EXTRACT
+static void extract_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                             void *user_data);
+#endif
 
 #ifdef PLATFORM_AMIGA
 static bool execute_command_amiga(const char *cmd, bool (*line_processor)(const char *, void *), void *user_data);
@@ -54,6 +62,7 @@ typedef struct {
     uint32_t file_count;
     uint32_t last_percentage_x10;  /* Percentage * 10 to avoid floating point */
     bool completion_detected;  /* Flag to indicate LHA completion */
+    char current_file[64];     /* Last file reported by the extractor */
 } extract_context_t;
 
 bool cli_wrapper_init(void)
@@ -80,6 +89,7 @@ bool cli_wrapper_init(void)
         }
     }
 
+    line_scan_init();
     g_initialized = true;
 
     if (g_logfile) {
@@ -88,7 +98,7 @@ bool cli_wrapper_init(void)
 #ifdef PLATFORM_AMIGA
             "Amiga"
 #else
-            "Host (stubbed)"
+            "Host (POSIX)"
 #endif
         );
     }
@@ -310,6 +320,45 @@ static bool parse_unzip_extract_line(const char *line, uint32_t *file_size, char
     return true;
 }
 
+#if LHA_NATIVE_EXTRACT
+/* Progress from lha_extract_archive(): exact byte counts while a member is
+ * written, then the same per-file line the LhA output produces */
+static void extract_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                             void *user_data)
+{
+    extract_context_t *ctx = (extract_context_t *)user_data;
+    uint32_t percentage_x10 = 0;
+
+    ctx->cumulative_bytes += new_bytes;
+    if (ctx->total_expected > 0) {
+        percentage_x10 = (uint32_t)(((uint64_t)ctx->cumulative_bytes * 1000) / ctx->total_expected);
+    }
+
+    if (!finished) {
+        /* Large members report in between, at most once per 1% */
+        if (percentage_x10 >= ctx->last_percentage_x10 + 10) {
+            ctx->last_percentage_x10 = percentage_x10;
+            printf("Progress: %s [%u.%u%%]\n", member->path,
+                   percentage_x10 / 10, percentage_x10 % 10);
+            fflush(stdout);
+        }
+        return;
+    }
+
+    ctx->file_count++;
+    ctx->last_percentage_x10 = percentage_x10;
+    strncpy(ctx->current_file, member->path, sizeof(ctx->current_file) - 1);
+    ctx->current_file[sizeof(ctx->current_file) - 1] = '\0';
+
+    printf("Extracting: %s (%u files) [%u.%u%%]\n", ctx->current_file, ctx->file_count,
+           percentage_x10 / 10, percentage_x10 % 10);
+    fflush(stdout);
+    log_message("EXTRACT_PROGRESS: %s (%lu bytes), %lu/%lu bytes so far", member->path,
+                (unsigned long)member->original_size, (unsigned long)ctx->cumulative_bytes,
+                (unsigned long)ctx->total_expected);
+}
+#endif
+
 static bool check_directory_exists(const char *path)
 {
 #ifdef PLATFORM_AMIGA
@@ -373,7 +422,7 @@ static bool extract_line_processor(const char *line, void *user_data)
     extract_context_t *ctx = (extract_context_t *)user_data;
     log_message("EXTRACT_PROCESSOR: Context ptr: %p", (void*)ctx);
     uint32_t file_size;
-    static char filename[64];  /* Static to avoid stack usage, smaller size */
+    char *filename = ctx->current_file;  /* Per-extraction, keeps the processor reentrant */
 
     /* Check for LHA error messages first */
     if (strstr(line, "*** Error") || strstr(line, "Unable to open")) {
@@ -400,7 +449,7 @@ static bool extract_line_processor(const char *line, void *user_data)
     }
 
     log_message("EXTRACT_PROCESSOR: About to parse line");
-    if (parse_lha_extract_line(line, &file_size, filename, sizeof(filename))) {
+    if (parse_lha_extract_line(line, &file_size, filename, sizeof(ctx->current_file))) {
         log_message("EXTRACT_PROCESSOR: Successfully parsed - file: '%s', size: %u", filename, file_size);
         ctx->cumulative_bytes += file_size;
         ctx->file_count++;
@@ -453,10 +502,62 @@ typedef struct {
     const char *pipe_prefix;    /* "lha_pipe", "unzip_pipe", etc. */
     int timeout_seconds;        /* Default: 2 */
     bool silent_mode;          /* Suppress console output */
+    uint32_t read_chunk_size;   /* Bytes per Read() (0 = PROCESS_DEFAULT_READ_CHUNK) */
+    uint32_t max_line_length;   /* Longer lines are split (0 = unlimited) */
+    uint32_t max_lines;         /* Stop after N lines (0 = unlimited) */
+    uint32_t stall_timeout_seconds; /* Give up after this long without output (0 = timeout_seconds) */
 } amiga_exec_config_t;
 
+/* Counts and logs each line view before handing it to the wrapper's line
+ * processors; escape codes have already been stripped in place */
+typedef struct {
+    bool (*line_processor)(const char *, void *);
+    void *user_data;
+    const char *log_tag;
+    int line_count;
+} line_adapter_t;
+
+static bool line_adapter(const char *line, size_t length, void *user_data)
+{
+    line_adapter_t *adapter = (line_adapter_t *)user_data;
+
+    adapter->line_count++;
+    log_message("%s: Processing line %d (%lu bytes): [%s]", adapter->log_tag,
+               adapter->line_count, (unsigned long)length, line);
+
+    return adapter->line_processor(line, adapter->user_data);
+}
+
 #ifdef PLATFORM_AMIGA
 
+/* Allocates the Read() chunk buffer (plus a terminator) and a growable line
+ * splitter sized from the config */
+static bool open_line_reader(const amiga_exec_config_t *config, const char *log_tag,
+                             char **out_buf, size_t *out_chunk_size, line_splitter_t *splitter)
+{
+    size_t chunk_size = config->read_chunk_size > 0 ? config->read_chunk_size
+                                                    : PROCESS_DEFAULT_READ_CHUNK;
+
+    *out_buf = (char *)malloc(chunk_size + 1);
+    if (!*out_buf) {
+        log_message("%s: ERROR - Failed to allocate %lu byte read buffer", log_tag,
+                   (unsigned long)chunk_size);
+        return false;
+    }
+
+    if (!line_splitter_init_growable(splitter, config->max_line_length)) {
+        log_message("%s: ERROR - Failed to allocate line buffer", log_tag);
+        free(*out_buf);
+        *out_buf = NULL;
+        return false;
+    }
+    line_splitter_set_line_limit(splitter, config->max_lines);
+    line_splitter_set_strip_escapes(splitter, true);
+
+    *out_chunk_size = chunk_size;
+    return true;
+}
+
 static bool execute_command_amiga_streaming(const char *cmd,
                                           bool (*line_processor)(const char *, void *),
                                           void *user_data,
@@ -512,10 +613,7 @@ static bool execute_command_amiga_streaming(const char *cmd,
         log_message("EXECUTE_AMIGA_STREAMING: Found existing pipe, closing it");
         Close(existing_pipe);
         /* Brief delay to allow cleanup */
-        volatile int cleanup_delay;
-        for (cleanup_delay = 0; cleanup_delay < 10000; cleanup_delay++) {
-            /* 20ms cleanup delay */
-        }
+        plat_sleep_ms(20);
     }
     log_message("EXECUTE_AMIGA_STREAMING: Pipe cleanup completed");
 
@@ -534,15 +632,22 @@ static bool execute_command_amiga_streaming(const char *cmd,
         fflush(stdout);
     }
 
-    /* Create command with pipe redirection for background execution */
-    char full_cmd[512];
-    snprintf(full_cmd, sizeof(full_cmd), "%s >%s", cmd, pipe_name);
-    log_message("EXECUTE_AMIGA_STREAMING: Full command with redirection: %s", full_cmd);
-
     /* Close the write pipe handle so the background command can open it */
     Close(pipe);
     log_message("EXECUTE_AMIGA_STREAMING: Write pipe closed");
 
+    /* Create command with pipe redirection for background execution,
+     * sized to fit so long destination paths are never cut off */
+    size_t full_cmd_size = strlen(cmd) + strlen(pipe_name) + 3;
+    char *full_cmd = (char *)malloc(full_cmd_size);
+    if (!full_cmd) {
+        log_message("EXECUTE_AMIGA_STREAMING: ERROR - No memory for %lu byte command",
+                   (unsigned long)full_cmd_size);
+        return false;
+    }
+    snprintf(full_cmd, full_cmd_size, "%s >%s", cmd, pipe_name);
+    log_message("EXECUTE_AMIGA_STREAMING: Full command with redirection: %s", full_cmd);
+
     /* Execute command asynchronously using SystemTags or fallback to System */
     struct TagItem tags[] = {
         { SYS_Asynch, TRUE },
@@ -560,12 +665,6 @@ static bool execute_command_amiga_streaming(const char *cmd,
     /* First attempt: SystemTagList with async */
     log_message("EXECUTE_AMIGA_STREAMING: Attempting SystemTagList execution");
     
-    /* Add safety check before SystemTagList */
-    if (strlen(full_cmd) > 500) {
-        log_message("EXECUTE_AMIGA_STREAMING: ERROR - Command too long: %d chars", (int)strlen(full_cmd));
-        return false;
-    }
-    
     proc_result = SystemTagList(full_cmd, tags);
     log_message("EXECUTE_AMIGA_STREAMING: SystemTagList result: %ld", proc_result);
 
@@ -578,10 +677,7 @@ static bool execute_command_amiga_streaming(const char *cmd,
         };
         
         /* Add delay before retry */
-        volatile int retry_delay;
-        for (retry_delay = 0; retry_delay < 100000; retry_delay++) {
-            /* 200ms delay before retry */
-        }
+        plat_sleep_ms(200);
         
         proc_result = SystemTagList(full_cmd, sync_tags);
         log_message("EXECUTE_AMIGA_STREAMING: SystemTagList sync result: %ld", proc_result);
@@ -590,9 +686,11 @@ static bool execute_command_amiga_streaming(const char *cmd,
             /* Fallback 2: Skip System() call - too risky */
             log_message("EXECUTE_AMIGA_STREAMING: All SystemTagList attempts failed");
             log_message("EXECUTE_AMIGA_STREAMING: Skipping System() fallback for safety");
+            free(full_cmd);
             return false;
         }
     }
+    free(full_cmd);
     
     if (proc_result == -1) {
         log_message("ERROR: All execution methods failed for %s process", config->tool_name);
@@ -613,12 +711,8 @@ static bool execute_command_amiga_streaming(const char *cmd,
         startup_attempts++;
         log_message("EXECUTE_AMIGA_STREAMING: Startup attempt %d/%d", startup_attempts, MAX_STARTUP_ATTEMPTS);
         
-        /* Progressive delay - start short, get longer */
-        volatile int delay_counter;
-        int delay_iterations = 20000 * startup_attempts; /* 40ms, 80ms, 120ms, etc. */
-        for (delay_counter = 0; delay_counter < delay_iterations; delay_counter++) {
-            /* Progressive startup delay */
-        }
+        /* Progressive delay - start short, get longer: 40ms, 80ms, 120ms, etc. */
+        plat_sleep_ms(40 * (uint32_t)startup_attempts);
         
         /* Try to check if pipe is available by attempting to open it */
         log_message("EXECUTE_AMIGA_STREAMING: Testing pipe availability");
@@ -656,10 +750,7 @@ static bool execute_command_amiga_streaming(const char *cmd,
             if (open_attempts < MAX_OPEN_ATTEMPTS) {
                 log_message("EXECUTE_AMIGA_STREAMING: Retrying pipe open after delay");
                 /* Brief delay before retry */
-                volatile int retry_delay;
-                for (retry_delay = 0; retry_delay < 30000; retry_delay++) {
-                    /* 60ms retry delay */
-                }
+                plat_sleep_ms(60);
             }
         } else {
             log_message("EXECUTE_AMIGA_STREAMING: Pipe opened successfully for reading on attempt %d", open_attempts);
@@ -683,15 +774,20 @@ static bool execute_command_amiga_streaming(const char *cmd,
     }
 
     /* 4. Immediate reading loop with timeout and enhanced safety */
-    char buf[64];   /* Even smaller buffer for maximum Amiga safety */
-    char partial_line[128] = {0};  /* Much smaller line buffer */
+    char *buf;
+    size_t chunk_size;
+    line_splitter_t splitter;
+    line_adapter_t adapter = {line_processor, user_data, "EXECUTE_AMIGA_STREAMING", 0};
 
-    int line_count = 0;
-    ULONG bytesRead;
-    int empty_reads = 0;
-    const int MAX_EMPTY_READS = config->timeout_seconds * 25; /* 25 checks per second */
+    LONG bytesRead;
+    uint32_t stall_seconds = config->stall_timeout_seconds > 0 ?
+        config->stall_timeout_seconds : (uint32_t)config->timeout_seconds;
+    uint64_t last_output_ms = plat_monotonic_ms();
+    plat_backoff_t backoff;
 
-    log_message("EXECUTE_AMIGA_STREAMING: Starting pipe read loop, MAX_EMPTY_READS = %d", MAX_EMPTY_READS);
+    plat_backoff_init(&backoff, PLAT_BACKOFF_MIN_MS, PLAT_BACKOFF_MAX_MS);
+    log_message("EXECUTE_AMIGA_STREAMING: Starting pipe read loop, stall deadline = %lu seconds",
+               (unsigned long)stall_seconds);
 
     /* Add safety check for valid pipe */
     if (!read_pipe) {
@@ -699,187 +795,72 @@ static bool execute_command_amiga_streaming(const char *cmd,
         return false;
     }
 
-    while (empty_reads < MAX_EMPTY_READS) {
-        /* Add periodic safety check */
-        if (line_count > 1000) {
-            log_message("EXECUTE_AMIGA_STREAMING: Safety limit - processed over 1000 lines, breaking");
-            break;
-        }
-        
-        log_message("EXECUTE_AMIGA_STREAMING: Read attempt %d/%d", empty_reads + 1, MAX_EMPTY_READS);
-        
-        /* Initialize buffer safely */
-        memset(buf, 0, sizeof(buf));
-        
-        bytesRead = Read(read_pipe, buf, sizeof(buf) - 1);
+    if (!open_line_reader(config, "EXECUTE_AMIGA_STREAMING", &buf, &chunk_size, &splitter)) {
+        return false;
+    }
+
+    for (;;) {
+        bytesRead = Read(read_pipe, buf, (LONG)chunk_size);
         log_message("EXECUTE_AMIGA_STREAMING: Read returned %ld bytes", (long)bytesRead);
 
         if (bytesRead > 0) {
-            empty_reads = 0; /* Reset timeout counter */
-            log_message("EXECUTE_AMIGA_STREAMING: Got data, resetting empty_reads counter");
-
-            /* Ensure buffer safety - paranoid safety checks */
-            if (bytesRead >= sizeof(buf)) {
-                log_message("EXECUTE_AMIGA_STREAMING: CRITICAL - bytesRead %ld >= buffer size %ld", 
-                           (long)bytesRead, (long)sizeof(buf));
-                bytesRead = sizeof(buf) - 1;
-            }
-
-            /* Additional safety - ensure we don't overrun buffer */
-            if (bytesRead > 63) {
-                log_message("EXECUTE_AMIGA_STREAMING: CRITICAL - bytesRead %ld > 63", (long)bytesRead);
-                bytesRead = 63;
-            }
+            /* Output is flowing - go back to short waits and restart the deadline */
+            plat_backoff_reset(&backoff);
+            last_output_ms = plat_monotonic_ms();
 
-            /* Ensure null termination */
+            /* Terminate for the raw stream log only - the splitter uses the length */
             buf[bytesRead] = '\0';
-            
-            /* Additional safety check for buffer corruption */
-            if (bytesRead > 0 && buf[bytesRead-1] != '\0') {
-                log_message("EXECUTE_AMIGA_STREAMING: Buffer safety check passed");
-            }
-
-            /* Debug: Log raw data received */
-            log_message("EXECUTE_AMIGA_STREAMING: Read %ld bytes: [%s]", (long)bytesRead, buf);
             log_message("STREAM_RESPONSE: [%s]", buf);  /* Log every stream response as requested */
 
-            /* Get current timing for real-time feedback */
-            clock_t current_time = clock();
-            ULONG current_ticks = (unsigned long)current_time;
-
-            /* Process buffer character by character to handle partial lines */
-            char *buffer_ptr = buf;
-            int chars_processed = 0;
-            while (*buffer_ptr) {
-                char ch = *buffer_ptr++;
-                chars_processed++;
-
-                if (ch == '\n' || ch == '\r') {
-                    /* Complete line found */
-                    if (strlen(partial_line) > 0) {
-                        line_count++;
-
-                        /* Strip escape codes before processing */
-                        char cleaned_line[128];
-                        strip_escape_codes(partial_line, cleaned_line, sizeof(cleaned_line));
-
-                        /* Debug: Log both raw and cleaned line */
-                        log_message("EXECUTE_AMIGA_STREAMING: Processing line %d RAW: [%s]", line_count, partial_line);
-                        log_message("EXECUTE_AMIGA_STREAMING: Processing line %d CLEANED: [%s]", line_count, cleaned_line);
-
-                        /* Process the cleaned line for real-time tracking */
-                        if (!line_processor(cleaned_line, user_data)) {
-                            log_message("EXECUTE_AMIGA_STREAMING: Line processor returned false, stopping");
-                            goto cleanup;
-                        }
-
-                        /* Clear partial line buffer safely */
-                        partial_line[0] = '\0';
-                    }
-                } else {
-                    /* Add character to partial line with STRICT safety */
-                    size_t len = strlen(partial_line);
-                    if (len < 120) {  /* Much stricter limit - leave 8 chars safety margin */
-                        partial_line[len] = ch;
-                        partial_line[len + 1] = '\0';
-                    } else {
-                        /* Buffer would overflow - force line completion */
-                        log_message("EXECUTE_AMIGA_STREAMING: Line buffer near full, forcing completion");
-                        if (strlen(partial_line) > 0) {
-                            line_count++;
-                            
-                            /* Strip escape codes before processing */
-                            char cleaned_line[128];
-                            strip_escape_codes(partial_line, cleaned_line, sizeof(cleaned_line));
-                            
-                            log_message("EXECUTE_AMIGA_STREAMING: Processing forced line %d RAW: [%s]", line_count, partial_line);
-                            log_message("EXECUTE_AMIGA_STREAMING: Processing forced line %d CLEANED: [%s]", line_count, cleaned_line);
-                            
-                            if (!line_processor(cleaned_line, user_data)) {
-                                log_message("EXECUTE_AMIGA_STREAMING: Line processor returned false, stopping");
-                                goto cleanup;
-                            }
-                            partial_line[0] = '\0';
-                        }
-                        /* Add current character to fresh buffer */
-                        partial_line[0] = ch;
-                        partial_line[1] = '\0';
-                    }
-                }
-            }
-            log_message("EXECUTE_AMIGA_STREAMING: Processed %d characters from buffer", chars_processed);
-        } else if (bytesRead == 0) {
-            /* EOF reached - but might be temporary, check a few times */
-            empty_reads++;
-            log_message("EXECUTE_AMIGA_STREAMING: EOF reached, empty_reads = %d/%d", empty_reads, MAX_EMPTY_READS);
-            if (empty_reads < MAX_EMPTY_READS) {
-                /* Use cooperative AmigaOS wait instead of busy-wait */
-                log_message("EXECUTE_AMIGA_STREAMING: Calling WaitForChar with 100000 timeout");
-                if (WaitForChar(read_pipe, 100000)) {
-                    /* Data became available, reset counter and try again */
-                    log_message("EXECUTE_AMIGA_STREAMING: WaitForChar returned TRUE - data available");
-                    empty_reads = 0;
-                    continue;
+            /* Split the whole chunk at once - partial lines carry over */
+            if (!line_splitter_feed_views(&splitter, buf, (size_t)bytesRead, line_adapter, &adapter)) {
+                if (splitter.limit_reached) {
+                    log_message("EXECUTE_AMIGA_STREAMING: Line limit of %lu reached, stopping",
+                               (unsigned long)config->max_lines);
                 } else {
-                    /* Timeout occurred (~20ms), continue with empty_reads increment */
-                    log_message("EXECUTE_AMIGA_STREAMING: WaitForChar returned FALSE - timeout");
-                    continue;
+                    log_message("EXECUTE_AMIGA_STREAMING: Line processor returned false, stopping");
                 }
-            } else {
-                log_message("EXECUTE_AMIGA_STREAMING: Max empty reads reached, breaking loop");
-                break;
+                goto cleanup;
             }
-        } else {
-            /* Read error */
+            log_message("EXECUTE_AMIGA_STREAMING: Processed %ld characters from buffer", (long)bytesRead);
+            continue;
+        }
+
+        if (bytesRead < 0) {
+            /* Read error - treated like a quiet pipe until the deadline */
             LONG error = IoErr();
             log_message("EXECUTE_AMIGA: Read error: %ld", error);
             log_message("EXECUTE_AMIGA: Bytes read: %ld (negative indicates error)", (long)bytesRead);
-            empty_reads++;
-            if (empty_reads < MAX_EMPTY_READS) {
-                /* Use cooperative AmigaOS wait after read error */
-                log_message("EXECUTE_AMIGA_STREAMING: Calling WaitForChar after read error");
-                if (WaitForChar(read_pipe, 100000)) {
-                    /* Data became available after error, reset counter */
-                    log_message("EXECUTE_AMIGA_STREAMING: WaitForChar returned TRUE after error");
-                    empty_reads = 0;
-                    continue;
-                } else {
-                    /* Timeout occurred, continue with empty_reads increment */
-                    log_message("EXECUTE_AMIGA_STREAMING: WaitForChar returned FALSE after error");
-                    continue;
-                }
-            } else {
-                log_message("EXECUTE_AMIGA_STREAMING: Max empty reads reached after error, breaking loop");
-                break;
-            }
+        }
+
+        /* Nothing to read - the pipe may only be quiet, so give up only at the deadline */
+        if (plat_monotonic_ms() - last_output_ms >= (uint64_t)stall_seconds * 1000) {
+            log_message("EXECUTE_AMIGA_STREAMING: No output for %lu seconds, breaking loop",
+                       (unsigned long)stall_seconds);
+            break;
+        }
+
+        /* Wait longer each quiet round, but wake as soon as output arrives */
+        uint32_t wait_ms = plat_backoff_next(&backoff);
+        if (plat_wait_readable(read_pipe, (int32_t)wait_ms) > 0) {
+            log_message("EXECUTE_AMIGA_STREAMING: Output available");
+        } else {
+            log_message("EXECUTE_AMIGA_STREAMING: No output within %lu ms", (unsigned long)wait_ms);
         }
     }
 
 cleanup:
 
     /* Process any remaining partial line */
-    if (strlen(partial_line) > 0) {
-        line_count++;
-        
-        /* Strip escape codes before processing */
-        char cleaned_line[128];
-        strip_escape_codes(partial_line, cleaned_line, sizeof(cleaned_line));
-        
-        log_message("EXECUTE_AMIGA_STREAMING: Processing final partial line RAW: [%s]", partial_line);
-        log_message("EXECUTE_AMIGA_STREAMING: Processing final partial line CLEANED: [%s]", cleaned_line);
-        
-        line_processor(cleaned_line, user_data);
-    }
+    line_splitter_flush_views(&splitter, line_adapter, &adapter);
 
-    log_message("EXECUTE_AMIGA_STREAMING: Total lines processed: %d", line_count);
+    log_message("EXECUTE_AMIGA_STREAMING: Total lines processed: %d (%lu split at max length)",
+               adapter.line_count, (unsigned long)splitter.forced_splits);
+    line_splitter_free(&splitter);
+    free(buf);
 
-    /* Brief delay to allow process cleanup - much shorter than before */
-    {
-        volatile int delay_counter;
-        for (delay_counter = 0; delay_counter < 5000; delay_counter++) {
-            /* Minimal cleanup delay - reduced from 20000 to 5000 iterations */
-        }
-    }
+    /* Brief delay to allow process cleanup */
+    plat_sleep_ms(10);
 
     /* 6. Enhanced cleanup with pipe name clearing */
     log_message("EXECUTE_AMIGA_STREAMING: About to close read pipe");
@@ -899,23 +880,18 @@ cleanup:
     }
     
     /* Extended cleanup delay to ensure system stability */
-    {
-        volatile int delay_counter;
-        for (delay_counter = 0; delay_counter < 20000; delay_counter++) {
-            /* Extended cleanup delay - increased to 40ms for stability */
-        }
-    }
+    plat_sleep_ms(40);
     log_message("EXECUTE_AMIGA_STREAMING: Extended cleanup delay completed");
 
     if (!config->silent_mode) {
         log_message("EXECUTE_AMIGA_STREAMING: About to print completion message");
-        printf("Real-time streaming completed - processed %d lines\n", line_count);
+        printf("Real-time streaming completed - processed %d lines\n", adapter.line_count);
         fflush(stdout);
         log_message("EXECUTE_AMIGA_STREAMING: Completion message printed");
     }
 
     log_message("EXECUTE_AMIGA_STREAMING: About to return success");
-    log_message("EXECUTE_AMIGA_STREAMING: Returning success=true, total lines processed: %d", line_count);
+    log_message("EXECUTE_AMIGA_STREAMING: Returning success=true, total lines processed: %d", adapter.line_count);
     return true;
 }
 
@@ -957,9 +933,7 @@ static bool execute_command_amiga_proper(const char *cmd,
     log_message("EXECUTE_AMIGA_PROPER: Generated pipe name: %s", pipe_name);
     
     /* Create command with pipe redirection */
-    char full_cmd[512];
-    snprintf(full_cmd, sizeof(full_cmd), "%s >%s", cmd, pipe_name);
-    log_message("EXECUTE_AMIGA_PROPER: Full command: %s", full_cmd);
+    log_message("EXECUTE_AMIGA_PROPER: Full command: %s >%s", cmd, pipe_name);
     
     /* Create new process using CreateNewProc */
     log_message("EXECUTE_AMIGA_PROPER: Creating new process");
@@ -982,52 +956,28 @@ static bool execute_command_amiga_proper(const char *cmd,
     }
     
     /* Read from pipe until EOF */
-    char buf[64];
-    char partial_line[128] = {0};
-    int line_count = 0;
-    ULONG bytesRead;
+    char *buf;
+    size_t chunk_size;
+    line_splitter_t splitter;
+    line_adapter_t adapter = {line_processor, user_data, "EXECUTE_AMIGA_PROPER", 0};
+    LONG bytesRead;
+    
+    if (!open_line_reader(config, "EXECUTE_AMIGA_PROPER", &buf, &chunk_size, &splitter)) {
+        Close(read_pipe);
+        return false;
+    }
     
     log_message("EXECUTE_AMIGA_PROPER: Starting pipe reading loop");
     
-    while ((bytesRead = Read(read_pipe, buf, sizeof(buf) - 1)) > 0) {
-        buf[bytesRead] = '\0';
-        log_message("EXECUTE_AMIGA_PROPER: Read %ld bytes: [%s]", (long)bytesRead, buf);
+    while ((bytesRead = Read(read_pipe, buf, (LONG)chunk_size)) > 0) {
+        log_message("EXECUTE_AMIGA_PROPER: Read %ld bytes", (long)bytesRead);
         
-        /* Process buffer character by character */
-        char *buffer_ptr = buf;
-        while (*buffer_ptr) {
-            char ch = *buffer_ptr++;
-            
-            if (ch == '\n' || ch == '\r') {
-                /* Complete line found */
-                if (strlen(partial_line) > 0) {
-                    line_count++;
-                    
-                    /* Strip escape codes */
-                    char cleaned_line[128];
-                    strip_escape_codes(partial_line, cleaned_line, sizeof(cleaned_line));
-                    
-                    log_message("EXECUTE_AMIGA_PROPER: Processing line %d: [%s]", line_count, cleaned_line);
-                    
-                    /* Process the line */
-                    if (!line_processor(cleaned_line, user_data)) {
-                        log_message("EXECUTE_AMIGA_PROPER: Line processor returned false, stopping");
-                        goto cleanup;
-                    }
-                    
-                    /* Clear partial line buffer */
-                    partial_line[0] = '\0';
-                }
-            } else {
-                /* Add character to partial line */
-                size_t len = strlen(partial_line);
-                if (len < sizeof(partial_line) - 1) {
-                    partial_line[len] = ch;
-                    partial_line[len + 1] = '\0';
-                }
-            }
+        if (!line_splitter_feed_views(&splitter, buf, (size_t)bytesRead, line_adapter, &adapter)) {
+            log_message("EXECUTE_AMIGA_PROPER: Line processor returned false, stopping");
+            goto cleanup;
         }
     }
+    line_splitter_flush_views(&splitter, line_adapter, &adapter);
     
     log_message("EXECUTE_AMIGA_PROPER: Pipe reading completed, EOF reached");
     
@@ -1049,7 +999,10 @@ cleanup:
         log_message("EXECUTE_AMIGA_PROPER: Pipe closed");
     }
     
-    log_message("EXECUTE_AMIGA_PROPER: Cleanup completed, processed %d lines", line_count);
+    line_splitter_free(&splitter);
+    free(buf);
+    
+    log_message("EXECUTE_AMIGA_PROPER: Cleanup completed, processed %d lines", adapter.line_count);
     return true;
 }
 
@@ -1070,11 +1023,35 @@ static bool execute_command_amiga(const char *cmd, bool (*line_processor)(const
 
 static bool execute_command_host(const char *cmd, bool (*line_processor)(const char *, void *), void *user_data)
 {
-    (void)line_processor; /* Unused parameter in host build */
-    (void)user_data; /* Unused parameter in host build */
+    process_exec_config_t config = {
+        .tool_name = "Command",
+        .pipe_prefix = "cmd_pipe",
+        .timeout_seconds = 30,
+        .silent_mode = false,
+        .strip_escapes = true
+    };
+    line_adapter_t adapter = {line_processor, user_data, "EXECUTE_HOST", 0};
+    controlled_process_t process;
 
-    log_message("ERROR: Host execution not implemented for command: %s", cmd);
-    return false;
+    log_message("EXECUTE_HOST: Command: %s", cmd);
+
+    /* Host builds stream through the POSIX controlled-process backend */
+    bool success = execute_controlled_process_views(cmd, line_adapter, &adapter, &config, &process);
+
+    log_message("EXECUTE_HOST: Finished - success: %s, lines processed: %d",
+               success ? "true" : "false", adapter.line_count);
+
+    /* What the tool itself cost, as opposed to this process */
+    process_usage_t usage;
+    if (get_process_usage(&process, &usage) && usage.cpu_valid) {
+        log_message("EXECUTE_HOST: Child CPU %lu ms user, %lu ms system, peak RSS %lu KB, %lu ms wall",
+                   (unsigned long)(usage.user_cpu_us / 1000),
+                   (unsigned long)(usage.system_cpu_us / 1000),
+                   (unsigned long)usage.max_rss_kb, (unsigned long)usage.wall_ms);
+    }
+
+    cleanup_controlled_process(&process);
+    return success;
 }
 
 #endif
@@ -1092,12 +1069,21 @@ bool cli_list(const char *cmd, uint32_t *out_total)
 
     *out_total = 0;
 
+    /* A plain "lha l <archive>" is answered from the headers, no process needed */
+    char archive_path[LHA_MAX_PATH];
+    uint32_t native_count = 0;
+    if (lha_list_command_archive(cmd, archive_path, sizeof(archive_path)) &&
+        lha_archive_totals(archive_path, out_total, &native_count) && native_count > 0) {
+        log_message("CLI_LIST: Read headers of %s - files: %u, total: %u",
+                   archive_path, native_count, *out_total);
+        return true;
+    }
+
     list_context_t ctx = {0, 0, false};
 
 #ifdef PLATFORM_AMIGA
     bool success = execute_command_amiga(cmd, list_line_processor, &ctx);
 #else
-    /* Host fallback using clock() */
     bool success = execute_command_host(cmd, list_line_processor, &ctx);
 #endif
 
@@ -1182,47 +1168,57 @@ bool cli_extract(const char *cmd, uint32_t total_expected)
     log_message("CLI_EXTRACT: Set last_percentage_x10 = 0");
     ctx.completion_detected = false;
     log_message("CLI_EXTRACT: Set completion_detected = false");
-
-#ifdef PLATFORM_AMIGA
-    /* Use clock() for timing on Amiga for simplicity */
-    clock_t start_time = clock();
-#else
-    /* Host fallback using clock() */
-    clock_t start_time = clock();
+    ctx.current_file[0] = '\0';
+
+    /* Wall time - clock() would only count our own CPU, not the tool's */
+    uint64_t start_ms = plat_monotonic_ms();
+    bool success = false;
+    int native = LHA_EXTRACT_NOT_HANDLED;
+
+#if LHA_NATIVE_EXTRACT
+    /* Decode a plain "lha x" in-process - no process, no pipe, and progress
+     * follows the bytes written rather than jumping a file at a time.
+     * Members are spread over worker threads; the callbacks never overlap. */
+    char archive_path[LHA_MAX_PATH];
+    char dest_path[LHA_MAX_PATH];
+    bool keep_paths;
+    if (lha_extract_command_archive(cmd, archive_path, sizeof(archive_path),
+                                    dest_path, sizeof(dest_path), &keep_paths)) {
+        native = lha_extract_archive_parallel(archive_path, dest_path, keep_paths,
+                                              LHA_EXTRACT_WORKERS, extract_progress, &ctx);
+        log_message("CLI_EXTRACT: In-process extraction of %s: %s", archive_path,
+                    native == LHA_EXTRACT_OK ? "done" :
+                    native == LHA_EXTRACT_FAILED ? "failed" : "left to LhA");
+        success = native == LHA_EXTRACT_OK;
+    }
 #endif
 
+    if (native == LHA_EXTRACT_NOT_HANDLED) {
 #ifdef PLATFORM_AMIGA
-    /* Use the new streaming configuration for safer execution */
-    log_message("CLI_EXTRACT: About to configure Amiga execution");
-    amiga_exec_config_t extract_config = {
-        .tool_name = "LhA",
-        .pipe_prefix = "lha_pipe",
-        .timeout_seconds = 5,  /* Reduced timeout - extraction should be continuous */
-        .silent_mode = false
-    };
-    log_message("CLI_EXTRACT: About to call execute_command_amiga_streaming");
-    log_message("CLI_EXTRACT: Context ptr: %p", (void*)&ctx);
-    log_message("CLI_EXTRACT: Config ptr: %p", (void*)&extract_config);
-    log_message("CLI_EXTRACT: Command string: [%s]", cmd);
-    log_message("CLI_EXTRACT: Line processor function ptr: %p", (void*)extract_line_processor);
-
-    bool success = execute_command_amiga_streaming(cmd, extract_line_processor, &ctx, &extract_config);
-    log_message("CLI_EXTRACT: execute_command_amiga_streaming returned: %s", success ? "true" : "false");
+        /* Use the new streaming configuration for safer execution */
+        log_message("CLI_EXTRACT: About to configure Amiga execution");
+        amiga_exec_config_t extract_config = {
+            .tool_name = "LhA",
+            .pipe_prefix = "lha_pipe",
+            .timeout_seconds = 5,  /* Reduced timeout - extraction should be continuous */
+            .silent_mode = false
+        };
+        log_message("CLI_EXTRACT: About to call execute_command_amiga_streaming");
+        log_message("CLI_EXTRACT: Context ptr: %p", (void*)&ctx);
+        log_message("CLI_EXTRACT: Config ptr: %p", (void*)&extract_config);
+        log_message("CLI_EXTRACT: Command string: [%s]", cmd);
+        log_message("CLI_EXTRACT: Line processor function ptr: %p", (void*)extract_line_processor);
+
+        success = execute_command_amiga_streaming(cmd, extract_line_processor, &ctx, &extract_config);
+        log_message("CLI_EXTRACT: execute_command_amiga_streaming returned: %s", success ? "true" : "false");
 #else
-    log_message("CLI_EXTRACT: About to call execute_command_host");
-    bool success = execute_command_host(cmd, extract_line_processor, &ctx);
-    log_message("CLI_EXTRACT: execute_command_host returned: %s", success ? "true" : "false");
+        log_message("CLI_EXTRACT: About to call execute_command_host");
+        success = execute_command_host(cmd, extract_line_processor, &ctx);
+        log_message("CLI_EXTRACT: execute_command_host returned: %s", success ? "true" : "false");
 #endif
+    }
 
-#ifdef PLATFORM_AMIGA
-    /* Calculate elapsed time using clock() */
-    clock_t end_time = clock();
-    unsigned long elapsed_ticks = (unsigned long)(end_time - start_time);
-#else
-    /* Host fallback */
-    clock_t end_time = clock();
-    unsigned long elapsed_ticks = (unsigned long)(end_time - start_time);
-#endif
+    unsigned long elapsed_ms = (unsigned long)(plat_monotonic_ms() - start_ms);
 
     /* Calculate final percentage using integer math */
     uint32_t final_percentage_x10 = 0;
@@ -1254,11 +1250,7 @@ bool cli_extract(const char *cmd, uint32_t total_expected)
                    (unsigned long)(final_percentage_x10 / 10),
                    (unsigned long)(final_percentage_x10 % 10));
         }
-#ifdef PLATFORM_AMIGA
-        printf("Time elapsed: %lu ticks\n", elapsed_ticks);
-#else
-        printf("Time elapsed: %lu ticks\n", elapsed_ticks);
-#endif
+        printf("Time elapsed: %lu ms\n", elapsed_ms);
     } else {
         printf("\nExtraction failed!\n");
         fflush(stdout);
@@ -1379,7 +1371,7 @@ bool unzip_extract(const char *cmd, uint32_t total_expected)
     printf("NOTE: Progress will be displayed as files are extracted\n");
     fflush(stdout);
 
-    extract_context_t ctx = {total_expected, 0, 0, 0, false};
+    extract_context_t ctx = {total_expected, 0, 0, 0, false, ""};
 
 #ifdef PLATFORM_AMIGA
     /* Configure for unzip */
@@ -1439,46 +1431,3 @@ bool unzip_extract(const char *cmd, uint32_t total_expected)
 
     return operation_success;
 }
-
-/* Strip ANSI escape codes from a string for cleaner parsing */
-static void strip_escape_codes(const char *input, char *output, size_t output_size)
-{
-    const char *src = input;
-    char *dst = output;
-    size_t written = 0;
-    
-    if (!input || !output || output_size == 0) {
-        if (output && output_size > 0) {
-            output[0] = '\0';
-        }
-        return;
-    }
-    
-    while (*src && written < output_size - 1) {
-        if (*src == 27 || *src == '\033') { /* ESC character */
-            /* Skip escape sequence */
-            src++; /* Skip ESC */
-            
-            /* Skip CSI sequences like ESC[...m */
-            if (*src == '[') {
-                src++; /* Skip [ */
-                /* Skip until we find a letter (command terminator) */
-                while (*src && (*src < 'A' || *src > 'z')) {
-                    src++;
-                }
-                if (*src) src++; /* Skip the command letter */
-            }
-            /* Skip other escape sequences */
-            else if (*src) {
-                src++;
-            }
-        }
-        else {
-            /* Regular character - copy it */
-            *dst++ = *src++;
-            written++;
-        }
-    }
-    
-    *dst = '\0';
-}
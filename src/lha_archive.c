@@ -0,0 +1,521 @@
+#include "lha_archive.h"
+#include <string.h>
+#include <ctype.h>
+
+/* Fixed part every header level starts with, up to and including byte 21 */
+#define LHA_BASE_PREFIX 22
+
+/* Extended header types used for the member path, mode and time */
+#define LHA_EXT_FILENAME  0x01
+#define LHA_EXT_DIRECTORY 0x02
+#define LHA_EXT_UNIX_MODE 0x50
+#define LHA_EXT_UNIX_TIME 0x54
+
+/* Internal helper functions */
+static uint16_t get16(const uint8_t *p);
+static uint32_t get32(const uint8_t *p);
+static const uint8_t *fetch(lha_archive_t *archive, uint32_t offset, size_t size);
+static bool fail(lha_archive_t *archive, int error);
+static bool parse_level01(lha_archive_t *archive, lha_member_t *member, const uint8_t *h);
+static bool parse_level2(lha_archive_t *archive, lha_member_t *member, const uint8_t *h);
+static bool read_level1_extensions(lha_archive_t *archive, lha_member_t *member,
+                                   uint16_t next_size, const char *base_name,
+                                   uint32_t *out_total);
+static void apply_extension(lha_member_t *member, char *dir, char *name, uint8_t type,
+                            const uint8_t *data, size_t length);
+static void copy_name(char *dst, size_t dst_size, const uint8_t *src, size_t length);
+static void join_path(lha_member_t *member, const char *dir, const char *name);
+static const char *next_token(const char *pos, char *token, size_t token_size,
+                              bool *out_overflow);
+static bool is_lha_program(const char *token);
+
+bool lha_archive_open(lha_archive_t *archive, const char *path)
+{
+    if (!archive) {
+        return false;
+    }
+
+    if (!lha_source_open(&archive->own_source, path, LHA_SOURCE_DEFAULT)) {
+        lha_archive_open_source(archive, NULL);
+        if (path) {
+            archive->error = LHA_ARCHIVE_IO;
+        }
+        return false;
+    }
+
+    return lha_archive_open_source(archive, &archive->own_source);
+}
+
+bool lha_archive_open_source(lha_archive_t *archive, lha_source_t *source)
+{
+    if (!archive) {
+        return false;
+    }
+
+    archive->source = source;
+    /* Needed to tell a cut-off archive from one that ends properly */
+    archive->file_size = source ? source->size : 0;
+    archive->next_offset = 0;
+    archive->member_count = 0;
+    archive->error = LHA_ARCHIVE_OK;
+    archive->window = NULL;
+    archive->window_offset = 0;
+    archive->window_length = 0;
+
+    return source != NULL;
+}
+
+void lha_archive_close(lha_archive_t *archive)
+{
+    if (archive && archive->source) {
+        if (archive->source == &archive->own_source) {
+            lha_source_close(&archive->own_source);
+        }
+        archive->source = NULL;
+    }
+}
+
+bool lha_archive_next(lha_archive_t *archive, lha_member_t *out_member)
+{
+    if (!archive || !archive->source || !out_member || archive->error != LHA_ARCHIVE_OK) {
+        return false;
+    }
+
+    /* A zero byte (or plain end of file) where a header would start ends the archive */
+    if (archive->next_offset >= archive->file_size) {
+        return false;
+    }
+    const uint8_t *h = fetch(archive, archive->next_offset, 1);
+    if (!h || h[0] == 0) {
+        return false;
+    }
+
+    h = fetch(archive, archive->next_offset, LHA_BASE_PREFIX);
+    if (!h) {
+        return false;
+    }
+    if (h[2] != '-' || h[6] != '-') {
+        return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+    }
+
+    memset(out_member, 0, sizeof(*out_member));
+    memcpy(out_member->method, h + 2, 5);
+    out_member->method[5] = '\0';
+    out_member->is_directory = strcmp(out_member->method, "-lhd-") == 0;
+    out_member->compressed_size = get32(h + 7);
+    out_member->original_size = get32(h + 11);
+    out_member->timestamp = get32(h + 15);
+    out_member->attribute = h[19];
+    out_member->level = h[20];
+    out_member->header_offset = archive->next_offset;
+
+    bool parsed;
+    if (out_member->level <= 1) {
+        parsed = parse_level01(archive, out_member, h);
+    } else if (out_member->level == 2) {
+        parsed = parse_level2(archive, out_member, h);
+    } else {
+        return fail(archive, LHA_ARCHIVE_BAD_LEVEL);
+    }
+    if (!parsed) {
+        return false;
+    }
+
+    if (out_member->data_offset > archive->file_size ||
+        out_member->compressed_size > archive->file_size - out_member->data_offset) {
+        return fail(archive, LHA_ARCHIVE_IO);
+    }
+
+    /* Skip the packed data - only its position is recorded */
+    archive->next_offset = out_member->data_offset + out_member->compressed_size;
+    archive->member_count++;
+    return true;
+}
+
+bool lha_archive_totals(const char *path, uint32_t *out_total, uint32_t *out_file_count)
+{
+    lha_archive_t archive;
+    lha_member_t member;
+    uint32_t total = 0;
+    uint32_t file_count = 0;
+
+    if (!out_total || !lha_archive_open(&archive, path)) {
+        return false;
+    }
+
+    while (lha_archive_next(&archive, &member)) {
+        if (!member.is_directory) {
+            total += member.original_size;
+            file_count++;
+        }
+    }
+
+    bool complete = archive.error == LHA_ARCHIVE_OK;
+    lha_archive_close(&archive);
+    if (!complete) {
+        return false;
+    }
+
+    *out_total = total;
+    if (out_file_count) {
+        *out_file_count = file_count;
+    }
+    return true;
+}
+
+bool lha_list_command_archive(const char *cmd, char *path, size_t path_size)
+{
+    char token[LHA_MAX_PATH];
+    const char *pos = cmd;
+    bool have_command = false;
+    bool have_archive = false;
+    bool overflow = false;
+
+    if (!cmd || !path || path_size == 0) {
+        return false;
+    }
+
+    pos = next_token(pos, token, sizeof(token), &overflow);
+    if (!pos || !is_lha_program(token)) {
+        return false;
+    }
+
+    while ((pos = next_token(pos, token, sizeof(token), &overflow)) != NULL) {
+        if (token[0] == '-') {
+            continue;                 /* Options may appear anywhere */
+        }
+        if (!have_command) {
+            if ((token[0] != 'l' && token[0] != 'v') || token[1] != '\0') {
+                return false;
+            }
+            have_command = true;
+        } else if (!have_archive) {
+            if (strlen(token) >= path_size) {
+                return false;
+            }
+            strcpy(path, token);
+            have_archive = true;
+        } else {
+            return false;             /* File patterns filter the listing */
+        }
+    }
+
+    return have_archive && !overflow;
+}
+
+bool lha_extract_command_archive(const char *cmd, char *path, size_t path_size,
+                                 char *dest, size_t dest_size, bool *out_keep_paths)
+{
+    char token[LHA_MAX_PATH];
+    const char *pos = cmd;
+    char command = '\0';
+    bool have_archive = false;
+    bool have_dest = false;
+    bool overflow = false;
+
+    if (!cmd || !path || path_size == 0 || !dest || dest_size == 0 || !out_keep_paths) {
+        return false;
+    }
+
+    pos = next_token(pos, token, sizeof(token), &overflow);
+    if (!pos || !is_lha_program(token)) {
+        return false;
+    }
+
+    while ((pos = next_token(pos, token, sizeof(token), &overflow)) != NULL) {
+        if (token[0] == '-') {
+            /* Only options that change what LhA prints, not what it writes */
+            if (token[1] == '\0' || token[strspn(token + 1, "mnq") + 1] != '\0') {
+                return false;
+            }
+            continue;
+        }
+        if (command == '\0') {
+            if ((token[0] != 'x' && token[0] != 'e') || token[1] != '\0') {
+                return false;
+            }
+            command = token[0];
+        } else if (!have_archive) {
+            if (strlen(token) >= path_size) {
+                return false;
+            }
+            strcpy(path, token);
+            have_archive = true;
+        } else if (!have_dest) {
+            /* LhA only takes a word ending in a path separator as the
+             * destination; anything else is a file pattern */
+            size_t length = strlen(token);
+            if (length >= dest_size || (token[length - 1] != '/' && token[length - 1] != ':')) {
+                return false;
+            }
+            strcpy(dest, token);
+            have_dest = true;
+        } else {
+            return false;             /* File patterns select members */
+        }
+    }
+
+    if (overflow) {
+        return false;                 /* A word we could not hold - let LhA read it */
+    }
+    if (!have_dest) {
+        dest[0] = '\0';
+    }
+    *out_keep_paths = command == 'x';
+    return have_archive;
+}
+
+/* Internal helper functions */
+
+static uint16_t get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* size bytes at offset, NULL (and LHA_ARCHIVE_IO) if the archive is cut
+ * short. A header and its level 1 extensions usually lie in one window, so
+ * file sources need a single read per member. */
+static const uint8_t *fetch(lha_archive_t *archive, uint32_t offset, size_t size)
+{
+    if (!archive->window || offset < archive->window_offset ||
+        offset - archive->window_offset + size > archive->window_length) {
+        archive->window = NULL;
+        archive->window_offset = offset;
+        archive->window_length = lha_source_read(archive->source, offset, LHA_HEADER_BUFFER,
+                                                 archive->header, sizeof(archive->header),
+                                                 &archive->window);
+        if (archive->window_length < size) {
+            fail(archive, LHA_ARCHIVE_IO);
+            return NULL;
+        }
+    }
+    return archive->window + (offset - archive->window_offset);
+}
+
+static bool fail(lha_archive_t *archive, int error)
+{
+    archive->error = error;
+    return false;
+}
+
+/* Levels 0 and 1: one-byte size and checksum, name in the base header.
+ * Level 1 adds an extension chain between the header and the data. */
+static bool parse_level01(lha_archive_t *archive, lha_member_t *member, const uint8_t *h)
+{
+    size_t total = (size_t)h[0] + 2;
+    size_t name_length = h[21];
+    size_t minimum = LHA_BASE_PREFIX + name_length + 2 + (member->level == 1 ? 3 : 0);
+    size_t i;
+    uint8_t sum = 0;
+    char name[LHA_MAX_PATH];
+
+    if (total < minimum) {
+        return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+    }
+    h = fetch(archive, member->header_offset, total);
+    if (!h) {
+        return false;
+    }
+
+    for (i = 2; i < total; i++) {
+        sum = (uint8_t)(sum + h[i]);
+    }
+    if (sum != h[1]) {
+        return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+    }
+
+    /* Amiga LhA keeps the filenote after a NUL in the name field */
+    copy_name(name, sizeof(name), h + LHA_BASE_PREFIX, name_length);
+    member->crc = get16(h + LHA_BASE_PREFIX + name_length);
+    member->data_offset = member->header_offset + (uint32_t)total;
+
+    if (member->level == 0) {
+        if (total > minimum) {
+            member->os_id = h[LHA_BASE_PREFIX + name_length + 2];
+        }
+        join_path(member, "", name);
+        return true;
+    }
+
+    /* Level 1: compressed_size so far is the skip size, extensions included */
+    uint32_t extension_bytes = 0;
+    member->os_id = h[LHA_BASE_PREFIX + name_length + 2];
+    /* Extensions may be read into the buffer h points at; it is not used after this */
+    uint16_t next_size = get16(h + total - 2);
+    if (!read_level1_extensions(archive, member, next_size, name, &extension_bytes)) {
+        return false;
+    }
+    if (extension_bytes > member->compressed_size) {
+        return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+    }
+
+    member->compressed_size -= extension_bytes;
+    member->data_offset += extension_bytes;
+    return true;
+}
+
+/* Extensions follow the base header one by one, each ending in the size
+ * of the next. Names found there replace the one in the base header. */
+static bool read_level1_extensions(lha_archive_t *archive, lha_member_t *member,
+                                   uint16_t next_size, const char *base_name,
+                                   uint32_t *out_total)
+{
+    uint32_t offset = member->data_offset;
+    char dir[LHA_MAX_PATH] = "";
+    char name[LHA_MAX_PATH];
+
+    strcpy(name, base_name);
+
+    while (next_size > 0) {
+        if (next_size < 3 || next_size > LHA_HEADER_BUFFER) {
+            return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+        }
+        const uint8_t *h = fetch(archive, offset, next_size);
+        if (!h) {
+            return false;
+        }
+        offset += next_size;
+        *out_total += next_size;
+
+        apply_extension(member, dir, name, h[0], h + 1, (size_t)next_size - 3);
+        next_size = get16(h + next_size - 2);
+    }
+
+    join_path(member, dir, name);
+    return true;
+}
+
+/* Level 2: two-byte size covering the whole header, extensions included;
+ * names only ever come from extensions */
+static bool parse_level2(lha_archive_t *archive, lha_member_t *member, const uint8_t *h)
+{
+    size_t total = get16(h);
+    size_t pos = 26;
+    char dir[LHA_MAX_PATH] = "";
+    char name[LHA_MAX_PATH] = "";
+
+    if (total < pos || total > LHA_HEADER_BUFFER) {
+        return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+    }
+    h = fetch(archive, member->header_offset, total);
+    if (!h) {
+        return false;
+    }
+
+    member->attribute = 0;
+    member->unix_time = true;
+    member->crc = get16(h + 21);
+    member->os_id = h[23];
+    member->data_offset = member->header_offset + (uint32_t)total;
+
+    size_t size = get16(h + 24);
+    while (size > 0) {
+        if (size < 3 || pos + size > total) {
+            return fail(archive, LHA_ARCHIVE_BAD_HEADER);
+        }
+        apply_extension(member, dir, name, h[pos], h + pos + 1, size - 3);
+        pos += size;
+        size = get16(h + pos - 2);
+    }
+
+    join_path(member, dir, name);
+    return true;
+}
+
+/* dir and name are LHA_MAX_PATH buffers; Unix mode and time go into the
+ * member for extraction, other types (comments, owners) are skipped */
+static void apply_extension(lha_member_t *member, char *dir, char *name, uint8_t type,
+                            const uint8_t *data, size_t length)
+{
+    if (type == LHA_EXT_FILENAME) {
+        copy_name(name, LHA_MAX_PATH, data, length);
+    } else if (type == LHA_EXT_DIRECTORY) {
+        /* Components are separated (and usually ended) by 0xFF */
+        copy_name(dir, LHA_MAX_PATH, data, length);
+    } else if (type == LHA_EXT_UNIX_MODE && length >= 2) {
+        member->unix_mode = get16(data);
+    } else if (type == LHA_EXT_UNIX_TIME && length >= 4) {
+        member->timestamp = get32(data);
+        member->unix_time = true;
+    }
+}
+
+static void copy_name(char *dst, size_t dst_size, const uint8_t *src, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length && i < dst_size - 1 && src[i] != '\0'; i++) {
+        /* MS-DOS archivers store backslashes, some store 0xFF */
+        dst[i] = (src[i] == '\\' || src[i] == 0xFF) ? '/' : (char)src[i];
+    }
+    dst[i] = '\0';
+}
+
+static void join_path(lha_member_t *member, const char *dir, const char *name)
+{
+    size_t dir_length = strlen(dir);
+    size_t used = 0;
+
+    if (dir_length > 0) {
+        used = dir_length < LHA_MAX_PATH - 1 ? dir_length : LHA_MAX_PATH - 1;
+        memcpy(member->path, dir, used);
+        if (member->path[used - 1] != '/' && name[0] != '\0' && used < LHA_MAX_PATH - 1) {
+            member->path[used++] = '/';
+        }
+    }
+
+    size_t name_length = strlen(name);
+    if (name_length > LHA_MAX_PATH - 1 - used) {
+        name_length = LHA_MAX_PATH - 1 - used;
+    }
+    memcpy(member->path + used, name, name_length);
+    member->path[used + name_length] = '\0';
+}
+
+/* Whitespace-separated token, double quotes group; NULL when none is left,
+ * or when the token does not fit, which also sets *out_overflow */
+static const char *next_token(const char *pos, char *token, size_t token_size,
+                              bool *out_overflow)
+{
+    size_t length = 0;
+    bool quoted = false;
+
+    while (*pos == ' ' || *pos == '\t') {
+        pos++;
+    }
+    if (*pos == '\0') {
+        return NULL;
+    }
+
+    while (*pos != '\0' && (quoted || (*pos != ' ' && *pos != '\t'))) {
+        if (*pos == '"') {
+            quoted = !quoted;
+        } else if (length < token_size - 1) {
+            token[length++] = *pos;
+        } else {
+            *out_overflow = true;
+            return NULL;
+        }
+        pos++;
+    }
+    token[length] = '\0';
+    return pos;
+}
+
+/* Program name: "lha", "LhA", "C:LhA", "/usr/bin/lha", "lha.exe" - but not
+ * "lhasa" or "lharc", which take other options */
+static bool is_lha_program(const char *token)
+{
+    const char *base = token + strlen(token);
+
+    while (base > token && base[-1] != '/' && base[-1] != ':') {
+        base--;
+    }
+    return tolower((unsigned char)base[0]) == 'l' && tolower((unsigned char)base[1]) == 'h' &&
+           tolower((unsigned char)base[2]) == 'a' && (base[3] == '\0' || base[3] == '.');
+}
@@ -0,0 +1,174 @@
+#ifndef LHA_ARCHIVE_H
+#define LHA_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "lha_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest member path kept, including the terminating NUL; longer paths
+ * are truncated */
+#ifndef LHA_MAX_PATH
+#define LHA_MAX_PATH 256
+#endif
+
+/* Largest extended header read whole. Only the name, Unix mode and Unix
+ * time headers are used, and LhA limits a level 2 header to 1024 bytes. */
+#define LHA_HEADER_BUFFER 1024
+
+/* Why lha_archive_next() returned false */
+#define LHA_ARCHIVE_OK        0       /* No error (end of archive) */
+#define LHA_ARCHIVE_IO        1       /* Read failed, or file cut short */
+#define LHA_ARCHIVE_BAD_HEADER 2      /* Header checksum or layout is wrong */
+#define LHA_ARCHIVE_BAD_LEVEL 3       /* Header level other than 0, 1 or 2 */
+
+/**
+ * @brief One member as described by its header
+ *
+ * The compressed data is not read. data_offset and compressed_size say
+ * where it lies, so a decoder can seek straight to it later.
+ */
+typedef struct {
+    char method[6];                   /* Compression method, e.g. "-lh5-" */
+    uint8_t level;                    /* Header level (0, 1 or 2) */
+    uint8_t os_id;                    /* Creating OS ('A' = Amiga, 0 if not stored) */
+    uint8_t attribute;                /* MS-DOS attribute byte (level 0/1) */
+    bool is_directory;                /* Method is "-lhd-" - no data */
+    uint32_t compressed_size;         /* Bytes of packed data */
+    uint32_t original_size;           /* Bytes after extraction */
+    uint32_t timestamp;               /* MS-DOS date/time, or Unix time if unix_time */
+    bool unix_time;                   /* Level 2, or a level 1 Unix time extension */
+    uint16_t unix_mode;               /* Unix permission bits, 0 if not stored */
+    uint16_t crc;                     /* CRC-16 of the original data */
+    uint32_t header_offset;           /* Archive offset of the header */
+    uint32_t data_offset;             /* Archive offset of the packed data */
+    char path[LHA_MAX_PATH];          /* Directory and name, '/' separated */
+} lha_member_t;
+
+/**
+ * @brief Sequential reader over the member headers of an archive
+ *
+ * Each call to lha_archive_next() parses one header (level 0, 1 or 2) and
+ * then steps over the member's packed data, so walking an archive costs
+ * the same whatever its size. With a mapped or memory source headers are
+ * parsed where they lie; file sources read LHA_HEADER_BUFFER bytes into
+ * header at a time, which usually covers a whole header in one read.
+ */
+typedef struct {
+    lha_source_t *source;             /* Archive being walked */
+    lha_source_t own_source;          /* Opened by lha_archive_open() */
+    uint32_t file_size;               /* Bytes in the archive */
+    uint32_t next_offset;             /* Where the next header starts */
+    uint32_t member_count;            /* Headers read so far */
+    int error;                        /* LHA_ARCHIVE_* once next() returned false */
+    const uint8_t *window;            /* Archive bytes last fetched (in the source or header) */
+    uint32_t window_offset;           /* Archive offset of window[0] */
+    uint32_t window_length;           /* Valid bytes at window */
+    uint8_t header[LHA_HEADER_BUFFER]; /* Header bytes read from file sources */
+} lha_archive_t;
+
+/**
+ * @brief Open an archive for reading its member headers
+ *
+ * The file is reached through an LHA_SOURCE_DEFAULT source (mapped where
+ * possible), which lha_archive_close() releases.
+ *
+ * @param archive Reader state to initialize
+ * @param path Archive file name
+ * @return true if the file was opened
+ * @return false if it could not be opened
+ */
+bool lha_archive_open(lha_archive_t *archive, const char *path);
+
+/**
+ * @brief Walk the member headers of an already open source
+ *
+ * The source is borrowed: it must outlive the reader and is not closed by
+ * lha_archive_close(). Used when the same source is also handed to
+ * lha_decode_member().
+ *
+ * @param archive Reader state to initialize
+ * @param source Open archive source
+ * @return true unless source is NULL
+ */
+bool lha_archive_open_source(lha_archive_t *archive, lha_source_t *source);
+
+/**
+ * @brief Read the next member header
+ *
+ * @param archive Reader state
+ * @param out_member Receives the member's header fields
+ * @return true if a member was read
+ * @return false at the end of the archive (error == LHA_ARCHIVE_OK) or on
+ *         a damaged or unsupported header (error says which)
+ */
+bool lha_archive_next(lha_archive_t *archive, lha_member_t *out_member);
+
+/**
+ * @brief Close the archive file, if the reader opened it
+ *
+ * Safe to call on a reader that failed to open.
+ */
+void lha_archive_close(lha_archive_t *archive);
+
+/**
+ * @brief Total size and file count of an archive, read from its headers
+ *
+ * Directory entries are not counted. This is what "lha l" prints on its
+ * last line, without starting a process or parsing text.
+ *
+ * @param path Archive file name
+ * @param out_total Receives the sum of the original sizes
+ * @param out_file_count Receives the number of files (can be NULL)
+ * @return true if every header was read up to the end mark
+ * @return false if the archive could not be opened or a header is damaged
+ */
+bool lha_archive_totals(const char *path, uint32_t *out_total, uint32_t *out_file_count);
+
+/**
+ * @brief Find the archive in a plain "lha l <archive>" command
+ *
+ * Recognises "lha l" and "lha v" (a program called "lha" in any case and
+ * directory, with or without an extension; any options) with exactly one
+ * archive and no file patterns, which is the case lha_archive_totals()
+ * can answer in-process. The archive name may be in double quotes.
+ *
+ * @param cmd Command line as it would be passed to the shell
+ * @param path Receives the archive name
+ * @param path_size Size of path in bytes
+ * @return true if cmd is such a list command
+ * @return false for any other command
+ */
+bool lha_list_command_archive(const char *cmd, char *path, size_t path_size);
+
+/**
+ * @brief Find the archive and destination in a plain "lha x" command
+ *
+ * Recognises "lha x <archive> [dest]" and "lha e <archive> [dest]" with
+ * only the -m, -n and -q options, which is what lha_extract_archive() can
+ * do in-process. Like LhA, a word after the archive is the destination
+ * only when it ends in '/' or ':'. Options that change what is written,
+ * and file patterns, are left to the tool.
+ *
+ * @param cmd Command line as it would be passed to the shell
+ * @param path Receives the archive name
+ * @param path_size Size of path in bytes
+ * @param dest Receives the destination ("" when none is given)
+ * @param dest_size Size of dest in bytes
+ * @param out_keep_paths Receives true for "x", false for "e" (no directories)
+ * @return true if cmd is such an extract command
+ * @return false for any other command
+ */
+bool lha_extract_command_archive(const char *cmd, char *path, size_t path_size,
+                                 char *dest, size_t dest_size, bool *out_keep_paths);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LHA_ARCHIVE_H */
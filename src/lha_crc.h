@@ -0,0 +1,31 @@
+#ifndef LHA_CRC_H
+#define LHA_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Continue the CRC-16 LHA stores for each member
+ *
+ * Reflected polynomial 0xA001 (CRC-16/ARC), starting from 0. Eight bytes
+ * are folded in per step using eight lookup tables ("slice-by-8"), which
+ * is several times faster than a byte at a time on large members. Bytes
+ * are loaded one by one, so data needs no alignment and the result does
+ * not depend on byte order.
+ *
+ * @param crc CRC of the data so far (0 to start)
+ * @param data Next bytes
+ * @param length Number of bytes
+ * @return CRC including data
+ */
+uint16_t lha_crc16_update(uint16_t crc, const uint8_t *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LHA_CRC_H */
@@ -0,0 +1,555 @@
+#include "lha_decode.h"
+#include "lha_crc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Static Huffman coding shared by -lh4- to -lh7- (LHa's "st1" decoder) */
+#define LHA_NC      510               /* Literals, then match lengths 3..256 */
+#define LHA_NT      19                /* Code length codes */
+#define LHA_NP_MAX  17                /* Distance codes for -lh7- */
+#define LHA_TBIT    5                 /* Bits holding the code length code count */
+#define LHA_CBIT    9                 /* Bits holding the literal/length code count */
+#define LHA_PT_SIZE LHA_NT            /* Larger of LHA_NT and LHA_NP_MAX */
+#define LHA_MAX_CODE 16               /* Longest Huffman code allowed */
+
+/* Direct lookup widths; longer codes continue in the left/right tree */
+#define LHA_C_TABLE_BITS  12
+#define LHA_PT_TABLE_BITS 8
+
+/* Shortest match; literal/length code 256 means a match of this length */
+#define LHA_MIN_MATCH 3
+
+/* One ring buffer fits every method (-lh7- uses the whole 64 KB); it is
+ * also the largest piece handed to the output callback. */
+#define LHA_WINDOW_SIZE 65536
+
+/* Packed bytes read at a time from file sources; mapped and memory
+ * sources hand over the whole packed range instead */
+#define LHA_INPUT_CHUNK 4096
+
+/* The bit reader runs a few bytes ahead of the symbol being decoded, so a
+ * valid stream can read slightly past the end. More than this is damage. */
+#define LHA_MAX_OVERRUN 8
+
+/* Decoder state, allocated per call so members can be decoded in parallel */
+typedef struct {
+    lha_source_t *source;
+    uint32_t next_offset;             /* Archive offset of the next packed byte to fetch */
+    uint32_t packed_left;             /* Packed bytes not yet fetched */
+    uint32_t overrun;                 /* Zero bytes supplied past the end */
+    bool io_error;
+    const uint8_t *input;             /* Fetched packed bytes (in the archive or in buffer) */
+    size_t input_pos;
+    size_t input_len;
+    uint8_t buffer[LHA_INPUT_CHUNK];  /* Input for file sources */
+    uint32_t bits;                    /* Bit buffer, next bit is the highest valid one */
+    int bit_count;                    /* Valid bits in bits */
+
+    int np;                           /* Distance codes for this method */
+    int pbit;                         /* Bits holding the distance code count */
+    uint32_t block_left;              /* Symbols left in the current block */
+    uint8_t c_len[LHA_NC];
+    uint8_t pt_len[LHA_PT_SIZE];
+    uint16_t c_table[1 << LHA_C_TABLE_BITS];
+    uint16_t pt_table[1 << LHA_PT_TABLE_BITS];
+    uint16_t left[2 * LHA_NC - 1];
+    uint16_t right[2 * LHA_NC - 1];
+
+    uint8_t window[LHA_WINDOW_SIZE];
+    uint16_t crc;
+    lha_output_t output;
+    void *user_data;
+} lha_decoder_t;
+
+/* Internal helper functions */
+static int dictionary_bits(const char *method);
+static uint8_t next_byte(lha_decoder_t *d);
+static void fill_bits(lha_decoder_t *d);
+static uint32_t peek_bits(lha_decoder_t *d, int count);
+static void skip_bits(lha_decoder_t *d, int count);
+static uint32_t get_bits(lha_decoder_t *d, int count);
+static bool make_table(lha_decoder_t *d, int nchar, const uint8_t *bitlen,
+                       int table_bits, uint16_t *table);
+static bool read_pt_len(lha_decoder_t *d, int nn, int nbit, int i_special);
+static bool read_c_len(lha_decoder_t *d);
+static int walk_tree(lha_decoder_t *d, int symbol, int limit, uint32_t mask);
+static int decode_c(lha_decoder_t *d);
+static int decode_p(lha_decoder_t *d);
+static size_t fetch_input(lha_decoder_t *d, uint32_t limit);
+static bool emit(lha_decoder_t *d, const uint8_t *data, size_t length);
+static int decode_stored(lha_decoder_t *d, const lha_member_t *member);
+static int decode_huffman(lha_decoder_t *d, const lha_member_t *member, int dicbit);
+
+bool lha_decode_supported(const char *method)
+{
+    if (!method) {
+        return false;
+    }
+    return strcmp(method, "-lh0-") == 0 || strcmp(method, "-lz4-") == 0 ||
+           strcmp(method, "-lhd-") == 0 || dictionary_bits(method) > 0;
+}
+
+int lha_decode_member(lha_source_t *archive, const lha_member_t *member,
+                      lha_output_t output, void *user_data)
+{
+    if (!archive || !member) {
+        return LHA_DECODE_IO;
+    }
+    if (!lha_decode_supported(member->method)) {
+        return LHA_DECODE_UNSUPPORTED;
+    }
+    if (member->is_directory) {
+        return LHA_DECODE_OK;
+    }
+
+    lha_decoder_t *d = (lha_decoder_t *)malloc(sizeof(lha_decoder_t));
+    if (!d) {
+        return LHA_DECODE_NO_MEMORY;
+    }
+    d->source = archive;
+    d->next_offset = member->data_offset;
+    d->packed_left = member->compressed_size;
+    d->overrun = 0;
+    d->io_error = false;
+    d->input = NULL;
+    d->input_pos = 0;
+    d->input_len = 0;
+    d->bits = 0;
+    d->bit_count = 0;
+    d->block_left = 0;
+    d->crc = 0;
+    d->output = output;
+    d->user_data = user_data;
+
+    int dicbit = dictionary_bits(member->method);
+    int result = dicbit > 0 ? decode_huffman(d, member, dicbit) : decode_stored(d, member);
+
+    if (result == LHA_DECODE_OK && d->crc != member->crc) {
+        result = LHA_DECODE_BAD_CRC;
+    }
+    free(d);
+    return result;
+}
+
+const char *lha_decode_error_string(int error)
+{
+    switch (error) {
+    case LHA_DECODE_OK:          return "OK";
+    case LHA_DECODE_IO:          return "read error";
+    case LHA_DECODE_BAD_DATA:    return "damaged data";
+    case LHA_DECODE_BAD_CRC:     return "CRC mismatch";
+    case LHA_DECODE_UNSUPPORTED: return "unsupported method";
+    case LHA_DECODE_NO_MEMORY:   return "out of memory";
+    case LHA_DECODE_STOPPED:     return "stopped";
+    default:                     return "unknown error";
+    }
+}
+
+/* Dictionary size (as a power of two) of a Huffman method, 0 if not one */
+static int dictionary_bits(const char *method)
+{
+    if (strcmp(method, "-lh4-") == 0) return 12;
+    if (strcmp(method, "-lh5-") == 0) return 13;
+    if (strcmp(method, "-lh6-") == 0) return 15;
+    if (strcmp(method, "-lh7-") == 0) return 16;
+    return 0;
+}
+
+static uint8_t next_byte(lha_decoder_t *d)
+{
+    if (d->input_pos == d->input_len) {
+        if (d->packed_left == 0) {
+            d->overrun++;
+            return 0;
+        }
+        if (fetch_input(d, d->packed_left) == 0) {
+            d->io_error = true;
+            d->packed_left = 0;
+            return 0;
+        }
+    }
+    return d->input[d->input_pos++];
+}
+
+/* Make up to limit more packed bytes available at d->input; 0 on error */
+static size_t fetch_input(lha_decoder_t *d, uint32_t limit)
+{
+    uint32_t got = lha_source_read(d->source, d->next_offset, limit,
+                                   d->buffer, sizeof(d->buffer), &d->input);
+    d->next_offset += got;
+    d->packed_left -= got;
+    d->input_len = got;
+    d->input_pos = 0;
+    return got;
+}
+
+/* Keep at least 25 bits buffered so any code (16 bits max) can be peeked */
+static void fill_bits(lha_decoder_t *d)
+{
+    while (d->bit_count <= 24) {
+        d->bits = (d->bits << 8) | next_byte(d);
+        d->bit_count += 8;
+    }
+}
+
+static uint32_t peek_bits(lha_decoder_t *d, int count)
+{
+    return (d->bits >> (d->bit_count - count)) & ((1u << count) - 1);
+}
+
+static void skip_bits(lha_decoder_t *d, int count)
+{
+    d->bit_count -= count;
+    fill_bits(d);
+}
+
+static uint32_t get_bits(lha_decoder_t *d, int count)
+{
+    uint32_t value = peek_bits(d, count);
+
+    skip_bits(d, count);
+    return value;
+}
+
+/*
+ * Build the lookup table for canonical codes of the given lengths. Codes up
+ * to table_bits long are resolved by one lookup; longer ones get a chain of
+ * left/right tree nodes numbered from nchar upwards.
+ */
+static bool make_table(lha_decoder_t *d, int nchar, const uint8_t *bitlen,
+                       int table_bits, uint16_t *table)
+{
+    uint32_t count[LHA_MAX_CODE + 1];
+    uint32_t weight[LHA_MAX_CODE + 1];
+    uint32_t start[LHA_MAX_CODE + 2];
+    int jut_bits = LHA_MAX_CODE - table_bits;
+    int i;
+
+    for (i = 1; i <= LHA_MAX_CODE; i++) {
+        count[i] = 0;
+    }
+    for (i = 0; i < nchar; i++) {
+        if (bitlen[i] > LHA_MAX_CODE) {
+            return false;
+        }
+        count[bitlen[i]]++;
+    }
+
+    start[1] = 0;
+    for (i = 1; i <= LHA_MAX_CODE; i++) {
+        start[i + 1] = start[i] + (count[i] << (LHA_MAX_CODE - i));
+    }
+    /* The code must be complete, or lookups could land on nothing */
+    if (start[LHA_MAX_CODE + 1] != (1u << LHA_MAX_CODE)) {
+        return false;
+    }
+
+    for (i = 1; i <= table_bits; i++) {
+        start[i] >>= jut_bits;
+        weight[i] = 1u << (table_bits - i);
+    }
+    for (; i <= LHA_MAX_CODE; i++) {
+        weight[i] = 1u << (LHA_MAX_CODE - i);
+    }
+
+    /* Entries for long codes start empty; tree nodes are added below */
+    uint32_t table_size = 1u << table_bits;
+    for (uint32_t k = start[table_bits + 1] >> jut_bits; k < table_size; k++) {
+        table[k] = 0;
+    }
+
+    uint32_t avail = (uint32_t)nchar;
+    uint32_t mask = 1u << (LHA_MAX_CODE - 1 - table_bits);
+    for (int ch = 0; ch < nchar; ch++) {
+        int len = bitlen[ch];
+        if (len == 0) {
+            continue;
+        }
+        uint32_t next_code = start[len] + weight[len];
+        if (len <= table_bits) {
+            for (uint32_t k = start[len]; k < next_code; k++) {
+                table[k] = (uint16_t)ch;
+            }
+        } else {
+            uint32_t k = start[len];
+            uint16_t *p = &table[k >> jut_bits];
+            for (i = len - table_bits; i > 0; i--) {
+                if (*p == 0) {
+                    d->left[avail] = 0;
+                    d->right[avail] = 0;
+                    *p = (uint16_t)avail++;
+                }
+                p = (k & mask) ? &d->right[*p] : &d->left[*p];
+                k <<= 1;
+            }
+            *p = (uint16_t)ch;
+        }
+        start[len] = next_code;
+    }
+    return true;
+}
+
+/* Code lengths for the code length codes (NT) or the distance codes (NP) */
+static bool read_pt_len(lha_decoder_t *d, int nn, int nbit, int i_special)
+{
+    int n = (int)get_bits(d, nbit);
+    int i;
+
+    if (n == 0) {
+        /* Only one symbol: every lookup yields it and it costs no bits */
+        int c = (int)get_bits(d, nbit);
+        if (c >= nn) {
+            return false;
+        }
+        memset(d->pt_len, 0, sizeof(d->pt_len));
+        for (i = 0; i < (1 << LHA_PT_TABLE_BITS); i++) {
+            d->pt_table[i] = (uint16_t)c;
+        }
+        return true;
+    }
+    if (n > nn) {
+        return false;
+    }
+
+    i = 0;
+    while (i < n) {
+        int c = (int)peek_bits(d, 3);
+        if (c == 7) {
+            /* 7 is followed by a run of 1 bits, each adding one */
+            uint32_t window = peek_bits(d, 16);
+            uint32_t mask = 1u << 12;
+            while (mask && (window & mask)) {
+                mask >>= 1;
+                c++;
+            }
+            if (c > LHA_MAX_CODE) {
+                return false;
+            }
+            skip_bits(d, c - 3);
+        } else {
+            skip_bits(d, 3);
+        }
+        d->pt_len[i++] = (uint8_t)c;
+
+        if (i == i_special) {
+            /* The NT table may skip up to three unused lengths here */
+            int zeros = (int)get_bits(d, 2);
+            while (zeros-- > 0 && i < nn) {
+                d->pt_len[i++] = 0;
+            }
+        }
+    }
+    while (i < nn) {
+        d->pt_len[i++] = 0;
+    }
+    return make_table(d, nn, d->pt_len, LHA_PT_TABLE_BITS, d->pt_table);
+}
+
+/* Literal/length code lengths, themselves coded with the NT table */
+static bool read_c_len(lha_decoder_t *d)
+{
+    int n = (int)get_bits(d, LHA_CBIT);
+    int i;
+
+    if (n == 0) {
+        int c = (int)get_bits(d, LHA_CBIT);
+        if (c >= LHA_NC) {
+            return false;
+        }
+        memset(d->c_len, 0, sizeof(d->c_len));
+        for (i = 0; i < (1 << LHA_C_TABLE_BITS); i++) {
+            d->c_table[i] = (uint16_t)c;
+        }
+        return true;
+    }
+    if (n > LHA_NC) {
+        return false;
+    }
+
+    i = 0;
+    while (i < n) {
+        int c = d->pt_table[peek_bits(d, LHA_PT_TABLE_BITS)];
+        if (c >= LHA_NT) {
+            c = walk_tree(d, c, LHA_NT, 1u << (15 - LHA_PT_TABLE_BITS));
+            if (c < 0) {
+                return false;
+            }
+        }
+        skip_bits(d, d->pt_len[c]);
+
+        if (c <= 2) {
+            /* 0, 1 and 2 are runs of unused symbols of increasing length */
+            int run;
+            if (c == 0) {
+                run = 1;
+            } else if (c == 1) {
+                run = (int)get_bits(d, 4) + 3;
+            } else {
+                run = (int)get_bits(d, LHA_CBIT) + 20;
+            }
+            if (i + run > LHA_NC) {
+                return false;
+            }
+            while (run-- > 0) {
+                d->c_len[i++] = 0;
+            }
+        } else {
+            d->c_len[i++] = (uint8_t)(c - 2);
+        }
+    }
+    while (i < LHA_NC) {
+        d->c_len[i++] = 0;
+    }
+    return make_table(d, LHA_NC, d->c_len, LHA_C_TABLE_BITS, d->c_table);
+}
+
+/* Follow a code longer than its lookup table down the tree; -1 if it ends nowhere */
+static int walk_tree(lha_decoder_t *d, int symbol, int limit, uint32_t mask)
+{
+    uint32_t window = peek_bits(d, 16);
+
+    while (symbol >= limit && mask) {
+        symbol = (window & mask) ? d->right[symbol] : d->left[symbol];
+        mask >>= 1;
+    }
+    return symbol >= limit ? -1 : symbol;
+}
+
+/* Next literal (0-255) or match length code (256+), -1 on damaged data */
+static int decode_c(lha_decoder_t *d)
+{
+    if (d->block_left == 0) {
+        d->block_left = get_bits(d, 16);
+        if (d->block_left == 0 ||
+            !read_pt_len(d, LHA_NT, LHA_TBIT, 3) ||
+            !read_c_len(d) ||
+            !read_pt_len(d, d->np, d->pbit, -1)) {
+            return -1;
+        }
+    }
+    d->block_left--;
+
+    int c = d->c_table[peek_bits(d, LHA_C_TABLE_BITS)];
+    if (c >= LHA_NC) {
+        c = walk_tree(d, c, LHA_NC, 1u << (15 - LHA_C_TABLE_BITS));
+        if (c < 0) {
+            return -1;
+        }
+    }
+    skip_bits(d, d->c_len[c]);
+    return c;
+}
+
+/* Match distance minus one, -1 on damaged data */
+static int decode_p(lha_decoder_t *d)
+{
+    int p = d->pt_table[peek_bits(d, LHA_PT_TABLE_BITS)];
+    if (p >= d->np) {
+        p = walk_tree(d, p, d->np, 1u << (15 - LHA_PT_TABLE_BITS));
+        if (p < 0) {
+            return -1;
+        }
+    }
+    skip_bits(d, d->pt_len[p]);
+
+    /* Code p stands for p - 1 further bits above an implied leading 1 */
+    if (p > 1) {
+        p = (int)((1u << (p - 1)) + get_bits(d, p - 1));
+    }
+    return p;
+}
+
+static bool emit(lha_decoder_t *d, const uint8_t *data, size_t length)
+{
+    d->crc = lha_crc16_update(d->crc, data, length);
+    return !d->output || d->output(data, length, d->user_data);
+}
+
+static int decode_stored(lha_decoder_t *d, const lha_member_t *member)
+{
+    if (member->compressed_size != member->original_size) {
+        return LHA_DECODE_BAD_DATA;
+    }
+
+    /* Mapped data goes to the output as it lies, a window's worth at a time */
+    while (d->packed_left > 0) {
+        size_t got = fetch_input(d, d->packed_left < LHA_WINDOW_SIZE ? d->packed_left
+                                                                     : LHA_WINDOW_SIZE);
+        if (got == 0) {
+            return LHA_DECODE_IO;
+        }
+        if (!emit(d, d->input, got)) {
+            return LHA_DECODE_STOPPED;
+        }
+    }
+    return LHA_DECODE_OK;
+}
+
+static int decode_huffman(lha_decoder_t *d, const lha_member_t *member, int dicbit)
+{
+    uint32_t remaining = member->original_size;
+    uint32_t pos = 0;
+
+    if (dicbit <= 13) {
+        d->np = 14;                   /* -lh4- uses the -lh5- distance codes */
+        d->pbit = 4;
+    } else {
+        d->np = dicbit + 1;
+        d->pbit = 5;
+    }
+
+    /* LHa starts with a dictionary of spaces, and encoders may refer to it */
+    memset(d->window, ' ', sizeof(d->window));
+    fill_bits(d);
+
+    while (remaining > 0) {
+        int c = decode_c(d);
+        if (c < 0) {
+            return d->io_error ? LHA_DECODE_IO : LHA_DECODE_BAD_DATA;
+        }
+
+        if (c < 256) {
+            d->window[pos++] = (uint8_t)c;
+            remaining--;
+            if (pos == LHA_WINDOW_SIZE) {
+                if (!emit(d, d->window, pos)) {
+                    return LHA_DECODE_STOPPED;
+                }
+                pos = 0;
+            }
+        } else {
+            int p = decode_p(d);
+            if (p < 0) {
+                return d->io_error ? LHA_DECODE_IO : LHA_DECODE_BAD_DATA;
+            }
+            uint32_t length = (uint32_t)(c - 256 + LHA_MIN_MATCH);
+            uint32_t from = (pos - (uint32_t)p - 1) & (LHA_WINDOW_SIZE - 1);
+            if (length > remaining) {
+                length = remaining;   /* LHa stops at the original size too */
+            }
+            remaining -= length;
+            while (length-- > 0) {
+                d->window[pos++] = d->window[from];
+                from = (from + 1) & (LHA_WINDOW_SIZE - 1);
+                if (pos == LHA_WINDOW_SIZE) {
+                    if (!emit(d, d->window, pos)) {
+                        return LHA_DECODE_STOPPED;
+                    }
+                    pos = 0;
+                }
+            }
+        }
+
+        if (d->io_error) {
+            return LHA_DECODE_IO;
+        }
+        if (d->overrun > LHA_MAX_OVERRUN) {
+            return LHA_DECODE_BAD_DATA;
+        }
+    }
+
+    if (pos > 0 && !emit(d, d->window, pos)) {
+        return LHA_DECODE_STOPPED;
+    }
+    return LHA_DECODE_OK;
+}
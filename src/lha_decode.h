@@ -0,0 +1,69 @@
+#ifndef LHA_DECODE_H
+#define LHA_DECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "lha_archive.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Why lha_decode_member() failed */
+#define LHA_DECODE_OK          0      /* Member decoded and its CRC matched */
+#define LHA_DECODE_IO          1      /* Archive could not be read */
+#define LHA_DECODE_BAD_DATA    2      /* Packed data is not a valid stream */
+#define LHA_DECODE_BAD_CRC     3      /* Decoded, but the CRC-16 does not match */
+#define LHA_DECODE_UNSUPPORTED 4      /* Method not handled (e.g. -lh1-) */
+#define LHA_DECODE_NO_MEMORY   5      /* Decoder state could not be allocated */
+#define LHA_DECODE_STOPPED     6      /* Output callback asked to stop */
+
+/**
+ * @brief Receives decoded bytes in order
+ *
+ * data is only valid during the call. Return false to stop decoding.
+ */
+typedef bool (*lha_output_t)(const uint8_t *data, size_t length, void *user_data);
+
+/**
+ * @brief Whether lha_decode_member() handles a compression method
+ *
+ * Stored members (-lh0-, -lz4-), directories (-lhd-) and the static
+ * Huffman methods -lh4- to -lh7- are supported.
+ */
+bool lha_decode_supported(const char *method);
+
+/**
+ * @brief Decode one member and check its CRC
+ *
+ * Reads the member's packed data from archive at member->data_offset and
+ * hands the original bytes to output as the sliding dictionary fills (up
+ * to 64 KB at a time), so nothing is held beyond the dictionary. The
+ * CRC-16 of the output is compared with the one in the header. With a
+ * mapped or memory source the packed data is read where it lies, and
+ * stored members reach output without being copied.
+ *
+ * Each call allocates its own state, so several members may be decoded
+ * at once from different threads sharing one host source.
+ *
+ * @param archive Open archive source
+ * @param member Header from lha_archive_next()
+ * @param output Receives the decoded bytes (NULL = discard them)
+ * @param user_data Passed to output
+ * @return LHA_DECODE_OK or one of the LHA_DECODE_* errors
+ */
+int lha_decode_member(lha_source_t *archive, const lha_member_t *member,
+                      lha_output_t output, void *user_data);
+
+/**
+ * @brief Short description of an LHA_DECODE_* code for logs
+ */
+const char *lha_decode_error_string(int error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LHA_DECODE_H */
@@ -0,0 +1,623 @@
+#include "lha_extract.h"
+#include "lha_decode.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef PLATFORM_AMIGA
+#include <dos/dos.h>
+#include <proto/dos.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <utime.h>
+#endif
+
+/* Longest output file name: destination, separator and member path */
+#define LHA_EXTRACT_PATH_MAX (2 * LHA_MAX_PATH)
+
+/* Initial size of the member list; it doubles as needed */
+#define LHA_EXTRACT_INITIAL_MEMBERS 64
+
+/* One extraction, shared by all workers. Members are handed out in list
+ * order under the lock, and progress callbacks are made under it too, so
+ * the caller's counters need no locking of their own. */
+typedef struct {
+    lha_source_t source;              /* Archive, shared by every worker */
+    const char *dest;
+    bool keep_paths;
+    lha_member_t *members;
+    uint32_t member_count;
+    int *results;                     /* Per member LHA_DECODE_* when testing, else NULL */
+    uint32_t next_member;             /* Next list entry to hand out */
+    bool failed;                      /* Some member could not be extracted */
+    lha_progress_t progress;
+    void *user_data;
+#ifndef PLATFORM_AMIGA
+    bool threaded;                    /* Lock is initialized and needed */
+    pthread_mutex_t lock;
+#endif
+} lha_extract_job_t;
+
+/* Where decoded bytes of one member go */
+typedef struct {
+    FILE *out;
+    const lha_member_t *member;
+    lha_progress_t progress;
+    void *user_data;
+    bool write_failed;
+} lha_write_context_t;
+
+/* Internal helper functions */
+static bool is_safe_path(const char *path);
+static bool build_output_path(char *out, size_t out_size, const char *dest,
+                              const char *path, bool keep_paths);
+static void strip_trailing_slash(char *path);
+static bool make_directory(const char *path);
+static bool make_parents(char *path);
+static bool write_output(const uint8_t *data, size_t length, void *user_data);
+static void restore_attributes(const char *path, const lha_member_t *member);
+static bool extract_member(lha_source_t *archive, const lha_member_t *member, const char *dest,
+                           bool keep_paths, lha_progress_t progress, void *user_data);
+static bool read_members(lha_source_t *source, lha_member_t **out_members,
+                         uint32_t *out_count, int *out_error);
+static bool can_extract(const lha_member_t *members, uint32_t count);
+static int compare_members(const void *a, const void *b);
+static int compare_tested(const void *a, const void *b);
+static const char *output_name(const lha_member_t *member, bool keep_paths);
+static int compare_names(const void *a, const void *b);
+static bool has_duplicate_names(const lha_member_t *members, uint32_t count, bool keep_paths);
+static void job_lock(lha_extract_job_t *job);
+static void job_unlock(lha_extract_job_t *job);
+static void job_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                         void *user_data);
+static void run_job(lha_extract_job_t *job, uint32_t workers);
+static void run_worker(lha_extract_job_t *job);
+#ifndef PLATFORM_AMIGA
+static void *worker_thread(void *arg);
+#endif
+
+int lha_extract_archive(const char *archive_path, const char *dest_dir, bool keep_paths,
+                        lha_progress_t progress, void *user_data)
+{
+    return lha_extract_archive_parallel(archive_path, dest_dir, keep_paths, 1,
+                                        progress, user_data);
+}
+
+int lha_extract_archive_parallel(const char *archive_path, const char *dest_dir,
+                                 bool keep_paths, uint32_t workers,
+                                 lha_progress_t progress, void *user_data)
+{
+    lha_extract_job_t job;
+    const char *dest = dest_dir ? dest_dir : "";
+    int archive_error;
+
+    memset(&job, 0, sizeof(job));
+    if (!lha_source_open(&job.source, archive_path, LHA_SOURCE_DEFAULT)) {
+        return LHA_EXTRACT_NOT_HANDLED;
+    }
+    /* Every header is checked before anything is written, so a fallback
+     * to the tool never finds a half-extracted tree */
+    if (!read_members(&job.source, &job.members, &job.member_count, &archive_error) ||
+        archive_error != LHA_ARCHIVE_OK || !can_extract(job.members, job.member_count)) {
+        free(job.members);
+        lha_source_close(&job.source);
+        return LHA_EXTRACT_NOT_HANDLED;
+    }
+
+    /* LhA creates the destination if it is missing */
+    if (dest[0] != '\0') {
+        char dest_path[LHA_EXTRACT_PATH_MAX];
+        if (strlen(dest) < sizeof(dest_path)) {
+            strcpy(dest_path, dest);
+            strip_trailing_slash(dest_path);
+            if (make_parents(dest_path)) {
+                make_directory(dest_path);
+            }
+        }
+    }
+
+    /* Every member has its own offsets, so order is free: directories
+     * first, then the largest files, so no worker is left with a big one
+     * at the end while the others idle. A name that appears twice must be
+     * written in archive order (the last one wins), so then one worker
+     * goes through the list as it is. */
+    if (has_duplicate_names(job.members, job.member_count, keep_paths)) {
+        workers = 1;
+    } else {
+        qsort(job.members, job.member_count, sizeof(lha_member_t), compare_members);
+    }
+
+    job.dest = dest;
+    job.keep_paths = keep_paths;
+    job.progress = progress;
+    job.user_data = user_data;
+    run_job(&job, workers);
+
+    int result = job.failed ? LHA_EXTRACT_FAILED : LHA_EXTRACT_OK;
+    free(job.members);
+    lha_source_close(&job.source);
+    return result;
+}
+
+int lha_test_archive(const char *archive_path, uint32_t workers, lha_test_report_t *report)
+{
+    lha_extract_job_t job;
+    uint32_t i;
+
+    if (!report) {
+        return LHA_EXTRACT_NOT_HANDLED;
+    }
+    memset(report, 0, sizeof(*report));
+    memset(&job, 0, sizeof(job));
+    if (!lha_source_open(&job.source, archive_path, LHA_SOURCE_DEFAULT)) {
+        return LHA_EXTRACT_NOT_HANDLED;
+    }
+    /* A damaged header ends the walk; the members before it are still tested */
+    if (!read_members(&job.source, &job.members, &job.member_count, &report->archive_error)) {
+        free(job.members);
+        lha_source_close(&job.source);
+        return LHA_EXTRACT_NOT_HANDLED;
+    }
+
+    report->members = (lha_test_member_t *)calloc(job.member_count ? job.member_count : 1,
+                                                  sizeof(lha_test_member_t));
+    job.results = (int *)calloc(job.member_count ? job.member_count : 1, sizeof(int));
+    if (!report->members || !job.results) {
+        free(report->members);
+        report->members = NULL;
+        free(job.results);
+        free(job.members);
+        lha_source_close(&job.source);
+        return LHA_EXTRACT_NOT_HANDLED;
+    }
+
+    /* Nothing is written, so the largest members can always go first */
+    qsort(job.members, job.member_count, sizeof(lha_member_t), compare_members);
+    run_job(&job, workers);
+
+    for (i = 0; i < job.member_count; i++) {
+        report->members[i].member = job.members[i];
+        report->members[i].result = job.results[i];
+        if (job.results[i] != LHA_DECODE_OK) {
+            report->failed_count++;
+        }
+    }
+    report->member_count = job.member_count;
+    qsort(report->members, report->member_count, sizeof(lha_test_member_t), compare_tested);
+
+    free(job.results);
+    free(job.members);
+    lha_source_close(&job.source);
+    return report->failed_count == 0 && report->archive_error == LHA_ARCHIVE_OK
+               ? LHA_EXTRACT_OK
+               : LHA_EXTRACT_FAILED;
+}
+
+void lha_test_report_free(lha_test_report_t *report)
+{
+    if (report) {
+        free(report->members);
+        report->members = NULL;
+        report->member_count = 0;
+    }
+}
+
+/* Internal helper functions */
+
+/* Start the workers and wait for them to empty the member list */
+static void run_job(lha_extract_job_t *job, uint32_t workers)
+{
+    if (workers == 0) {
+        workers = plat_cpu_count();
+    }
+    if (workers > LHA_EXTRACT_MAX_WORKERS) {
+        workers = LHA_EXTRACT_MAX_WORKERS;
+    }
+    if (workers > job->member_count) {
+        workers = job->member_count;
+    }
+
+#ifndef PLATFORM_AMIGA
+    pthread_t threads[LHA_EXTRACT_MAX_WORKERS];
+    uint32_t started = 0;
+
+    if (workers > 1 && pthread_mutex_init(&job->lock, NULL) == 0) {
+        job->threaded = true;
+        while (started < workers &&
+               pthread_create(&threads[started], NULL, worker_thread, job) == 0) {
+            started++;
+        }
+    }
+    /* With no threads (one worker, or none could start) this thread does it all */
+    if (started == 0) {
+        run_worker(job);
+    }
+    while (started > 0) {
+        pthread_join(threads[--started], NULL);
+    }
+    if (job->threaded) {
+        pthread_mutex_destroy(&job->lock);
+    }
+#else
+    (void)workers;
+    run_worker(job);
+#endif
+}
+
+/* Relative and staying below the destination: no device, root or ".." */
+static bool is_safe_path(const char *path)
+{
+    const char *component = path;
+
+    if (path[0] == '\0' || path[0] == '/' || strchr(path, ':')) {
+        return false;
+    }
+    while (*component) {
+        size_t length = strcspn(component, "/");
+        if (length == 2 && component[0] == '.' && component[1] == '.') {
+            return false;
+        }
+        component += length;
+        if (*component == '/') {
+            component++;
+        }
+    }
+    return true;
+}
+
+static bool build_output_path(char *out, size_t out_size, const char *dest,
+                              const char *path, bool keep_paths)
+{
+    const char *name = path;
+    size_t dest_length = strlen(dest);
+    int written;
+
+    if (!keep_paths) {
+        const char *slash = strrchr(path, '/');
+        name = slash ? slash + 1 : path;
+    }
+
+    /* "Work:" and "dir/" are used as given; anything else needs a separator */
+    if (dest_length == 0 || dest[dest_length - 1] == '/' || dest[dest_length - 1] == ':') {
+        written = snprintf(out, out_size, "%s%s", dest, name);
+    } else {
+        written = snprintf(out, out_size, "%s/%s", dest, name);
+    }
+    return written > 0 && (size_t)written < out_size;
+}
+
+static void strip_trailing_slash(char *path)
+{
+    size_t length = strlen(path);
+
+    while (length > 1 && path[length - 1] == '/') {
+        path[--length] = '\0';
+    }
+}
+
+/* Create one directory; one that already exists is fine */
+static bool make_directory(const char *path)
+{
+#ifdef PLATFORM_AMIGA
+    BPTR lock = CreateDir((STRPTR)path);
+    if (lock) {
+        UnLock(lock);
+        return true;
+    }
+    return IoErr() == ERROR_OBJECT_EXISTS;
+#else
+    return mkdir(path, 0777) == 0 || errno == EEXIST;
+#endif
+}
+
+/* Create every directory leading up to the last component of path */
+static bool make_parents(char *path)
+{
+    char *slash = path;
+
+    while ((slash = strchr(slash + 1, '/')) != NULL) {
+        if (slash[-1] == '/' || slash[-1] == ':') {
+            continue;
+        }
+        *slash = '\0';
+        bool made = make_directory(path);
+        *slash = '/';
+        if (!made) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool write_output(const uint8_t *data, size_t length, void *user_data)
+{
+    lha_write_context_t *ctx = (lha_write_context_t *)user_data;
+
+    if (fwrite(data, 1, length, ctx->out) != length) {
+        ctx->write_failed = true;
+        return false;
+    }
+    if (ctx->progress) {
+        ctx->progress(ctx->member, (uint32_t)length, false, ctx->user_data);
+    }
+    return true;
+}
+
+/* Modification time and Unix permissions as LhA sets them. Like LhA this
+ * is best effort - the data is already written, so failures are ignored. */
+static void restore_attributes(const char *path, const lha_member_t *member)
+{
+#ifdef PLATFORM_AMIGA
+    /* Native extraction is off on the Amiga, where LhA does this itself */
+    (void)path;
+    (void)member;
+#else
+    time_t mtime = (time_t)-1;
+
+    if (member->unix_time) {
+        mtime = (time_t)member->timestamp;
+    } else if (member->timestamp != 0) {
+        /* MS-DOS stamps are local time: date in the high word, time in the low */
+        struct tm local;
+        memset(&local, 0, sizeof(local));
+        local.tm_year = (int)((member->timestamp >> 25) & 0x7F) + 80;
+        local.tm_mon = (int)((member->timestamp >> 21) & 0x0F) - 1;
+        local.tm_mday = (int)((member->timestamp >> 16) & 0x1F);
+        local.tm_hour = (int)((member->timestamp >> 11) & 0x1F);
+        local.tm_min = (int)((member->timestamp >> 5) & 0x3F);
+        local.tm_sec = (int)(member->timestamp & 0x1F) * 2;
+        local.tm_isdst = -1;
+        mtime = mktime(&local);
+    }
+
+    if (mtime != (time_t)-1) {
+        struct utimbuf times;
+        times.actime = mtime;
+        times.modtime = mtime;
+        utime(path, &times);
+    }
+    /* Only the permission bits - never set-user-ID and friends */
+    if (member->unix_mode != 0) {
+        chmod(path, (mode_t)(member->unix_mode & 0777));
+    }
+#endif
+}
+
+static bool extract_member(lha_source_t *archive, const lha_member_t *member, const char *dest,
+                           bool keep_paths, lha_progress_t progress, void *user_data)
+{
+    char out_path[LHA_EXTRACT_PATH_MAX];
+
+    if (member->is_directory) {
+        /* "e" flattens the tree, so there is nothing to create */
+        if (!keep_paths) {
+            return true;
+        }
+        if (!build_output_path(out_path, sizeof(out_path), dest, member->path, true)) {
+            return false;
+        }
+        strip_trailing_slash(out_path);
+        return make_parents(out_path) && make_directory(out_path);
+    }
+
+    if (!build_output_path(out_path, sizeof(out_path), dest, member->path, keep_paths) ||
+        !make_parents(out_path)) {
+        return false;
+    }
+
+    lha_write_context_t ctx = {NULL, member, progress, user_data, false};
+    ctx.out = fopen(out_path, "wb");
+    if (!ctx.out) {
+        return false;
+    }
+
+    int error = lha_decode_member(archive, member, write_output, &ctx);
+    if (fclose(ctx.out) != 0) {
+        ctx.write_failed = true;
+    }
+
+    /* A damaged member is removed rather than left looking complete */
+    if (error != LHA_DECODE_OK || ctx.write_failed) {
+        remove(out_path);
+        return false;
+    }
+    restore_attributes(out_path, member);
+
+    if (progress) {
+        progress(member, 0, true, user_data);
+    }
+    return true;
+}
+
+/* Headers up to the end of the archive or the first damaged one; false
+ * only when memory runs out */
+static bool read_members(lha_source_t *source, lha_member_t **out_members,
+                         uint32_t *out_count, int *out_error)
+{
+    lha_archive_t archive;
+    lha_member_t *members = NULL;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+
+    if (!lha_archive_open_source(&archive, source)) {
+        return false;
+    }
+
+    for (;;) {
+        if (count == capacity) {
+            uint32_t grown_capacity = capacity ? capacity * 2 : LHA_EXTRACT_INITIAL_MEMBERS;
+            lha_member_t *grown = (lha_member_t *)realloc(members,
+                                                         grown_capacity * sizeof(lha_member_t));
+            if (!grown) {
+                lha_archive_close(&archive);
+                free(members);
+                return false;
+            }
+            members = grown;
+            capacity = grown_capacity;
+        }
+        if (!lha_archive_next(&archive, &members[count])) {
+            break;
+        }
+        count++;
+    }
+
+    *out_error = archive.error;
+    lha_archive_close(&archive);
+    *out_members = members;
+    *out_count = count;
+    return true;
+}
+
+/* Whether every member can be written without the tool: a method the
+ * decoder knows and a path that stays inside the destination */
+static bool can_extract(const lha_member_t *members, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        if (!lha_decode_supported(members[i].method) || !is_safe_path(members[i].path)) {
+            return false;
+        }
+    }
+    return count > 0;
+}
+
+/* Report entries back in archive order */
+static int compare_tested(const void *a, const void *b)
+{
+    uint32_t left = ((const lha_test_member_t *)a)->member.header_offset;
+    uint32_t right = ((const lha_test_member_t *)b)->member.header_offset;
+
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+/* Directories first, then files from largest to smallest */
+static int compare_members(const void *a, const void *b)
+{
+    const lha_member_t *left = (const lha_member_t *)a;
+    const lha_member_t *right = (const lha_member_t *)b;
+
+    if (left->is_directory != right->is_directory) {
+        return left->is_directory ? -1 : 1;
+    }
+    if (left->original_size != right->original_size) {
+        return left->original_size > right->original_size ? -1 : 1;
+    }
+    return left->data_offset < right->data_offset ? -1 : 1;
+}
+
+/* Name the member is written under, relative to the destination */
+static const char *output_name(const lha_member_t *member, bool keep_paths)
+{
+    const char *slash = keep_paths ? NULL : strrchr(member->path, '/');
+
+    return slash ? slash + 1 : member->path;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+static bool has_duplicate_names(const lha_member_t *members, uint32_t count, bool keep_paths)
+{
+    const char **names = (const char **)malloc(count * sizeof(const char *));
+    bool duplicate = false;
+    uint32_t i;
+
+    /* Without memory to check, assume the worst */
+    if (!names) {
+        return true;
+    }
+    /* "e" skips directories, so they cannot clash there */
+    uint32_t named = 0;
+    for (i = 0; i < count; i++) {
+        if (keep_paths || !members[i].is_directory) {
+            names[named++] = output_name(&members[i], keep_paths);
+        }
+    }
+    qsort(names, named, sizeof(const char *), compare_names);
+    for (i = 1; i < named && !duplicate; i++) {
+        duplicate = strcmp(names[i - 1], names[i]) == 0;
+    }
+
+    free(names);
+    return duplicate;
+}
+
+static void job_lock(lha_extract_job_t *job)
+{
+#ifndef PLATFORM_AMIGA
+    if (job->threaded) {
+        pthread_mutex_lock(&job->lock);
+    }
+#else
+    (void)job;
+#endif
+}
+
+static void job_unlock(lha_extract_job_t *job)
+{
+#ifndef PLATFORM_AMIGA
+    if (job->threaded) {
+        pthread_mutex_unlock(&job->lock);
+    }
+#else
+    (void)job;
+#endif
+}
+
+/* Serializes the caller's progress callback between workers */
+static void job_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                         void *user_data)
+{
+    lha_extract_job_t *job = (lha_extract_job_t *)user_data;
+
+    job_lock(job);
+    job->progress(member, new_bytes, finished, job->user_data);
+    job_unlock(job);
+}
+
+/* Take members off the list until it is empty. The shared source needs
+ * no lock: mapped archives are only read and file sources use pread(). */
+static void run_worker(lha_extract_job_t *job)
+{
+    for (;;) {
+        job_lock(job);
+        uint32_t index = job->next_member;
+        if (index < job->member_count) {
+            job->next_member++;
+        }
+        job_unlock(job);
+        if (index >= job->member_count) {
+            break;
+        }
+
+        /* Testing decodes into nothing; only this worker writes the entry */
+        if (job->results) {
+            job->results[index] = lha_decode_member(&job->source, &job->members[index],
+                                                    NULL, NULL);
+            continue;
+        }
+        if (!extract_member(&job->source, &job->members[index], job->dest, job->keep_paths,
+                            job->progress ? job_progress : NULL, job)) {
+            job_lock(job);
+            job->failed = true;
+            job_unlock(job);
+        }
+    }
+}
+
+#ifndef PLATFORM_AMIGA
+static void *worker_thread(void *arg)
+{
+    run_worker((lha_extract_job_t *)arg);
+    return NULL;
+}
+#endif
@@ -0,0 +1,133 @@
+#ifndef LHA_EXTRACT_H
+#define LHA_EXTRACT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lha_archive.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Let cli_extract() and lha_controlled_extract() decode plain "lha x"
+ * commands in-process instead of starting LhA. Off on the Amiga, where
+ * LhA itself is the reference, restores protection bits and filenotes,
+ * and every KB of RAM counts. */
+#ifndef LHA_NATIVE_EXTRACT
+#ifdef PLATFORM_AMIGA
+#define LHA_NATIVE_EXTRACT 0
+#else
+#define LHA_NATIVE_EXTRACT 1
+#endif
+#endif
+
+/* Members decoded at once by cli_extract() and lha_controlled_extract()
+ * (0 = one per CPU). Each worker holds about 90 KB of decoder state. */
+#ifndef LHA_EXTRACT_WORKERS
+#define LHA_EXTRACT_WORKERS 0
+#endif
+
+/* Upper bound on workers, whatever is asked for */
+#define LHA_EXTRACT_MAX_WORKERS 16
+
+/* Result of lha_extract_archive() */
+#define LHA_EXTRACT_OK          0     /* Every member written and its CRC matched */
+#define LHA_EXTRACT_FAILED      1     /* Some members could not be decoded or written */
+#define LHA_EXTRACT_NOT_HANDLED 2     /* Nothing written - leave the archive to the tool */
+
+/**
+ * @brief Outcome of one member in lha_test_archive()
+ */
+typedef struct {
+    lha_member_t member;              /* Header as read */
+    int result;                       /* LHA_DECODE_OK, or why the member failed */
+} lha_test_member_t;
+
+/**
+ * @brief Per-member results of lha_test_archive()
+ */
+typedef struct {
+    lha_test_member_t *members;       /* In archive order */
+    uint32_t member_count;
+    uint32_t failed_count;            /* Members whose result is not LHA_DECODE_OK */
+    int archive_error;                /* LHA_ARCHIVE_* that ended the header walk */
+} lha_test_report_t;
+
+/**
+ * @brief Reports extraction progress as bytes are written
+ *
+ * Called with new_bytes > 0 each time a piece of a member has been written,
+ * then once with finished set when the member is complete and its CRC has
+ * been checked (new_bytes is 0 then).
+ */
+typedef void (*lha_progress_t)(const lha_member_t *member, uint32_t new_bytes,
+                               bool finished, void *user_data);
+
+/**
+ * @brief Extract a whole archive in-process
+ *
+ * All headers are read first. If any member uses a method the decoder
+ * does not handle, or has an absolute path or ".." in it, nothing is
+ * written and LHA_EXTRACT_NOT_HANDLED is returned so the caller can fall
+ * back to the external tool. Existing files are overwritten. On host each
+ * file gets its modification time and, when the archive stores them, its
+ * Unix permission bits back; directories and Amiga protection bits are
+ * left as created.
+ *
+ * @param archive_path Archive file name
+ * @param dest_dir Directory to extract into (NULL or "" = current directory)
+ * @param keep_paths true to recreate member directories ("x"), false to
+ *        write every file straight into dest_dir ("e")
+ * @param progress Called as bytes are written (can be NULL)
+ * @param user_data Passed to progress
+ * @return LHA_EXTRACT_OK, LHA_EXTRACT_FAILED or LHA_EXTRACT_NOT_HANDLED
+ */
+int lha_extract_archive(const char *archive_path, const char *dest_dir, bool keep_paths,
+                        lha_progress_t progress, void *user_data);
+
+/**
+ * @brief Extract a whole archive, several members at once
+ *
+ * As lha_extract_archive(), but members are decoded by a pool of worker
+ * threads sharing one archive source (mapped where possible). Members are
+ * taken largest first rather than in archive order. progress is never
+ * called from two threads at once, so it may update plain counters. On
+ * Amiga, or with one worker, the calling thread does all the work.
+ *
+ * @param workers Worker threads (0 = one per CPU, at most LHA_EXTRACT_MAX_WORKERS)
+ * @return LHA_EXTRACT_OK, LHA_EXTRACT_FAILED or LHA_EXTRACT_NOT_HANDLED
+ */
+int lha_extract_archive_parallel(const char *archive_path, const char *dest_dir,
+                                 bool keep_paths, uint32_t workers,
+                                 lha_progress_t progress, void *user_data);
+
+/**
+ * @brief Check every member of an archive in-process, like "lha t"
+ *
+ * Each member is decoded with its output discarded and its CRC-16
+ * compared with the one in its header, on a pool of worker threads as in
+ * lha_extract_archive_parallel(). Nothing is written and no process is
+ * started. Members with a method the decoder does not handle are reported
+ * as LHA_DECODE_UNSUPPORTED. A damaged header ends the walk: the members
+ * before it are still tested and archive_error says what was wrong.
+ *
+ * @param archive_path Archive file name
+ * @param workers Worker threads (0 = one per CPU, at most LHA_EXTRACT_MAX_WORKERS)
+ * @param report Receives the results; free with lha_test_report_free()
+ * @return LHA_EXTRACT_OK if every header was read and every member passed
+ * @return LHA_EXTRACT_FAILED if some member failed or a header is damaged
+ * @return LHA_EXTRACT_NOT_HANDLED if the archive could not be opened (or
+ *         memory ran out); report is then empty
+ */
+int lha_test_archive(const char *archive_path, uint32_t workers, lha_test_report_t *report);
+
+/**
+ * @brief Release the results of lha_test_archive()
+ */
+void lha_test_report_free(lha_test_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LHA_EXTRACT_H */
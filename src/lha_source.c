@@ -0,0 +1,199 @@
+#ifndef PLATFORM_AMIGA
+#define _POSIX_C_SOURCE 200809L       /* pread() */
+#endif
+
+#include "lha_source.h"
+#include <string.h>
+
+#ifndef PLATFORM_AMIGA
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+/* Internal helper functions */
+static void reset(lha_source_t *source);
+#ifndef PLATFORM_AMIGA
+static bool map_file(lha_source_t *source, int fd);
+#endif
+
+bool lha_source_open(lha_source_t *source, const char *path, int kind)
+{
+    if (!source) {
+        return false;
+    }
+    reset(source);
+    if (!path) {
+        return false;
+    }
+
+#ifdef PLATFORM_AMIGA
+    (void)kind;
+    source->file = fopen(path, "rb");
+    if (!source->file) {
+        return false;
+    }
+    long size = -1;
+    if (fseek(source->file, 0, SEEK_END) == 0) {
+        size = ftell(source->file);
+    }
+    if (size < 0) {
+        lha_source_close(source);
+        return false;
+    }
+    source->kind = LHA_SOURCE_FILE;
+    source->size = (uint32_t)size;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0) {
+        return false;
+    }
+    /* Offsets in LHA headers are 32 bits, so larger files cannot be archives */
+    if (fstat(fd, &info) != 0 || info.st_size < 0 || (uint64_t)info.st_size > UINT32_MAX) {
+        close(fd);
+        return false;
+    }
+    source->size = (uint32_t)info.st_size;
+
+    if (kind != LHA_SOURCE_FILE && map_file(source, fd)) {
+        close(fd);                    /* The mapping stays valid without it */
+        return true;
+    }
+    if (kind == LHA_SOURCE_MMAP) {
+        close(fd);
+        reset(source);
+        return false;
+    }
+
+    source->kind = LHA_SOURCE_FILE;
+    source->fd = fd;
+    return true;
+#endif
+}
+
+void lha_source_open_memory(lha_source_t *source, const void *data, uint32_t size)
+{
+    if (!source) {
+        return;
+    }
+    reset(source);
+    source->kind = LHA_SOURCE_MEMORY;
+    source->data = (const uint8_t *)data;
+    source->size = data ? size : 0;
+}
+
+void lha_source_close(lha_source_t *source)
+{
+    if (!source) {
+        return;
+    }
+#ifdef PLATFORM_AMIGA
+    if (source->file) {
+        fclose(source->file);
+    }
+#else
+    if (source->kind == LHA_SOURCE_MMAP && source->data) {
+        munmap((void *)source->data, source->size);
+    }
+    if (source->fd >= 0) {
+        close(source->fd);
+    }
+#endif
+    reset(source);
+}
+
+uint32_t lha_source_read(lha_source_t *source, uint32_t offset, uint32_t length,
+                         uint8_t *buffer, uint32_t buffer_size, const uint8_t **out_data)
+{
+    if (!source || !out_data || offset >= source->size) {
+        return 0;
+    }
+    if (length > source->size - offset) {
+        length = source->size - offset;
+    }
+
+    if (source->data) {
+        *out_data = source->data + offset;
+        return length;
+    }
+
+    if (length > buffer_size) {
+        length = buffer_size;
+    }
+    if (!buffer || length == 0) {
+        return 0;
+    }
+
+#ifdef PLATFORM_AMIGA
+    if (!source->file || fseek(source->file, (long)offset, SEEK_SET) != 0 ||
+        fread(buffer, 1, length, source->file) != length) {
+        return 0;
+    }
+#else
+    /* pread() has no shared file position, so threads can read at once */
+    uint32_t done = 0;
+    while (done < length) {
+        ssize_t got = pread(source->fd, buffer + done, length - done, (off_t)offset + done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return 0;
+        }
+        done += (uint32_t)got;
+    }
+#endif
+
+    *out_data = buffer;
+    return length;
+}
+
+const char *lha_source_kind_name(int kind)
+{
+    switch (kind) {
+    case LHA_SOURCE_AUTO:   return "auto";
+    case LHA_SOURCE_MMAP:   return "mmap";
+    case LHA_SOURCE_FILE:   return "file";
+    case LHA_SOURCE_MEMORY: return "memory";
+    default:                return "unknown";
+    }
+}
+
+/* Internal helper functions */
+
+static void reset(lha_source_t *source)
+{
+    source->kind = LHA_SOURCE_AUTO;
+    source->data = NULL;
+    source->size = 0;
+#ifdef PLATFORM_AMIGA
+    source->file = NULL;
+#else
+    source->fd = -1;
+#endif
+}
+
+#ifndef PLATFORM_AMIGA
+static bool map_file(lha_source_t *source, int fd)
+{
+    /* An empty file cannot be mapped; reading it costs nothing anyway */
+    if (source->size == 0) {
+        return false;
+    }
+
+    void *data = mmap(NULL, source->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    source->kind = LHA_SOURCE_MMAP;
+    source->data = (const uint8_t *)data;
+    return true;
+}
+#endif
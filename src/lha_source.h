@@ -0,0 +1,98 @@
+#ifndef LHA_SOURCE_H
+#define LHA_SOURCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* How an archive's bytes are reached */
+#define LHA_SOURCE_AUTO   0           /* Map the file; read it if that fails */
+#define LHA_SOURCE_MMAP   1           /* Whole file mapped read-only (host) */
+#define LHA_SOURCE_FILE   2           /* Read on demand into the caller's buffer */
+#define LHA_SOURCE_MEMORY 3           /* Archive already in a caller's buffer */
+
+/* What lha_archive_open() and lha_extract_archive() use for a path */
+#ifndef LHA_SOURCE_DEFAULT
+#define LHA_SOURCE_DEFAULT LHA_SOURCE_AUTO
+#endif
+
+/**
+ * @brief Random access to the bytes of one archive
+ *
+ * Mapped and memory sources hand out pointers into the archive itself,
+ * so header walks are pointer arithmetic and decoders read packed data
+ * without copying it. File sources read each request into a buffer the
+ * caller provides; on host they use pread(), so like the other kinds
+ * they may be shared by threads.
+ */
+typedef struct {
+    int kind;                         /* LHA_SOURCE_MMAP, _FILE or _MEMORY once open */
+    const uint8_t *data;              /* Whole archive (mapped and memory sources) */
+    uint32_t size;                    /* Bytes in the archive */
+#ifdef PLATFORM_AMIGA
+    FILE *file;                       /* File source */
+#else
+    int fd;                           /* File source (-1 otherwise) */
+#endif
+} lha_source_t;
+
+/**
+ * @brief Open an archive file
+ *
+ * @param source Source to initialize
+ * @param path Archive file name
+ * @param kind LHA_SOURCE_AUTO, LHA_SOURCE_MMAP or LHA_SOURCE_FILE. Mapping
+ *        is not available on Amiga, where AUTO and MMAP read the file.
+ * @return true if the archive can be read
+ * @return false if it could not be opened (or mapped, for LHA_SOURCE_MMAP)
+ */
+bool lha_source_open(lha_source_t *source, const char *path, int kind);
+
+/**
+ * @brief Use an archive that is already in memory
+ *
+ * The buffer is not copied and must stay valid until the source is closed.
+ */
+void lha_source_open_memory(lha_source_t *source, const void *data, uint32_t size);
+
+/**
+ * @brief Unmap or close the file; memory sources are left alone
+ *
+ * Safe to call on a source that failed to open.
+ */
+void lha_source_close(lha_source_t *source);
+
+/**
+ * @brief Bytes of the archive starting at offset
+ *
+ * Mapped and memory sources point *out_data into the archive and return
+ * up to length bytes. File sources read up to buffer_size of them into
+ * buffer and point *out_data there.
+ *
+ * @param source Open source
+ * @param offset Archive offset of the first byte
+ * @param length Bytes wanted
+ * @param buffer Space for file sources (not used by the others)
+ * @param buffer_size Size of buffer
+ * @param out_data Receives where the bytes are
+ * @return Bytes available at *out_data; fewer than asked at the end of the
+ *         archive or when buffer is smaller, 0 past the end or on a read error
+ */
+uint32_t lha_source_read(lha_source_t *source, uint32_t offset, uint32_t length,
+                         uint8_t *buffer, uint32_t buffer_size, const uint8_t **out_data);
+
+/**
+ * @brief Short name of a source kind, for logs and benchmarks
+ */
+const char *lha_source_kind_name(int kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LHA_SOURCE_H */
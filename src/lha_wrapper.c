@@ -1,5 +1,7 @@
 #include "lha_wrapper.h"
 #include "process_control.h"
+#include "lha_archive.h"
+#include "lha_extract.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,11 +9,15 @@
 
 /* Internal helper functions */
 static void lha_log_message(const char *format, ...);
-static bool lha_list_line_processor(const char *line, void *user_data);
-static bool lha_extract_line_processor(const char *line, void *user_data);
+static bool lha_list_line_processor(const char *line, size_t length, void *user_data);
+static bool lha_extract_line_processor(const char *line, size_t length, void *user_data);
+static bool lha_extract_error_processor(const char *line, size_t length, void *user_data);
 static bool parse_lha_list_line(const char *line, uint32_t *file_size);
 static bool parse_lha_extract_line(const char *line, uint32_t *file_size, char *filename, size_t filename_max);
-static void strip_escape_codes(const char *input, char *output, size_t output_size);
+#if LHA_NATIVE_EXTRACT
+static void lha_extract_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                                 void *user_data);
+#endif
 
 /* Data structures for line processing callbacks */
 typedef struct {
@@ -25,6 +31,7 @@ typedef struct {
     uint32_t cumulative_bytes;
     uint32_t file_count;
     uint32_t last_percentage_x10;
+    uint32_t error_count;
     bool completion_detected;
 } lha_extract_context_t;
 
@@ -95,6 +102,16 @@ bool lha_controlled_list(const char *cmd, uint32_t *out_total, uint32_t *out_fil
     lha_log_message("Starting LHA controlled list operation");
     lha_log_message("Command: %s", cmd);
 
+    /* Headers carry everything a listing needs - only spawn LhA for what
+     * the reader cannot handle (file patterns, damaged or odd archives) */
+    char archive_path[LHA_MAX_PATH];
+    if (lha_list_command_archive(cmd, archive_path, sizeof(archive_path)) &&
+        lha_archive_totals(archive_path, out_total, out_file_count)) {
+        lha_log_message("Read headers of %s in-process", archive_path);
+        lha_log_message("Total size: %lu bytes", (unsigned long)*out_total);
+        return true;
+    }
+
     /* Set up list context */
     lha_list_context_t ctx = {0, 0, false};
 
@@ -103,12 +120,13 @@ bool lha_controlled_list(const char *cmd, uint32_t *out_total, uint32_t *out_fil
         .tool_name = "LhA",
         .pipe_prefix = "lha_list",
         .timeout_seconds = 30,
-        .silent_mode = false
+        .silent_mode = false,
+        .strip_escapes = true
     };
 
     /* Execute controlled process */
     controlled_process_t process;
-    bool result = execute_controlled_process(cmd, lha_list_line_processor, &ctx, &config, &process);
+    bool result = execute_controlled_process_views(cmd, lha_list_line_processor, &ctx, &config, &process);
 
     if (result) {
         *out_total = ctx.total_size;
@@ -139,6 +157,12 @@ bool lha_controlled_list(const char *cmd, uint32_t *out_total, uint32_t *out_fil
 }
 
 bool lha_controlled_extract(const char *cmd, uint32_t total_expected)
+{
+    return lha_controlled_extract_limited(cmd, total_expected, NULL);
+}
+
+bool lha_controlled_extract_limited(const char *cmd, uint32_t total_expected,
+                                    const process_limits_t *limits)
 {
     if (!cmd) {
         return false;
@@ -160,20 +184,57 @@ bool lha_controlled_extract(const char *cmd, uint32_t total_expected)
         .cumulative_bytes = 0,
         .file_count = 0,
         .last_percentage_x10 = 0,
+        .error_count = 0,
         .completion_detected = false
     };
 
+#if LHA_NATIVE_EXTRACT
+    /* Plain "lha x" commands are decoded in-process; LhA only runs for
+     * options, patterns or methods the decoder does not handle */
+    char archive_path[LHA_MAX_PATH];
+    char dest_path[LHA_MAX_PATH];
+    bool keep_paths;
+    if (lha_extract_command_archive(cmd, archive_path, sizeof(archive_path),
+                                    dest_path, sizeof(dest_path), &keep_paths)) {
+        int native = lha_extract_archive_parallel(archive_path, dest_path, keep_paths,
+                                                  LHA_EXTRACT_WORKERS, lha_extract_progress, &ctx);
+        if (native != LHA_EXTRACT_NOT_HANDLED) {
+            lha_log_message("Extracted %s in-process: %s", archive_path,
+                            native == LHA_EXTRACT_OK ? "all files OK" : "some files failed");
+            lha_log_message("Files extracted: %lu", (unsigned long)ctx.file_count);
+            lha_log_message("Bytes extracted: %lu", (unsigned long)ctx.cumulative_bytes);
+            return native == LHA_EXTRACT_OK;
+        }
+        lha_log_message("Archive needs LhA - starting it");
+    }
+#endif
+
     /* Configure process execution */
     process_exec_config_t config = {
         .tool_name = "LhA",
         .pipe_prefix = "lha_extract",
         .timeout_seconds = 60,
-        .silent_mode = false
+        .silent_mode = false,
+        .strip_escapes = true,
+        .use_pty = true,              /* Progress lines as they happen, not at exit */
+        .error_processor = lha_extract_error_processor,
+        .error_user_data = &ctx
     };
+    if (limits) {
+        config.limits = *limits;
+    }
 
     /* Execute controlled process */
     controlled_process_t process;
-    bool result = execute_controlled_process(cmd, lha_extract_line_processor, &ctx, &config, &process);
+    bool result = execute_controlled_process_views(cmd, lha_extract_line_processor, &ctx, &config, &process);
+
+    /* Output ends cleanly when the kernel kills the tool, so check why it stopped */
+    int32_t end_reason;
+    if (result && get_process_end_reason(&process, &end_reason) &&
+        end_reason >= PROCESS_END_CPU_LIMIT) {
+        lha_log_message("LHA extract stopped by a resource limit (reason %ld)", (long)end_reason);
+        result = false;
+    }
 
     if (result) {
         /* Check for exit code */
@@ -189,6 +250,8 @@ bool lha_controlled_extract(const char *cmd, uint32_t total_expected)
         lha_log_message("LHA extract completed successfully");
         lha_log_message("Files extracted: %lu", (unsigned long)ctx.file_count);
         lha_log_message("Bytes extracted: %lu", (unsigned long)ctx.cumulative_bytes);
+    } else if (ctx.error_count > 0) {
+        lha_log_message("LHA extract aborted after %lu error line(s)", (unsigned long)ctx.error_count);
     } else {
         lha_log_message("LHA extract failed");
     }
@@ -222,7 +285,7 @@ static void lha_log_message(const char *format, ...)
     fflush(g_lha_logfile);
 }
 
-static bool lha_list_line_processor(const char *line, void *user_data)
+static bool lha_list_line_processor(const char *line, size_t length, void *user_data)
 {
     lha_list_context_t *ctx = (lha_list_context_t *)user_data;
     
@@ -230,11 +293,10 @@ static bool lha_list_line_processor(const char *line, void *user_data)
         return false;
     }
 
-    /* Strip escape codes from line */
-    char clean_line[256];
-    strip_escape_codes(line, clean_line, sizeof(clean_line));
+    /* Escape codes were already stripped in place by the reader */
+    const char *clean_line = line;
 
-    lha_log_message("Processing list line: %s", clean_line);
+    lha_log_message("Processing list line (%lu bytes): %s", (unsigned long)length, clean_line);
 
     /* Check for completion indicators */
     if (strstr(clean_line, "Operation successful") || 
@@ -261,7 +323,7 @@ static bool lha_list_line_processor(const char *line, void *user_data)
     return true;
 }
 
-static bool lha_extract_line_processor(const char *line, void *user_data)
+static bool lha_extract_line_processor(const char *line, size_t length, void *user_data)
 {
     lha_extract_context_t *ctx = (lha_extract_context_t *)user_data;
     
@@ -269,11 +331,10 @@ static bool lha_extract_line_processor(const char *line, void *user_data)
         return false;
     }
 
-    /* Strip escape codes from line */
-    char clean_line[256];
-    strip_escape_codes(line, clean_line, sizeof(clean_line));
+    /* Escape codes were already stripped in place by the reader */
+    const char *clean_line = line;
 
-    lha_log_message("Processing extract line: %s", clean_line);
+    lha_log_message("Processing extract line (%lu bytes): %s", (unsigned long)length, clean_line);
 
     /* Check for completion indicators */
     if (strstr(clean_line, "Operation successful")) {
@@ -312,6 +373,62 @@ static bool lha_extract_line_processor(const char *line, void *user_data)
     return true;
 }
 
+#if LHA_NATIVE_EXTRACT
+/* Same bookkeeping as lha_extract_line_processor(), fed with the bytes the
+ * in-process extractor writes instead of parsed "Extracting" lines */
+static void lha_extract_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                                 void *user_data)
+{
+    lha_extract_context_t *ctx = (lha_extract_context_t *)user_data;
+
+    ctx->cumulative_bytes += new_bytes;
+
+    uint32_t percentage_x10 = 0;
+    if (ctx->total_expected > 0) {
+        percentage_x10 = (uint32_t)(((uint64_t)ctx->cumulative_bytes * 1000) / ctx->total_expected);
+    }
+
+    /* Log progress at 1% intervals */
+    if (percentage_x10 > ctx->last_percentage_x10 + 10) {
+        lha_log_message("Progress: %lu.%lu%% (%lu/%lu bytes)",
+                       (unsigned long)(percentage_x10 / 10),
+                       (unsigned long)(percentage_x10 % 10),
+                       (unsigned long)ctx->cumulative_bytes,
+                       (unsigned long)ctx->total_expected);
+        ctx->last_percentage_x10 = percentage_x10;
+    }
+
+    if (finished) {
+        ctx->file_count++;
+        lha_log_message("Extracted: %s (%lu bytes)", member->path,
+                        (unsigned long)member->original_size);
+    }
+}
+#endif
+
+/* Only sees the tool's stderr, so no scanning of progress lines for errors */
+static bool lha_extract_error_processor(const char *line, size_t length, void *user_data)
+{
+    lha_extract_context_t *ctx = (lha_extract_context_t *)user_data;
+
+    (void)length;
+    lha_log_message("LHA stderr: %s", line);
+
+    /* Warnings are logged and extraction goes on; an error (bad CRC,
+     * unreadable member) makes the rest of the output worthless. Only
+     * LhA's own "*** Error" prefix counts - a member called errorlog.txt
+     * in a warning is not one */
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+    if (strncmp(line, "*** Error", 9) == 0) {
+        ctx->error_count++;
+        return false;
+    }
+
+    return true;
+}
+
 static bool parse_lha_list_line(const char *line, uint32_t *file_size)
 {
     if (!line || !file_size) {
@@ -399,32 +516,3 @@ static bool parse_lha_extract_line(const char *line, uint32_t *file_size, char *
     *file_size = (uint32_t)size;
     return true;
 }
-
-static void strip_escape_codes(const char *input, char *output, size_t output_size)
-{
-    if (!input || !output || output_size == 0) {
-        return;
-    }
-
-    size_t out_pos = 0;
-    size_t in_pos = 0;
-    size_t input_len = strlen(input);
-
-    while (in_pos < input_len && out_pos < output_size - 1) {
-        if (input[in_pos] == '\x1b' || input[in_pos] == '[') {
-            /* Skip escape sequences */
-            while (in_pos < input_len && 
-                   (input[in_pos] < 'A' || input[in_pos] > 'Z') &&
-                   (input[in_pos] < 'a' || input[in_pos] > 'z')) {
-                in_pos++;
-            }
-            if (in_pos < input_len) {
-                in_pos++; /* Skip the final character */
-            }
-        } else {
-            output[out_pos++] = input[in_pos++];
-        }
-    }
-
-    output[out_pos] = '\0';
-}
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <time.h>
+#include "process_control.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +35,8 @@ void lha_wrapper_cleanup(void);
  * Executes the specified list command using the controlled process system
  * and parses the output to extract file information and calculate total size.
  * Provides full process control including signal handling and death monitoring.
+ * A plain "lha l <archive>" command is answered from the archive's headers
+ * without starting a process (see lha_archive_totals()).
  *
  * @param cmd Complete command string to execute (e.g., "lha l archive.lha")
  * @param out_total Pointer to receive total uncompressed size in bytes
@@ -49,14 +52,38 @@ bool lha_controlled_list(const char *cmd, uint32_t *out_total, uint32_t *out_fil
  * Executes the specified extract command using the controlled process system
  * and parses the output line-by-line to track progress. Provides full process
  * control including pause/resume capabilities and death monitoring.
+ * On host, the tool's stderr is read separately and the first error line
+ * on it (e.g. a failed CRC check) aborts the extraction. The tool runs
+ * without resource limits; see lha_controlled_extract_limited().
+ * With LHA_NATIVE_EXTRACT (host default), a plain "lha x <archive> [dest]"
+ * is decoded in-process by lha_extract_archive_parallel() (LHA_EXTRACT_WORKERS
+ * threads) and LhA is only started for archives or options it leaves alone.
  *
  * @param cmd Complete command string to execute (e.g., "lha x -m -n archive.lha dest/")
  * @param total_expected Total bytes expected to be extracted (from lha_controlled_list)
  * @return true if extraction completed successfully
- * @return false if extraction failed
+ * @return false if extraction failed or an error was reported
  */
 bool lha_controlled_extract(const char *cmd, uint32_t total_expected);
 
+/**
+ * @brief Extract like lha_controlled_extract(), with LhA under host limits
+ *
+ * For callers that want a corrupt archive which sends LhA spinning or
+ * allocating stopped before it takes the machine. Any limit means a fork()
+ * instead of the posix_spawn() fast path (see process_limits_t), and a run
+ * a limit ends counts as failed. Archives decoded in-process are not
+ * affected.
+ *
+ * @param cmd Complete command string to execute
+ * @param total_expected Total bytes expected to be extracted
+ * @param limits Limits for the tool, NULL for none
+ * @return true if extraction completed successfully
+ * @return false if extraction failed, an error was reported or a limit hit
+ */
+bool lha_controlled_extract_limited(const char *cmd, uint32_t total_expected,
+                                    const process_limits_t *limits);
+
 #ifdef __cplusplus
 }
 #endif
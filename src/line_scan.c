@@ -0,0 +1,174 @@
+#include "line_scan.h"
+#include <stdint.h>
+
+/* Vector paths need GCC/Clang target attributes and an x86 CPU */
+#if !defined(PLATFORM_AMIGA) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINE_SCAN_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#define LINE_SCAN_ESC 27
+
+typedef const char *(*line_scan_fn_t)(const char *data, size_t size, bool find_escape);
+
+/* Internal helper functions */
+static const char *scan_scalar(const char *data, size_t size, bool find_escape);
+static line_scan_fn_t scan_for_level(int level);
+#ifdef LINE_SCAN_HAVE_X86
+static const char *scan_sse2(const char *data, size_t size, bool find_escape);
+static const char *scan_avx2(const char *data, size_t size, bool find_escape);
+#endif
+
+/* Only written by line_scan_init() and line_scan_use_level(), before any
+ * thread scans; every candidate gives identical results */
+static line_scan_fn_t g_scan_fn = scan_scalar;
+
+void line_scan_init(void)
+{
+    g_scan_fn = scan_for_level(line_scan_best_level());
+}
+
+const char *line_scan_next(const char *data, size_t size, bool find_escape)
+{
+    return g_scan_fn(data, size, find_escape);
+}
+
+int line_scan_best_level(void)
+{
+#ifdef LINE_SCAN_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return LINE_SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return LINE_SCAN_SSE2;
+    }
+#endif
+    return LINE_SCAN_SCALAR;
+}
+
+int line_scan_use_level(int level)
+{
+    int best = line_scan_best_level();
+
+    if (level > best) {
+        level = best;
+    }
+    if (level < LINE_SCAN_SCALAR) {
+        level = LINE_SCAN_SCALAR;
+    }
+
+    g_scan_fn = scan_for_level(level);
+    return level;
+}
+
+const char *line_scan_level_name(int level)
+{
+    switch (level) {
+        case LINE_SCAN_AVX2:
+            return "avx2";
+        case LINE_SCAN_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+static line_scan_fn_t scan_for_level(int level)
+{
+#ifdef LINE_SCAN_HAVE_X86
+    if (level >= LINE_SCAN_AVX2) {
+        return scan_avx2;
+    }
+    if (level >= LINE_SCAN_SSE2) {
+        return scan_sse2;
+    }
+#else
+    (void)level;
+#endif
+    return scan_scalar;
+}
+
+static const char *scan_scalar(const char *data, size_t size, bool find_escape)
+{
+    const char *end = data + size;
+
+    while (data < end) {
+        char ch = *data;
+        if (ch == '\n' || ch == '\r' || (ch == LINE_SCAN_ESC && find_escape)) {
+            return data;
+        }
+        data++;
+    }
+
+    return NULL;
+}
+
+#ifdef LINE_SCAN_HAVE_X86
+
+__attribute__((target("sse2")))
+static const char *scan_sse2(const char *data, size_t size, bool find_escape)
+{
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    /* Without escapes, compare against '\n' twice instead of branching */
+    const __m128i esc = _mm_set1_epi8(find_escape ? LINE_SCAN_ESC : '\n');
+
+    while (size >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)data);
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, lf),
+                                                 _mm_cmpeq_epi8(block, cr)),
+                                    _mm_cmpeq_epi8(block, esc));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+
+        if (mask) {
+            return data + __builtin_ctz(mask);
+        }
+        data += 16;
+        size -= 16;
+    }
+
+    return scan_scalar(data, size, find_escape);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_avx2(const char *data, size_t size, bool find_escape)
+{
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i esc = _mm256_set1_epi8(find_escape ? LINE_SCAN_ESC : '\n');
+
+    while (size >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)data);
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, lf),
+                                                       _mm256_cmpeq_epi8(block, cr)),
+                                       _mm256_cmpeq_epi8(block, esc));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+
+        if (mask) {
+            return data + __builtin_ctz(mask);
+        }
+        data += 32;
+        size -= 32;
+    }
+
+    /* One 16-byte step for the tail, kept in this function so the CPU
+     * never switches between VEX and legacy SSE encodings mid-scan */
+    if (size >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)data);
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm256_castsi256_si128(lf)),
+                                                 _mm_cmpeq_epi8(block, _mm256_castsi256_si128(cr))),
+                                    _mm_cmpeq_epi8(block, _mm256_castsi256_si128(esc)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+
+        if (mask) {
+            return data + __builtin_ctz(mask);
+        }
+        data += 16;
+        size -= 16;
+    }
+
+    return scan_scalar(data, size, find_escape);
+}
+
+#endif /* LINE_SCAN_HAVE_X86 */
@@ -0,0 +1,68 @@
+#ifndef LINE_SCAN_H
+#define LINE_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Scanner implementations, in increasing order of width */
+#define LINE_SCAN_SCALAR 0            /* Portable byte loop */
+#define LINE_SCAN_SSE2   1            /* 16 bytes per step (x86 hosts) */
+#define LINE_SCAN_AVX2   2            /* 32 bytes per step (x86 hosts) */
+
+/**
+ * @brief Select the widest implementation this CPU supports
+ *
+ * Called by process_control_init() and cli_wrapper_init(). The choice is
+ * a plain variable, so like line_scan_use_level() this must run before
+ * any thread scans.
+ */
+void line_scan_init(void);
+
+/**
+ * @brief Find the next line delimiter or escape byte
+ *
+ * Returns a pointer to the first '\n', '\r' or (when find_escape is set)
+ * ESC (0x1B) in data. On x86 hosts this compares 16 or 32 bytes at a time
+ * once line_scan_init() has picked the widest implementation the CPU
+ * supports; until then, and on other targets, it uses the scalar loop.
+ *
+ * @param data Bytes to scan
+ * @param size Number of bytes in data
+ * @param find_escape true to stop at ESC as well
+ * @return Pointer to the first special byte, or NULL if there is none
+ */
+const char *line_scan_next(const char *data, size_t size, bool find_escape);
+
+/**
+ * @brief Widest scanner implementation this CPU supports
+ *
+ * @return LINE_SCAN_SCALAR, LINE_SCAN_SSE2 or LINE_SCAN_AVX2
+ */
+int line_scan_best_level(void);
+
+/**
+ * @brief Select the implementation used by line_scan_next()
+ *
+ * Requests above line_scan_best_level() are lowered to it. Intended for
+ * tests and benchmarks comparing the implementations, and only safe while
+ * no other thread is scanning.
+ *
+ * @param level LINE_SCAN_* implementation to use
+ * @return The level actually selected
+ */
+int line_scan_use_level(int level);
+
+/**
+ * @brief Printable name of a LINE_SCAN_* level
+ */
+const char *line_scan_level_name(int level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINE_SCAN_H */
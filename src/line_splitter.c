@@ -0,0 +1,363 @@
+#include "line_splitter.h"
+#include "line_scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Internal helper functions */
+static bool feed_chunk(line_splitter_t *splitter, char *data, size_t size, bool zero_copy,
+                       line_view_processor_t view_processor, void *user_data);
+static bool deliver_line(line_splitter_t *splitter, char *line, size_t length,
+                         line_view_processor_t view_processor, void *user_data);
+static bool emit_line(line_splitter_t *splitter,
+                      line_view_processor_t view_processor, void *user_data);
+static bool append_run(line_splitter_t *splitter, const char *data, size_t size,
+                       line_view_processor_t view_processor, void *user_data);
+static bool grow_buffer(line_splitter_t *splitter, size_t needed);
+static char *skip_escape(line_splitter_t *splitter, char *pos, char *end);
+
+void line_splitter_init(line_splitter_t *splitter, char *buffer, size_t capacity)
+{
+    if (!splitter) {
+        return;
+    }
+
+    splitter->buffer = buffer;
+    splitter->capacity = capacity;
+    splitter->length = 0;
+    splitter->max_capacity = capacity;
+    splitter->growable = false;
+    splitter->owns_buffer = false;
+    splitter->line_count = 0;
+    splitter->forced_splits = 0;
+    splitter->max_lines = 0;
+    splitter->limit_reached = false;
+    splitter->strip_escapes = false;
+    splitter->escape_state = LINE_ESCAPE_NONE;
+
+    if (buffer && capacity > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+bool line_splitter_init_growable(line_splitter_t *splitter, size_t max_line_length)
+{
+    if (!splitter) {
+        return false;
+    }
+
+    size_t capacity = LINE_SPLITTER_INITIAL_CAPACITY;
+    size_t max_capacity = max_line_length > 0 ? max_line_length + 1 : 0;
+    if (max_capacity > 0 && max_capacity < capacity) {
+        capacity = max_capacity < 2 ? 2 : max_capacity;
+    }
+
+    char *buffer = (char *)malloc(capacity);
+    line_splitter_init(splitter, buffer, buffer ? capacity : 0);
+    if (!buffer) {
+        return false;
+    }
+
+    splitter->max_capacity = max_capacity;
+    splitter->growable = true;
+    splitter->owns_buffer = true;
+    return true;
+}
+
+void line_splitter_init_growable_from(line_splitter_t *splitter, char *buffer, size_t capacity,
+                                      size_t max_line_length)
+{
+    size_t max_capacity = max_line_length > 0 ? max_line_length + 1 : 0;
+
+    if (!splitter) {
+        return;
+    }
+
+    /* A cap below the caller's buffer just uses less of it */
+    if (max_capacity > 0 && max_capacity < capacity) {
+        capacity = max_capacity < 2 ? 2 : max_capacity;
+    }
+
+    line_splitter_init(splitter, buffer, capacity);
+    splitter->max_capacity = max_capacity;
+    splitter->growable = true;
+}
+
+void line_splitter_free(line_splitter_t *splitter)
+{
+    if (!splitter || !splitter->owns_buffer) {
+        return;
+    }
+
+    free(splitter->buffer);
+    splitter->buffer = NULL;
+    splitter->capacity = 0;
+    splitter->length = 0;
+    splitter->growable = false;
+    splitter->owns_buffer = false;
+}
+
+void line_splitter_set_line_limit(line_splitter_t *splitter, uint32_t max_lines)
+{
+    if (splitter) {
+        splitter->max_lines = max_lines;
+    }
+}
+
+void line_splitter_set_strip_escapes(line_splitter_t *splitter, bool strip_escapes)
+{
+    if (splitter) {
+        splitter->strip_escapes = strip_escapes;
+        splitter->escape_state = LINE_ESCAPE_NONE;
+    }
+}
+
+bool line_splitter_feed(line_splitter_t *splitter, const char *data, size_t size,
+                        bool (*line_processor)(const char *, void *), void *user_data)
+{
+    line_view_adapter_t adapter = {line_processor, user_data};
+
+    /* Caller's chunk is read-only here, so every line goes through the buffer */
+    return feed_chunk(splitter, (char *)data, size, false, line_view_adapter, &adapter);
+}
+
+bool line_splitter_flush(line_splitter_t *splitter,
+                         bool (*line_processor)(const char *, void *), void *user_data)
+{
+    line_view_adapter_t adapter = {line_processor, user_data};
+
+    return line_splitter_flush_views(splitter, line_view_adapter, &adapter);
+}
+
+bool line_splitter_feed_views(line_splitter_t *splitter, char *data, size_t size,
+                              line_view_processor_t view_processor, void *user_data)
+{
+    return feed_chunk(splitter, data, size, true, view_processor, user_data);
+}
+
+bool line_splitter_flush_views(line_splitter_t *splitter,
+                               line_view_processor_t view_processor, void *user_data)
+{
+    if (splitter) {
+        /* An escape sequence cut off by end of output is simply dropped */
+        splitter->escape_state = LINE_ESCAPE_NONE;
+    }
+    if (!splitter || !splitter->buffer || splitter->length == 0) {
+        return true;
+    }
+
+    return emit_line(splitter, view_processor, user_data);
+}
+
+bool line_view_adapter(const char *line, size_t length, void *user_data)
+{
+    line_view_adapter_t *adapter = (line_view_adapter_t *)user_data;
+
+    (void)length;
+    return adapter->line_processor ? adapter->line_processor(line, adapter->user_data) : true;
+}
+
+static bool feed_chunk(line_splitter_t *splitter, char *data, size_t size, bool zero_copy,
+                       line_view_processor_t view_processor, void *user_data)
+{
+    if (!splitter || !splitter->buffer || splitter->capacity < 2 || !data) {
+        return false;
+    }
+
+    char *pos = data;
+    char *end = data + size;
+
+    /* Longest line delivered whole; longer ones are split in the buffer */
+    size_t split_length = splitter->capacity - 1;
+    if (splitter->growable) {
+        split_length = splitter->max_capacity > 0 ? splitter->max_capacity - 1 : (size_t)-1;
+    }
+
+    /* A line starting in this chunk is kept in place as [line_start, cursor);
+     * text after a stripped escape is moved down so the view stays contiguous */
+    bool in_chunk = zero_copy && splitter->length == 0;
+    char *line_start = data;
+    char *cursor = data;
+
+    while (pos < end) {
+        if (splitter->escape_state != LINE_ESCAPE_NONE) {
+            /* Sequence may have started in an earlier chunk */
+            pos = skip_escape(splitter, pos, end);
+            if (pos == end) {
+                break;
+            }
+        }
+
+        /* One scan finds whichever of CR, LF or ESC comes first */
+        char *special = (char *)line_scan_next(pos, (size_t)(end - pos), splitter->strip_escapes);
+
+        /* Plain text up to the next delimiter or escape */
+        char *run_end = special ? special : end;
+        size_t run_length = (size_t)(run_end - pos);
+
+        if (in_chunk && (size_t)(cursor - line_start) + run_length > split_length) {
+            /* Too long to hand out whole - continue it in the line buffer */
+            in_chunk = false;
+            if (!append_run(splitter, line_start, (size_t)(cursor - line_start),
+                            view_processor, user_data)) {
+                return false;
+            }
+        }
+        if (in_chunk) {
+            if (cursor != pos) {
+                memmove(cursor, pos, run_length);
+            }
+            cursor += run_length;
+        } else if (!append_run(splitter, pos, run_length, view_processor, user_data)) {
+            return false;
+        }
+
+        if (!special) {
+            pos = end;
+            break;
+        }
+        pos = special + 1;
+
+        if (*special == 27) {
+            splitter->escape_state = LINE_ESCAPE_START;
+            continue;
+        }
+
+        /* End of line - empty lines (also those that were only escapes) are skipped */
+        if (in_chunk) {
+            if (cursor > line_start &&
+                !deliver_line(splitter, line_start, (size_t)(cursor - line_start),
+                              view_processor, user_data)) {
+                return false;
+            }
+        } else if (splitter->length > 0 && !emit_line(splitter, view_processor, user_data)) {
+            return false;
+        }
+        in_chunk = zero_copy;
+        line_start = pos;
+        cursor = pos;
+    }
+
+    /* No delimiter left - carry the tail over to the next chunk */
+    if (in_chunk && cursor > line_start) {
+        return append_run(splitter, line_start, (size_t)(cursor - line_start),
+                          view_processor, user_data);
+    }
+
+    return true;
+}
+
+/* Consumes escape sequence bytes: ESC [ params final-letter, or ESC + one byte.
+ * A line end always terminates the sequence and is left for the caller. */
+static char *skip_escape(line_splitter_t *splitter, char *pos, char *end)
+{
+    while (pos < end && splitter->escape_state != LINE_ESCAPE_NONE) {
+        char ch = *pos;
+
+        if (ch == '\n' || ch == '\r') {
+            splitter->escape_state = LINE_ESCAPE_NONE;
+            break;
+        }
+        if (splitter->escape_state == LINE_ESCAPE_START) {
+            splitter->escape_state = ch == '[' ? LINE_ESCAPE_CSI : LINE_ESCAPE_NONE;
+        } else if (ch >= 'A' && ch <= 'z') {
+            splitter->escape_state = LINE_ESCAPE_NONE;
+        }
+        pos++;
+    }
+
+    return pos;
+}
+
+static bool deliver_line(line_splitter_t *splitter, char *line, size_t length,
+                         line_view_processor_t view_processor, void *user_data)
+{
+    if (splitter->max_lines > 0 && splitter->line_count >= splitter->max_lines) {
+        splitter->limit_reached = true;
+        return false;
+    }
+
+    /* Overwrites the delimiter (or the spare buffer byte) - views stay C strings */
+    line[length] = '\0';
+    splitter->line_count++;
+
+    if (view_processor && !view_processor(line, length, user_data)) {
+        return false;
+    }
+
+    return true;
+}
+
+static bool emit_line(line_splitter_t *splitter,
+                      line_view_processor_t view_processor, void *user_data)
+{
+    size_t length = splitter->length;
+
+    splitter->length = 0;
+    return deliver_line(splitter, splitter->buffer, length, view_processor, user_data);
+}
+
+static bool append_run(line_splitter_t *splitter, const char *data, size_t size,
+                       line_view_processor_t view_processor, void *user_data)
+{
+    /* Growable buffers expand to hold the whole line, up to max_capacity */
+    if (splitter->growable && splitter->length + size + 1 > splitter->capacity) {
+        grow_buffer(splitter, splitter->length + size + 1);
+    }
+
+    while (size > 0) {
+        size_t space = splitter->capacity - 1 - splitter->length;
+
+        if (space == 0) {
+            /* Buffer full - deliver what we have and keep going */
+            splitter->forced_splits++;
+            if (!emit_line(splitter, view_processor, user_data)) {
+                return false;
+            }
+            space = splitter->capacity - 1;
+        }
+
+        size_t copy_len = size < space ? size : space;
+        memcpy(splitter->buffer + splitter->length, data, copy_len);
+        splitter->length += copy_len;
+        data += copy_len;
+        size -= copy_len;
+    }
+
+    return true;
+}
+
+static bool grow_buffer(line_splitter_t *splitter, size_t needed)
+{
+    size_t new_capacity = splitter->capacity;
+
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    if (splitter->max_capacity > 0 && new_capacity > splitter->max_capacity) {
+        new_capacity = splitter->max_capacity;
+    }
+    if (new_capacity <= splitter->capacity) {
+        return false;
+    }
+
+    char *new_buffer;
+    if (splitter->owns_buffer) {
+        new_buffer = (char *)realloc(splitter->buffer, new_capacity);
+    } else {
+        /* First overflow of caller storage - move the partial line to the heap */
+        new_buffer = (char *)malloc(new_capacity);
+        if (new_buffer) {
+            memcpy(new_buffer, splitter->buffer, splitter->length);
+        }
+    }
+    if (!new_buffer) {
+        /* Keep the old buffer - the line is split instead of lost */
+        return false;
+    }
+
+    splitter->buffer = new_buffer;
+    splitter->owns_buffer = true;
+    splitter->capacity = new_capacity;
+    return true;
+}
+
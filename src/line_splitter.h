@@ -0,0 +1,209 @@
+#ifndef LINE_SPLITTER_H
+#define LINE_SPLITTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Incremental line assembler for streamed command output
+ *
+ * Raw read chunks are fed in as they arrive. Each chunk is scanned with
+ * line_scan_next() for '\n' / '\r' (and ESC when stripping), whole runs
+ * are copied at once and the current line length is tracked explicitly, so
+ * assembly is O(n) in the bytes read. A line split across two chunks is
+ * carried over in the line buffer, and so is a half-read escape sequence
+ * (escape_state).
+ */
+typedef struct {
+    char *buffer;                     /* Line storage */
+    size_t capacity;                  /* Size of buffer in bytes */
+    size_t length;                    /* Bytes in the current partial line */
+    size_t max_capacity;              /* Growth limit (0 = unlimited) */
+    bool growable;                    /* Buffer may grow up to max_capacity */
+    bool owns_buffer;                 /* Buffer is heap-allocated by the splitter */
+    uint32_t line_count;              /* Lines delivered so far */
+    uint32_t forced_splits;           /* Lines cut because the buffer filled */
+    uint32_t max_lines;               /* Stop after this many lines (0 = unlimited) */
+    bool limit_reached;               /* Feed stopped because of max_lines */
+    bool strip_escapes;               /* Drop ESC sequences while splitting */
+    int escape_state;                 /* LINE_ESCAPE_* - sequence in progress */
+} line_splitter_t;
+
+/* Escape sequence states carried between chunks */
+#define LINE_ESCAPE_NONE  0           /* Plain text */
+#define LINE_ESCAPE_START 1           /* ESC seen, next byte decides */
+#define LINE_ESCAPE_CSI   2           /* Inside ESC [ ... up to a letter */
+
+/**
+ * @brief Callback receiving a view of one line
+ *
+ * line points into the caller's read buffer or the splitter's line buffer
+ * and is only valid for the duration of the call. line[length] is always
+ * '\0', so the view may also be used as a C string.
+ */
+typedef bool (*line_view_processor_t)(const char *line, size_t length, void *user_data);
+
+/* Adapts a NUL-terminated line callback to line_view_processor_t */
+typedef struct {
+    bool (*line_processor)(const char *, void *);
+    void *user_data;
+} line_view_adapter_t;
+
+/* Initial size of a growable line buffer */
+#ifndef LINE_SPLITTER_INITIAL_CAPACITY
+#define LINE_SPLITTER_INITIAL_CAPACITY 256
+#endif
+
+/**
+ * @brief Initialize a line splitter over a caller-provided buffer
+ *
+ * Lines longer than capacity - 1 bytes are delivered in capacity - 1 byte
+ * pieces.
+ *
+ * @param splitter Splitter state to initialize
+ * @param buffer Storage for the line being assembled
+ * @param capacity Size of buffer in bytes (at least 2)
+ */
+void line_splitter_init(line_splitter_t *splitter, char *buffer, size_t capacity);
+
+/**
+ * @brief Initialize a line splitter with growable heap storage
+ *
+ * The buffer starts at LINE_SPLITTER_INITIAL_CAPACITY bytes and doubles
+ * whenever a line outgrows it, so long lines are delivered whole. Release
+ * the storage with line_splitter_free().
+ *
+ * @param splitter Splitter state to initialize
+ * @param max_line_length Longest line delivered whole; longer lines are
+ *                        split at this length (0 = unlimited)
+ * @return true if the initial buffer was allocated
+ * @return false on allocation failure
+ */
+bool line_splitter_init_growable(line_splitter_t *splitter, size_t max_line_length);
+
+/**
+ * @brief Initialize a growable line splitter that starts in caller storage
+ *
+ * Lines that fit in buffer are assembled there without any allocation; the
+ * first longer line moves the contents to the heap, after which the buffer
+ * grows as with line_splitter_init_growable(). Release with
+ * line_splitter_free().
+ *
+ * @param splitter Splitter state to initialize
+ * @param buffer Initial storage for the line being assembled
+ * @param capacity Size of buffer in bytes (at least 2)
+ * @param max_line_length Longest line delivered whole (0 = unlimited)
+ */
+void line_splitter_init_growable_from(line_splitter_t *splitter, char *buffer, size_t capacity,
+                                      size_t max_line_length);
+
+/**
+ * @brief Release storage owned by a growable line splitter
+ *
+ * Safe to call more than once, and on splitters that never left their
+ * caller-provided buffer (no-op).
+ *
+ * @param splitter Splitter state
+ */
+void line_splitter_free(line_splitter_t *splitter);
+
+/**
+ * @brief Limit the number of lines a splitter will deliver
+ *
+ * Once max_lines lines have been delivered, feed and flush return false and
+ * limit_reached is set so callers can tell the limit from a callback stop.
+ *
+ * @param splitter Splitter state
+ * @param max_lines Maximum lines to deliver (0 = unlimited)
+ */
+void line_splitter_set_line_limit(line_splitter_t *splitter, uint32_t max_lines);
+
+/**
+ * @brief Drop ESC / CSI sequences in the same pass that splits lines
+ *
+ * A sequence split across two chunks is still removed whole. Lines left
+ * empty once their escapes are gone are skipped like any empty line.
+ *
+ * @param splitter Splitter state
+ * @param strip_escapes true to remove escape sequences
+ */
+void line_splitter_set_strip_escapes(line_splitter_t *splitter, bool strip_escapes);
+
+/**
+ * @brief Feed a chunk of raw output into the splitter
+ *
+ * Every complete, non-empty line found is passed NUL-terminated to
+ * line_processor. Both '\n' and '\r' end a line; empty lines are skipped.
+ *
+ * @param splitter Splitter state
+ * @param data Chunk of raw output (need not be NUL-terminated)
+ * @param size Number of bytes in data
+ * @param line_processor Callback receiving each complete line
+ * @param user_data User data passed to line_processor
+ * @return true to continue reading
+ * @return false if line_processor asked to stop or the line limit was hit
+ */
+bool line_splitter_feed(line_splitter_t *splitter, const char *data, size_t size,
+                        bool (*line_processor)(const char *, void *), void *user_data);
+
+/**
+ * @brief Deliver any trailing partial line left at end of output
+ *
+ * @param splitter Splitter state
+ * @param line_processor Callback receiving the final line
+ * @param user_data User data passed to line_processor
+ * @return true if nothing was pending or line_processor accepted it
+ * @return false if line_processor asked to stop
+ */
+bool line_splitter_flush(line_splitter_t *splitter,
+                         bool (*line_processor)(const char *, void *), void *user_data);
+
+/**
+ * @brief Feed a chunk of raw output, delivering lines as in-place views
+ *
+ * Lines lying wholly inside data are handed out without being copied: the
+ * delimiter after each one is overwritten with '\0' and any escape stripping
+ * happens inside data. Only a line spanning two chunks (or one longer than
+ * the split length) is assembled in the line buffer. data is modified.
+ *
+ * @param splitter Splitter state
+ * @param data Chunk of raw output, writable (need not be NUL-terminated)
+ * @param size Number of bytes in data
+ * @param view_processor Callback receiving each complete line
+ * @param user_data User data passed to view_processor
+ * @return true to continue reading
+ * @return false if view_processor asked to stop or the line limit was hit
+ */
+bool line_splitter_feed_views(line_splitter_t *splitter, char *data, size_t size,
+                              line_view_processor_t view_processor, void *user_data);
+
+/**
+ * @brief Deliver any trailing partial line as a view
+ *
+ * @param splitter Splitter state
+ * @param view_processor Callback receiving the final line
+ * @param user_data User data passed to view_processor
+ * @return true if nothing was pending or view_processor accepted it
+ * @return false if view_processor asked to stop
+ */
+bool line_splitter_flush_views(line_splitter_t *splitter,
+                               line_view_processor_t view_processor, void *user_data);
+
+/**
+ * @brief line_view_processor_t that forwards to a NUL-terminated callback
+ *
+ * Pass a line_view_adapter_t as user_data. Views are already terminated,
+ * so no copy is made.
+ */
+bool line_view_adapter(const char *line, size_t length, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINE_SPLITTER_H */
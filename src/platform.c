@@ -0,0 +1,140 @@
+#ifndef PLATFORM_AMIGA
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "platform.h"
+
+#ifdef PLATFORM_AMIGA
+#include <proto/dos.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef PLATFORM_AMIGA
+
+/* DOS ticks per second */
+#define PLAT_TICKS_PER_SECOND 50
+
+void plat_sleep_ms(uint32_t ms)
+{
+    if (ms == 0) {
+        return;
+    }
+
+    Delay((LONG)((ms * PLAT_TICKS_PER_SECOND + 999) / 1000));
+}
+
+int plat_wait_readable(plat_handle_t handle, int32_t timeout_ms)
+{
+    if (!handle) {
+        return -1;
+    }
+
+    /* WaitForChar() has no "forever" - wait in one-second slices instead */
+    if (timeout_ms < 0) {
+        while (!WaitForChar(handle, 1000000)) {
+            /* Keep waiting */
+        }
+        return 1;
+    }
+
+    return WaitForChar(handle, (LONG)timeout_ms * 1000) ? 1 : 0;
+}
+
+uint64_t plat_monotonic_ms(void)
+{
+    struct DateStamp now;
+
+    DateStamp(&now);
+    return ((uint64_t)now.ds_Days * 24 * 60 + (uint64_t)now.ds_Minute) * 60 * 1000 +
+           (uint64_t)now.ds_Tick * (1000 / PLAT_TICKS_PER_SECOND);
+}
+
+uint32_t plat_cpu_count(void)
+{
+    return 1;
+}
+
+#else
+
+void plat_sleep_ms(uint32_t ms)
+{
+    struct timespec remaining;
+
+    remaining.tv_sec = (time_t)(ms / 1000);
+    remaining.tv_nsec = (long)(ms % 1000) * 1000000L;
+
+    /* A signal cuts the sleep short - finish the rest */
+    while (nanosleep(&remaining, &remaining) != 0 && errno == EINTR) {
+        /* Retry with what is left */
+    }
+}
+
+int plat_wait_readable(plat_handle_t handle, int32_t timeout_ms)
+{
+    uint64_t deadline = timeout_ms > 0 ? plat_monotonic_ms() + (uint64_t)timeout_ms : 0;
+
+    for (;;) {
+        struct pollfd pfd;
+        pfd.fd = handle;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready >= 0) {
+            return ready > 0 ? 1 : 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+
+        /* Interrupted - wait out whatever is left of the timeout */
+        if (timeout_ms > 0) {
+            uint64_t now = plat_monotonic_ms();
+            if (now >= deadline) {
+                return 0;
+            }
+            timeout_ms = (int32_t)(deadline - now);
+        }
+    }
+}
+
+uint64_t plat_monotonic_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)(now.tv_nsec / 1000000);
+}
+
+uint32_t plat_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+#endif
+
+void plat_backoff_init(plat_backoff_t *backoff, uint32_t min_ms, uint32_t max_ms)
+{
+    backoff->min_ms = min_ms > 0 ? min_ms : 1;
+    backoff->max_ms = max_ms > backoff->min_ms ? max_ms : backoff->min_ms;
+    backoff->wait_ms = backoff->min_ms;
+}
+
+void plat_backoff_reset(plat_backoff_t *backoff)
+{
+    backoff->wait_ms = backoff->min_ms;
+}
+
+uint32_t plat_backoff_next(plat_backoff_t *backoff)
+{
+    uint32_t wait_ms = backoff->wait_ms;
+
+    backoff->wait_ms = wait_ms > backoff->max_ms / 2 ? backoff->max_ms : wait_ms * 2;
+    return wait_ms;
+}
@@ -0,0 +1,101 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef PLATFORM_AMIGA
+#include <dos/dos.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Something that can be waited on for input */
+#ifdef PLATFORM_AMIGA
+typedef BPTR plat_handle_t;           /* DOS file handle */
+#else
+typedef int plat_handle_t;            /* File descriptor */
+#endif
+
+/* Default bounds for plat_backoff_t: one Amiga tick up to half a second */
+#define PLAT_BACKOFF_MIN_MS 20
+#define PLAT_BACKOFF_MAX_MS 500
+
+/**
+ * @brief Idle wait that starts short and doubles while nothing happens
+ *
+ * Polling loops take their next wait from plat_backoff_next() and call
+ * plat_backoff_reset() whenever something arrives, so bursts are picked up
+ * quickly and long quiet spells cost few wakeups.
+ */
+typedef struct {
+    uint32_t wait_ms;                 /* Wait returned by the next call */
+    uint32_t min_ms;                  /* Wait after a reset */
+    uint32_t max_ms;                  /* Longest wait */
+} plat_backoff_t;
+
+/**
+ * @brief Sleep without using CPU
+ *
+ * nanosleep() on host, Delay() on Amiga. Amiga sleeps are rounded up to
+ * whole ticks (20 ms).
+ *
+ * @param ms Milliseconds to sleep (0 returns at once)
+ */
+void plat_sleep_ms(uint32_t ms);
+
+/**
+ * @brief Wait until a handle has input to read
+ *
+ * poll() on host, WaitForChar() on Amiga. End of file and hangup count as
+ * readable, since the next read will report them. Interrupted waits are
+ * resumed for the remaining time.
+ *
+ * @param handle File descriptor (host) or DOS file handle (Amiga)
+ * @param timeout_ms Longest time to wait (0 = don't wait, -1 = no limit)
+ * @return 1 if the handle is readable
+ * @return 0 if the timeout expired
+ * @return -1 on error
+ */
+int plat_wait_readable(plat_handle_t handle, int32_t timeout_ms);
+
+/**
+ * @brief Milliseconds on a clock that never jumps backwards
+ *
+ * CLOCK_MONOTONIC on host. On Amiga the DOS date stamp is used, which has
+ * tick (20 ms) resolution. Only differences between two calls are
+ * meaningful.
+ */
+uint64_t plat_monotonic_ms(void);
+
+/**
+ * @brief Number of CPUs available for worker threads
+ *
+ * Online processors on host, always 1 on Amiga.
+ */
+uint32_t plat_cpu_count(void);
+
+/**
+ * @brief Set up a backoff between min_ms and max_ms
+ */
+void plat_backoff_init(plat_backoff_t *backoff, uint32_t min_ms, uint32_t max_ms);
+
+/**
+ * @brief Go back to the shortest wait - call when activity was seen
+ */
+void plat_backoff_reset(plat_backoff_t *backoff);
+
+/**
+ * @brief Wait to use now; doubles the following one up to max_ms
+ *
+ * @return Milliseconds to wait
+ */
+uint32_t plat_backoff_next(plat_backoff_t *backoff);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_H */
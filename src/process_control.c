@@ -1,4 +1,15 @@
+#ifndef PLATFORM_AMIGA
+#define _XOPEN_SOURCE 700             /* posix_openpt() and friends */
+#define _POSIX_C_SOURCE 200809L
+#ifdef __linux__
+#define _GNU_SOURCE                   /* pipe2(); syscall() for pidfd_open, wait4() */
+#endif
+#endif
+
 #include "process_control.h"
+#include "line_splitter.h"
+#include "line_scan.h"
+#include "platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,6 +21,7 @@
 #include <exec/tasks.h>
 #include <exec/memory.h>
 #include <exec/ports.h>
+#include <exec/lists.h>
 #include <dos/dos.h>
 #include <dos/dostags.h>
 #include <dos/dosextens.h>
@@ -26,6 +38,22 @@
 #endif
 
 #else
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 /* Define Amiga signal constants for compilation */
 #define SIGBREAKF_CTRL_C    (1L<<12)
 #define SIGBREAKF_CTRL_D    (1L<<13)
@@ -33,29 +61,14 @@
 #define SIGBREAKF_CTRL_F    (1L<<15)
 #define SIGBREAKF_CTRL_S    (1L<<19)  /* Pause signal */
 #define SIGBREAKF_CTRL_Q    (1L<<17)  /* Resume signal */
-#define BNULL               0L
-#define TRUE                1
-#define FALSE               0
-#define TAG_END             0L
-#define SYS_Input           1L
-#define SYS_Output          2L
-#define SYS_Error           3L
-#define SYS_Asynch          4L
-#define MODE_OLDFILE        1005L
-#define MODE_NEWFILE        1006L
-typedef void *BPTR;
-typedef long LONG;
-typedef struct Task *task_ptr;
-typedef struct TagItem { unsigned long ti_Tag; void *ti_Data; } TagItem;
-
-/* Stub functions for non-Amiga compilation */
-static BPTR Open(const char *name, long mode) { return (BPTR)1; }
-static void Close(BPTR file) { }
-static LONG Read(BPTR file, void *buffer, long length) { return 0; }
-static long SystemTagList(const char *command, struct TagItem *tags) { return 0; }
-static struct Task *FindTask(struct Task *task) { return (struct Task *)1; }
-static void Signal(struct Task *task, unsigned long signals) { }
-static unsigned long Wait(unsigned long signals) { return signals; }
+
+struct Task;
+
+/* Environment handed to spawned children */
+extern char **environ;
+
+/* Stub for non-Amiga compilation - host builds signal the child's pid */
+static void Signal(struct Task *task, unsigned long signals) { (void)task; (void)signals; }
 #endif
 
 /* Global state */
@@ -65,11 +78,72 @@ static FILE *g_process_logfile = NULL;
 /* Internal helper functions */
 static void process_log_message(const char *format, ...);
 static void process_log_timestamp(void);
+static bool open_output_reader(process_reader_t *reader, const process_exec_config_t *config);
+static void close_output_reader(process_reader_t *reader);
+static void release_output_reader(process_reader_t *reader);
+static bool start_controlled_process(const char *cmd, const char *const argv[],
+                                     const process_exec_config_t *config,
+                                     controlled_process_t *out_process);
+static bool start_polled_process(const char *cmd, const char *const argv[],
+                                 line_view_processor_t view_processor, void *user_data,
+                                 const process_exec_config_t *config,
+                                 controlled_process_t *out_process);
+static int feed_output_chunk(controlled_process_t *process, size_t size,
+                             line_view_processor_t view_processor, void *user_data);
+static void record_exit_time(controlled_process_t *process);
+static void log_process_usage(const controlled_process_t *process);
+static bool finish_controlled_process(controlled_process_t *process, bool result,
+                                      line_view_processor_t view_processor, void *user_data);
+static void finish_loop_entry(process_loop_t *loop, process_loop_entry_t *entry, bool result);
+static uint32_t stall_timeout_seconds(const process_exec_config_t *config);
 
+/* Outcome of handing one read to a process's reader */
+#define READ_STEP_DATA  0             /* Chunk consumed, keep reading */
+#define READ_STEP_EOF   1             /* Child closed its output */
+#define READ_STEP_STOP  2             /* Line processor or line limit ended reading */
+#define READ_STEP_ERROR 3             /* Read failed */
+#define READ_STEP_RETRY 4             /* Interrupted, nothing read */
+#define READ_STEP_IDLE  5             /* No output within the wait time */
+#define READ_STEP_STALLED 6           /* No output within the stall deadline */
+
+/* Marks an event loop wakeup as coming from a process's stderr pipe */
+#define PROCESS_LOOP_ERROR_EVENT 0x80000000UL
+
+#ifdef PLATFORM_AMIGA
 static bool create_process_pipes(const char *pipe_prefix, BPTR *input_pipe, BPTR *output_pipe, char *pipe_name, size_t pipe_name_size);
-static bool spawn_amiga_process(const char *cmd, const char *pipe_name, controlled_process_t *process);
-static bool read_process_output(controlled_process_t *process, bool (*line_processor)(const char *, void *), void *user_data);
+static bool spawn_amiga_process(const char *cmd, const char *const argv[], const char *pipe_name,
+                                controlled_process_t *process);
+static size_t format_amiga_command(char *dst, const char *cmd, const char *const argv[],
+                                   const char *pipe_name);
+static size_t format_amiga_arg(char *dst, const char *arg);
+static bool read_process_output(controlled_process_t *process, line_view_processor_t view_processor, void *user_data, const process_exec_config_t *config);
+static bool wait_for_process_exit(controlled_process_t *process);
 static void cleanup_amiga_process(controlled_process_t *process);
+static bool send_async_read(controlled_process_t *process);
+static LONG collect_async_read(controlled_process_t *process);
+static int poll_output_step(controlled_process_t *process, int32_t timeout_ms,
+                            line_view_processor_t view_processor, void *user_data);
+#else
+static bool spawn_host_process(const char *cmd, const char *const argv[],
+                               const process_exec_config_t *config, controlled_process_t *process);
+static bool open_host_pty(int *master_fd, int *slave_fd);
+static const posix_spawnattr_t *host_spawn_attrs(void);
+static int read_error_step(controlled_process_t *process);
+static bool drain_error_output(controlled_process_t *process);
+static bool read_process_output(controlled_process_t *process, line_view_processor_t view_processor, void *user_data, const process_exec_config_t *config);
+static int read_output_step(controlled_process_t *process, line_view_processor_t view_processor, void *user_data);
+static int poll_output_step(controlled_process_t *process, int32_t timeout_ms,
+                            line_view_processor_t view_processor, void *user_data);
+static bool wait_for_process_exit(controlled_process_t *process);
+static void cleanup_host_process(controlled_process_t *process);
+static bool reap_host_child(controlled_process_t *process);
+static void record_host_usage(controlled_process_t *process, const struct rusage *usage);
+static void record_host_end_reason(controlled_process_t *process, int status);
+static bool has_limits(const process_limits_t *limits);
+static int fork_limited_child(const char *cmd, const char *const argv[], int output_fd,
+                              int error_fd, const process_limits_t *limits, pid_t *out_pid);
+static void apply_child_limit(int resource, uint64_t value, uint64_t hard_slack);
+#endif
 
 bool process_control_init(void)
 {
@@ -88,11 +162,19 @@ bool process_control_init(void)
 #endif
     }
 
+    /* Before any reader runs, so the scanner choice is never written while
+     * another thread uses it */
+    line_scan_init();
+
     g_process_control_initialized = true;
 
     if (g_process_logfile) {
         process_log_message("=== Process Control System Initialized ===");
+#ifdef PLATFORM_AMIGA
         process_log_message("Platform: Amiga");
+#else
+        process_log_message("Platform: Host (POSIX)");
+#endif
     }
 
     return true;
@@ -114,91 +196,384 @@ bool execute_controlled_process(const char *cmd,
                                 const process_exec_config_t *config,
                                 controlled_process_t *out_process)
 {
-    if (!cmd || !config || !out_process) {
+    line_view_adapter_t adapter = {line_processor, user_data};
+
+    return execute_controlled_process_views(cmd, line_view_adapter, &adapter, config, out_process);
+}
+
+bool execute_controlled_process_views(const char *cmd,
+                                      line_view_processor_t view_processor,
+                                      void *user_data,
+                                      const process_exec_config_t *config,
+                                      controlled_process_t *out_process)
+{
+    if (!start_controlled_process(cmd, NULL, config, out_process)) {
         return false;
     }
 
-    if (!g_process_control_initialized) {
-        if (!process_control_init()) {
-            return false;
+    /* Read output and process lines */
+    bool result = read_process_output(out_process, view_processor, user_data, config);
+
+    return finish_controlled_process(out_process, result, view_processor, user_data);
+}
+
+bool execute_controlled_process_argv(const char *const argv[],
+                                     line_view_processor_t view_processor,
+                                     void *user_data,
+                                     const process_exec_config_t *config,
+                                     controlled_process_t *out_process)
+{
+    if (!argv || !argv[0] || !start_controlled_process(NULL, argv, config, out_process)) {
+        return false;
+    }
+
+    bool result = read_process_output(out_process, view_processor, user_data, config);
+
+    return finish_controlled_process(out_process, result, view_processor, user_data);
+}
+
+bool process_start(const char *cmd,
+                   line_view_processor_t view_processor,
+                   void *user_data,
+                   const process_exec_config_t *config,
+                   controlled_process_t *out_process)
+{
+    return start_polled_process(cmd, NULL, view_processor, user_data, config, out_process);
+}
+
+bool process_start_argv(const char *const argv[],
+                        line_view_processor_t view_processor,
+                        void *user_data,
+                        const process_exec_config_t *config,
+                        controlled_process_t *out_process)
+{
+    if (!argv || !argv[0]) {
+        return false;
+    }
+
+    return start_polled_process(NULL, argv, view_processor, user_data, config, out_process);
+}
+
+bool process_poll(controlled_process_t *process, int32_t timeout_ms)
+{
+    if (!process || process->output_done) {
+        return false;
+    }
+
+    int step = poll_output_step(process, timeout_ms, process->view_processor, process->user_data);
+
+#ifndef PLATFORM_AMIGA
+    uint64_t now = plat_monotonic_ms();
+    if (step == READ_STEP_IDLE && process->paused) {
+        /* Silence is expected while paused - restart the clock on resume */
+        process->last_output_ms = now;
+    } else if (step == READ_STEP_IDLE && process->timeout_seconds > 0) {
+        /* Same rule as the blocking reader: a silent process is given up on */
+        if (now - process->last_output_ms >= (uint64_t)process->timeout_seconds * 1000) {
+            process_log_message("No output from process for %lu seconds, giving up",
+                               (unsigned long)process->timeout_seconds);
+            step = READ_STEP_STALLED;
         }
+    } else {
+        process->last_output_ms = now;
     }
+#endif
 
-    /* Initialize process structure */
-    {
-        int i;
-        char *ptr = (char *)out_process;
-        for (i = 0; i < sizeof(controlled_process_t); i++) {
-            ptr[i] = 0;
+    switch (step) {
+        case READ_STEP_DATA:
+        case READ_STEP_RETRY:
+        case READ_STEP_IDLE:
+            return true;
+        case READ_STEP_EOF:
+            process->output_result = true;
+            break;
+        case READ_STEP_STOP:
+            process->output_result = process->reader.splitter.limit_reached;
+            break;
+        default:
+            process->output_result = false;
+            break;
+    }
+
+    process->output_done = true;
+    return false;
+}
+
+bool process_finish(controlled_process_t *process)
+{
+    if (!process) {
+        return false;
+    }
+
+    if (!process->output_done) {
+        process_log_message("Finishing %s before its output ended", process->process_name);
+    }
+
+    return finish_controlled_process(process, process->output_done && process->output_result,
+                                     process->view_processor, process->user_data);
+}
+
+bool process_loop_init(process_loop_t *loop)
+{
+    if (!loop) {
+        return false;
+    }
+
+    memset(loop, 0, sizeof(*loop));
+
+#ifndef PLATFORM_AMIGA
+    loop->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->poll_fd < 0) {
+        process_log_message("epoll_create1() failed, errno=%d", errno);
+        return false;
+    }
+#endif
+
+    process_log_message("Process loop initialized (%d slots)", PROCESS_LOOP_MAX_PROCESSES);
+    return true;
+}
+
+int process_loop_add(process_loop_t *loop, const char *cmd,
+                     line_view_processor_t view_processor,
+                     void (*done_processor)(controlled_process_t *, bool, void *),
+                     void *user_data,
+                     const process_exec_config_t *config,
+                     controlled_process_t *out_process)
+{
+    int index;
+
+    if (!loop) {
+        return -1;
+    }
+
+    /* Slots are reused once their process has finished */
+    for (index = 0; index < PROCESS_LOOP_MAX_PROCESSES; index++) {
+        if (!loop->entries[index].in_use) {
+            break;
         }
     }
-    
-    /* Copy process name safely */
-    {
-        int i;
-        const char *src = config->tool_name;
-        char *dst = out_process->process_name;
-        for (i = 0; i < sizeof(out_process->process_name) - 1 && src[i] != '\0'; i++) {
-            dst[i] = src[i];
+    if (index == PROCESS_LOOP_MAX_PROCESSES) {
+        process_log_message("Process loop full, cannot add: %s", cmd ? cmd : "(NULL)");
+        return -1;
+    }
+
+    if (!start_controlled_process(cmd, NULL, config, out_process)) {
+        return -1;
+    }
+
+    process_loop_entry_t *entry = &loop->entries[index];
+    memset(entry, 0, sizeof(*entry));
+    entry->process = out_process;
+    entry->view_processor = view_processor;
+    entry->done_processor = done_processor;
+    entry->user_data = user_data;
+    entry->timeout_seconds = stall_timeout_seconds(config);
+
+#ifdef PLATFORM_AMIGA
+    /* Output arrives as replies to asynchronous read packets */
+    if (!send_async_read(out_process)) {
+        cleanup_controlled_process(out_process);
+        return -1;
+    }
+#else
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = (uint32_t)index;
+    if (epoll_ctl(loop->poll_fd, EPOLL_CTL_ADD, out_process->output_fd, &event) != 0) {
+        process_log_message("epoll_ctl(ADD) failed, errno=%d", errno);
+        cleanup_controlled_process(out_process);
+        return -1;
+    }
+    if (out_process->error_fd >= 0) {
+        event.data.u32 = (uint32_t)index | PROCESS_LOOP_ERROR_EVENT;
+        if (epoll_ctl(loop->poll_fd, EPOLL_CTL_ADD, out_process->error_fd, &event) != 0) {
+            process_log_message("epoll_ctl(ADD) failed for stderr, errno=%d", errno);
+            epoll_ctl(loop->poll_fd, EPOLL_CTL_DEL, out_process->output_fd, NULL);
+            cleanup_controlled_process(out_process);
+            return -1;
         }
-        dst[i] = '\0';
     }
+    entry->last_activity_ms = plat_monotonic_ms();
+#endif
 
-    process_log_message("Starting controlled process: %s", config->tool_name);
-    process_log_message("Command: %s", cmd);
+    entry->in_use = true;
+    loop->active_count++;
 
-    char pipe_name[64];
-    
-    /* Create communication pipes */
-    if (!create_process_pipes(config->pipe_prefix, &out_process->input_pipe, 
-                             &out_process->output_pipe, pipe_name, sizeof(pipe_name))) {
-        process_log_message("Failed to create process pipes");
-        return false;
+    process_log_message("Process loop slot %d: %s (%lu active)", index, out_process->process_name,
+                       (unsigned long)loop->active_count);
+    return index;
+}
+
+int process_loop_wait(process_loop_t *loop, int32_t timeout_ms)
+{
+    int index;
+
+    if (!loop) {
+        return -1;
+    }
+    if (loop->active_count == 0) {
+        return 0;
     }
 
-    /* Spawn the process */
-    if (!spawn_amiga_process(cmd, pipe_name, out_process)) {
-        process_log_message("Failed to spawn Amiga process");
-        cleanup_amiga_process(out_process);
+#ifdef PLATFORM_AMIGA
+    ULONG wait_mask = SIGBREAKF_CTRL_C;
+
+    (void)timeout_ms;  /* No timer here - Ctrl-C is the way out */
+    for (index = 0; index < PROCESS_LOOP_MAX_PROCESSES; index++) {
+        process_loop_entry_t *entry = &loop->entries[index];
+        if (entry->in_use) {
+            wait_mask |= 1UL << entry->process->read_port->mp_SigBit;
+        }
+    }
+
+    ULONG signals = Wait(wait_mask);
+    if (signals & SIGBREAKF_CTRL_C) {
+        process_log_message("Process loop interrupted by Ctrl-C");
+        return -1;
+    }
+
+    for (index = 0; index < PROCESS_LOOP_MAX_PROCESSES; index++) {
+        process_loop_entry_t *entry = &loop->entries[index];
+        if (!entry->in_use || !(signals & (1UL << entry->process->read_port->mp_SigBit))) {
+            continue;
+        }
+
+        LONG bytes_read = collect_async_read(entry->process);
+        if (bytes_read < 0) {
+            /* Reply not there yet - the signal was for an earlier packet */
+            continue;
+        }
+
+        int step;
+        if (bytes_read == 0) {
+            entry->process->process_running = false;
+            step = READ_STEP_EOF;
+        } else {
+            step = feed_output_chunk(entry->process, (size_t)bytes_read,
+                                     entry->view_processor, entry->user_data);
+        }
+
+        if (step == READ_STEP_DATA && send_async_read(entry->process)) {
+            continue;
+        }
+        finish_loop_entry(loop, entry, step == READ_STEP_EOF ||
+                          (step == READ_STEP_STOP && entry->process->reader.splitter.limit_reached));
+    }
+#else
+    struct epoll_event events[PROCESS_LOOP_MAX_PROCESSES];
+    uint64_t now = plat_monotonic_ms();
+    int32_t wait_ms = timeout_ms;
+
+    /* Never sleep past the earliest per-process output timeout */
+    for (index = 0; index < PROCESS_LOOP_MAX_PROCESSES; index++) {
+        process_loop_entry_t *entry = &loop->entries[index];
+        if (entry->in_use && entry->timeout_seconds > 0 && !entry->process->paused) {
+            uint64_t deadline = entry->last_activity_ms + (uint64_t)entry->timeout_seconds * 1000;
+            int32_t remaining = deadline > now ? (int32_t)(deadline - now) : 0;
+            if (wait_ms < 0 || remaining < wait_ms) {
+                wait_ms = remaining;
+            }
+        }
+    }
+
+    int ready = epoll_wait(loop->poll_fd, events, PROCESS_LOOP_MAX_PROCESSES, wait_ms);
+    if (ready < 0) {
+        if (errno == EINTR) {
+            return (int)loop->active_count;
+        }
+        process_log_message("epoll_wait() failed, errno=%d", errno);
+        return -1;
+    }
+
+    now = plat_monotonic_ms();
+    for (index = 0; index < ready; index++) {
+        uint32_t data = events[index].data.u32;
+        process_loop_entry_t *entry = &loop->entries[data & ~PROCESS_LOOP_ERROR_EVENT];
+        if (!entry->in_use) {
+            continue;
+        }
+
+        int step;
+        if (data & PROCESS_LOOP_ERROR_EVENT) {
+            /* May be stale if the slot was reused - the pipe is non-blocking */
+            if (entry->process->error_fd < 0) {
+                continue;
+            }
+            step = read_error_step(entry->process);
+            if (step == READ_STEP_EOF) {
+                /* stdout decides when the process is done */
+                step = READ_STEP_DATA;
+            }
+        } else {
+            step = read_output_step(entry->process, entry->view_processor, entry->user_data);
+        }
+        entry->last_activity_ms = now;
+
+        if (step == READ_STEP_DATA || step == READ_STEP_RETRY) {
+            continue;
+        }
+        finish_loop_entry(loop, entry, step == READ_STEP_EOF ||
+                          (step == READ_STEP_STOP && entry->process->reader.splitter.limit_reached));
+    }
+
+    /* Same rule as the blocking reader: a silent process is given up on */
+    for (index = 0; index < PROCESS_LOOP_MAX_PROCESSES; index++) {
+        process_loop_entry_t *entry = &loop->entries[index];
+        if (entry->in_use && entry->process->paused) {
+            entry->last_activity_ms = now;
+        } else if (entry->in_use && entry->timeout_seconds > 0 &&
+            now - entry->last_activity_ms >= (uint64_t)entry->timeout_seconds * 1000) {
+            process_log_message("No output from %s for %lu seconds, giving up",
+                               entry->process->process_name, (unsigned long)entry->timeout_seconds);
+            finish_loop_entry(loop, entry, false);
+        }
+    }
+#endif
+
+    return (int)loop->active_count;
+}
+
+bool process_loop_run(process_loop_t *loop)
+{
+    if (!loop) {
         return false;
     }
 
-    /* Read output and process lines */
-    bool result = read_process_output(out_process, line_processor, user_data);
-    
-    /* For now, we'll attempt to capture exit code by re-running synchronously */
-    /* This is a temporary solution - in Phase 2 we'll use proper process monitoring */
-    if (result) {
-        /* Re-execute synchronously to get exit code */
-        char sync_cmd[512];
-        snprintf(sync_cmd, sizeof(sync_cmd), "%s >NIL:", cmd);
-        
-        process_log_message("Re-executing command synchronously to get exit code: %s", sync_cmd);
-        
-        struct TagItem sync_tags[] = {
-            {SYS_Input, 0},
-            {SYS_Output, 0},
-            {SYS_Error, 0},
-            {SYS_Asynch, FALSE},  /* Synchronous execution */
-            {TAG_END, 0}
-        };
-        
-        LONG exit_code = SystemTagList(sync_cmd, sync_tags);
-        out_process->exit_code = exit_code;
-        out_process->exit_code_valid = true;
-        
-        process_log_message("Command exit code: %ld", exit_code);
-        
-        /* If exit code is non-zero, consider it a warning but not a failure */
-        /* LHA returns non-zero codes for warnings (like file creation errors) */
-        if (exit_code != 0) {
-            process_log_message("Warning: Process completed with non-zero exit code: %ld", exit_code);
+    while (loop->active_count > 0) {
+        if (process_loop_wait(loop, -1) < 0) {
+            return false;
         }
     }
-    
-    process_log_message("Process completed with result: %s", result ? "success" : "failure");
-    
-    return result;
+
+    return loop->failed_count == 0;
+}
+
+void process_loop_cleanup(process_loop_t *loop)
+{
+    int index;
+
+    if (!loop) {
+        return;
+    }
+
+    /* Anything still running is abandoned; its process is cleaned up here */
+    for (index = 0; index < PROCESS_LOOP_MAX_PROCESSES; index++) {
+        process_loop_entry_t *entry = &loop->entries[index];
+        if (entry->in_use) {
+            finish_loop_entry(loop, entry, false);
+            cleanup_controlled_process(entry->process);
+        }
+    }
+
+#ifndef PLATFORM_AMIGA
+    if (loop->poll_fd >= 0) {
+        close(loop->poll_fd);
+        loop->poll_fd = -1;
+    }
+#endif
+
+    process_log_message("Process loop cleaned up, %lu failed", (unsigned long)loop->failed_count);
 }
 
 bool send_pause_signal(controlled_process_t *process)
@@ -209,6 +584,22 @@ bool send_pause_signal(controlled_process_t *process)
 
     process_log_message("Pause signal requested for process: %s", process->process_name);
 
+#ifndef PLATFORM_AMIGA
+    if (process->child_pid > 0) {
+        /* Stop the whole group - the shell and everything it started */
+        if (kill(-(pid_t)process->child_pid, SIGSTOP) != 0) {
+            process_log_message("Pause signal failed, errno=%d", errno);
+            return false;
+        }
+        process->paused = true;
+        process->pause_requested_ms = plat_monotonic_ms();
+        process->pause_last_output_ms = process->pause_requested_ms;
+        process->pause_latency_ms = 0;
+        process_log_message("Pause signal sent to process group %ld", (long)process->child_pid);
+        return true;
+    }
+#endif
+
     if (process->child_process) {
         /* Send SIGBREAKF_CTRL_S signal to pause process */
         Signal((struct Task *)process->child_process, SIGBREAKF_CTRL_S);
@@ -228,6 +619,19 @@ bool send_resume_signal(controlled_process_t *process)
 
     process_log_message("Resume signal requested for process: %s", process->process_name);
 
+#ifndef PLATFORM_AMIGA
+    if (process->child_pid > 0) {
+        if (kill(-(pid_t)process->child_pid, SIGCONT) != 0) {
+            process_log_message("Resume signal failed, errno=%d", errno);
+            return false;
+        }
+        process->paused = false;
+        process_log_message("Resume signal sent to process group %ld, pause latency was %lu ms",
+                           (long)process->child_pid, (unsigned long)process->pause_latency_ms);
+        return true;
+    }
+#endif
+
     if (process->child_process) {
         /* Send SIGBREAKF_CTRL_Q signal to resume process */
         Signal((struct Task *)process->child_process, SIGBREAKF_CTRL_Q);
@@ -247,6 +651,22 @@ bool send_terminate_signal(controlled_process_t *process)
 
     process_log_message("Terminate signal requested for process: %s", process->process_name);
 
+#ifndef PLATFORM_AMIGA
+    if (process->child_pid > 0) {
+        if (kill(-(pid_t)process->child_pid, SIGTERM) != 0) {
+            process_log_message("Terminate signal failed, errno=%d", errno);
+            return false;
+        }
+        /* A stopped group only sees SIGTERM once it runs again */
+        if (process->paused) {
+            kill(-(pid_t)process->child_pid, SIGCONT);
+            process->paused = false;
+        }
+        process_log_message("Terminate signal sent to process group %ld", (long)process->child_pid);
+        return true;
+    }
+#endif
+
     if (process->child_process) {
         /* Send SIGBREAKF_CTRL_C signal to terminate process */
         Signal((struct Task *)process->child_process, SIGBREAKF_CTRL_C);
@@ -266,23 +686,64 @@ bool wait_for_death_signal(controlled_process_t *process, uint32_t timeout_secon
 
     process_log_message("Waiting for death signal from process: %s", process->process_name);
 
-    if (process->death_signal) {
-        unsigned long signals_received;
-        
-        if (timeout_seconds > 0) {
-            /* Wait with timeout */
-            signals_received = Wait(process->death_signal | SIGBREAKF_CTRL_C);
-        } else {
-            /* Wait indefinitely */
-            signals_received = Wait(process->death_signal);
+#ifdef PLATFORM_AMIGA
+    if (!process->death_msg) {
+        return process->exit_code_valid;
+    }
+
+    /* No timer device here - check the launcher's reply once per tick */
+    ULONG ticks_left = timeout_seconds * 50;
+    while (IsListEmpty(&process->death_port->mp_MsgList)) {
+        if (timeout_seconds > 0 && ticks_left-- == 0) {
+            process_log_message("No death signal within %lu seconds", (unsigned long)timeout_seconds);
+            return false;
         }
-        
-        if (signals_received & process->death_signal) {
+        if (SetSignal(0, 0) & SIGBREAKF_CTRL_C) {
+            process_log_message("Death signal wait interrupted by Ctrl-C");
+            return false;
+        }
+        plat_sleep_ms(20);
+    }
+
+    if (wait_for_process_exit(process)) {
+        process_log_message("Death signal received from process");
+        return true;
+    }
+#else
+    uint64_t deadline = plat_monotonic_ms() + (uint64_t)timeout_seconds * 1000;
+
+    while (process->child_pid > 0) {
+        if (reap_host_child(process)) {
             process_log_message("Death signal received from process");
-            process->process_running = false;
             return true;
         }
+
+        int wait_ms = -1;
+        if (timeout_seconds > 0) {
+            uint64_t now = plat_monotonic_ms();
+            if (now >= deadline) {
+                process_log_message("No death signal within %lu seconds", (unsigned long)timeout_seconds);
+                return false;
+            }
+            wait_ms = (int)(deadline - now);
+        }
+
+        if (process->pid_fd >= 0) {
+            /* The pidfd turns readable the moment the child exits */
+            if (plat_wait_readable(process->pid_fd, wait_ms) < 0) {
+                process_log_message("Waiting on pidfd failed, errno=%d", errno);
+                return false;
+            }
+        } else {
+            /* No pidfd on this kernel - look again every 10 ms */
+            plat_sleep_ms(wait_ms >= 0 && wait_ms < 10 ? (uint32_t)wait_ms : 10);
+        }
+    }
+
+    if (process->exit_code_valid) {
+        return true;
     }
+#endif
 
     process_log_message("Death signal wait failed - no death signal set");
     return false;
@@ -290,25 +751,64 @@ bool wait_for_death_signal(controlled_process_t *process, uint32_t timeout_secon
 
 bool force_kill_process(controlled_process_t *process)
 {
-    if (!process || !process->process_running) {
+    if (!process) {
         return false;
     }
 
     process_log_message("Force kill requested for process: %s", process->process_name);
 
+#ifndef PLATFORM_AMIGA
+    if (process->child_pid > 0) {
+        /* SIGKILL cannot be caught, so only a kernel in trouble delays the reap */
+        if (kill(-(pid_t)process->child_pid, SIGKILL) != 0) {
+            kill((pid_t)process->child_pid, SIGKILL);
+        }
+        process->paused = false;
+        if (!wait_for_death_signal(process, PROCESS_KILL_REAP_SECONDS)) {
+            process_log_message("Killed process was not reaped in time");
+            return false;
+        }
+        process->process_running = false;
+        process_log_message("Process killed and reaped");
+        return true;
+    }
+#else
     if (process->child_process) {
-        /* Send SIGBREAKF_CTRL_F signal for emergency termination */
+        /* SIGBREAKF_CTRL_F for emergency termination; dead only once the launcher says so */
         Signal((struct Task *)process->child_process, SIGBREAKF_CTRL_F);
         process_log_message("Force kill signal sent to process");
+        if (!wait_for_death_signal(process, PROCESS_KILL_REAP_SECONDS)) {
+            process_log_message("Process did not exit after force kill");
+            return false;
+        }
         process->process_running = false;
         return true;
     }
+#endif
 
     process_log_message("Force kill failed - no child process");
     return false;
 }
 
-void cleanup_controlled_process(controlled_process_t *process)
+bool terminate_controlled_process(controlled_process_t *process, uint32_t grace_seconds)
+{
+    if (!process) {
+        return false;
+    }
+
+    process_log_message("Terminating %s with %lu seconds grace", process->process_name,
+                       (unsigned long)grace_seconds);
+
+    /* Give the tool a chance to clean up after itself first */
+    if (send_terminate_signal(process) && wait_for_death_signal(process, grace_seconds)) {
+        process->process_running = false;
+        return true;
+    }
+
+    return force_kill_process(process);
+}
+
+void cleanup_controlled_process(controlled_process_t *process)
 {
     if (!process) {
         return;
@@ -316,16 +816,55 @@ void cleanup_controlled_process(controlled_process_t *process)
 
     process_log_message("Cleaning up controlled process: %s", process->process_name);
 
+#ifdef PLATFORM_AMIGA
     cleanup_amiga_process(process);
+#else
+    cleanup_host_process(process);
+#endif
+
+    /* Reader normally releases its buffers itself; this covers early exits */
+    release_output_reader(&process->reader);
 
     /* Clear the structure */
     {
-        int i;
+        size_t i;
         char *ptr = (char *)process;
         for (i = 0; i < sizeof(controlled_process_t); i++) {
             ptr[i] = 0;
         }
     }
+#ifndef PLATFORM_AMIGA
+    process->output_fd = -1;
+#endif
+}
+
+bool get_process_usage(const controlled_process_t *process, process_usage_t *out_usage)
+{
+    if (!process || !out_usage) {
+        return false;
+    }
+
+    if (!process->exit_code_valid) {
+        process_log_message("Usage not available for process: %s", process->process_name);
+        return false;
+    }
+
+    *out_usage = process->usage;
+    return true;
+}
+
+bool get_process_end_reason(const controlled_process_t *process, int32_t *out_reason)
+{
+    if (!process || !out_reason) {
+        return false;
+    }
+
+    if (!process->exit_code_valid && !process->usage.cpu_valid) {
+        return false;
+    }
+
+    *out_reason = process->end_reason;
+    return true;
 }
 
 bool get_process_exit_code(const controlled_process_t *process, int32_t *out_exit_code)
@@ -347,6 +886,284 @@ bool get_process_exit_code(const controlled_process_t *process, int32_t *out_exi
 
 /* Internal helper functions */
 
+static bool open_output_reader(process_reader_t *reader, const process_exec_config_t *config)
+{
+    size_t chunk_size = config->read_chunk_size > 0 ? config->read_chunk_size
+                                                    : PROCESS_DEFAULT_READ_CHUNK;
+
+    /* Only chunks larger than the inline buffer need the heap */
+    reader->read_buffer = reader->inline_chunk;
+    if (chunk_size > sizeof(reader->inline_chunk)) {
+        reader->read_buffer = (char *)malloc(chunk_size);
+        if (!reader->read_buffer) {
+            process_log_message("Failed to allocate %lu byte read buffer", (unsigned long)chunk_size);
+            return false;
+        }
+    }
+    reader->read_size = chunk_size;
+
+    line_splitter_init_growable_from(&reader->splitter, reader->inline_line,
+                                     sizeof(reader->inline_line), config->max_line_length);
+    line_splitter_set_line_limit(&reader->splitter, config->max_lines);
+#ifdef PLATFORM_AMIGA
+    line_splitter_set_strip_escapes(&reader->splitter, config->strip_escapes);
+#else
+    /* A child that sees a terminal may add colour and cursor codes */
+    line_splitter_set_strip_escapes(&reader->splitter, config->strip_escapes || config->use_pty);
+#endif
+
+    process_log_message("Reader: %lu byte chunks, max line %lu, max lines %lu (0 = unlimited)",
+                       (unsigned long)chunk_size, (unsigned long)config->max_line_length,
+                       (unsigned long)config->max_lines);
+    return true;
+}
+
+static void close_output_reader(process_reader_t *reader)
+{
+    line_splitter_t *splitter = &reader->splitter;
+
+    if (splitter->limit_reached) {
+        process_log_message("Line limit of %lu reached, stopped reading",
+                           (unsigned long)splitter->max_lines);
+    }
+    process_log_message("Reader delivered %lu lines (%lu split at max length)",
+                       (unsigned long)splitter->line_count,
+                       (unsigned long)splitter->forced_splits);
+
+    release_output_reader(reader);
+}
+
+static void release_output_reader(process_reader_t *reader)
+{
+    line_splitter_free(&reader->splitter);
+    if (reader->read_buffer && reader->read_buffer != reader->inline_chunk) {
+        free(reader->read_buffer);
+    }
+    reader->read_buffer = NULL;
+}
+
+/* Exactly one of cmd (run by the shell) and argv (run directly) is set */
+static bool start_controlled_process(const char *cmd, const char *const argv[],
+                                     const process_exec_config_t *config,
+                                     controlled_process_t *out_process)
+{
+    if ((!cmd && !argv) || !config || !out_process) {
+        return false;
+    }
+
+    if (!g_process_control_initialized) {
+        if (!process_control_init()) {
+            return false;
+        }
+    }
+
+    /* Initialize process structure */
+    {
+        size_t i;
+        char *ptr = (char *)out_process;
+        for (i = 0; i < sizeof(controlled_process_t); i++) {
+            ptr[i] = 0;
+        }
+    }
+    
+    /* Copy process name safely */
+    {
+        size_t i;
+        const char *src = config->tool_name;
+        char *dst = out_process->process_name;
+        for (i = 0; i < sizeof(out_process->process_name) - 1 && src[i] != '\0'; i++) {
+            dst[i] = src[i];
+        }
+        dst[i] = '\0';
+    }
+
+    process_log_message("Starting controlled process: %s", config->tool_name);
+    process_log_message("Command: %s", cmd ? cmd : argv[0]);
+    out_process->start_ms = plat_monotonic_ms();
+    out_process->timeout_seconds = stall_timeout_seconds(config);
+
+#ifdef PLATFORM_AMIGA
+    char pipe_name[64];
+    
+    /* Create communication pipes */
+    if (!create_process_pipes(config->pipe_prefix, &out_process->input_pipe, 
+                             &out_process->output_pipe, pipe_name, sizeof(pipe_name))) {
+        process_log_message("Failed to create process pipes");
+        return false;
+    }
+
+    /* Spawn the process */
+    if (!spawn_amiga_process(cmd, argv, pipe_name, out_process)) {
+        process_log_message("Failed to spawn Amiga process");
+        cleanup_amiga_process(out_process);
+        return false;
+    }
+#else
+    out_process->output_fd = -1;
+    out_process->pid_fd = -1;
+    out_process->error_fd = -1;
+    out_process->limits = config->limits;
+
+    /* Spawn the child with its stdout connected to our pipe or pty */
+    if (!spawn_host_process(cmd, argv, config, out_process)) {
+        process_log_message("Failed to spawn host process");
+        cleanup_host_process(out_process);
+        return false;
+    }
+
+    if (out_process->error_fd >= 0) {
+        out_process->error_processor = config->error_processor;
+        out_process->error_user_data = config->error_user_data;
+        if (!line_splitter_init_growable(&out_process->error_splitter, config->max_line_length)) {
+            process_log_message("Failed to allocate stderr line buffer");
+            cleanup_host_process(out_process);
+            return false;
+        }
+        line_splitter_set_strip_escapes(&out_process->error_splitter, config->strip_escapes);
+    }
+#endif
+
+    if (!open_output_reader(&out_process->reader, config)) {
+        cleanup_controlled_process(out_process);
+        return false;
+    }
+
+    process_log_message("Starting to read process output");
+    return true;
+}
+
+static bool start_polled_process(const char *cmd, const char *const argv[],
+                                 line_view_processor_t view_processor, void *user_data,
+                                 const process_exec_config_t *config,
+                                 controlled_process_t *out_process)
+{
+    if (!start_controlled_process(cmd, argv, config, out_process)) {
+        return false;
+    }
+
+    out_process->view_processor = view_processor;
+    out_process->user_data = user_data;
+#ifndef PLATFORM_AMIGA
+    out_process->last_output_ms = plat_monotonic_ms();
+#endif
+
+    return true;
+}
+
+static int feed_output_chunk(controlled_process_t *process, size_t size,
+                             line_view_processor_t view_processor, void *user_data)
+{
+    process_reader_t *reader = &process->reader;
+
+    process->usage.output_bytes += size;
+
+    /* Hand the whole chunk to the splitter - lines may span chunks */
+    if (!line_splitter_feed_views(&reader->splitter, reader->read_buffer, size,
+                                  view_processor, user_data)) {
+        return READ_STEP_STOP;
+    }
+
+    return READ_STEP_DATA;
+}
+
+static void record_exit_time(controlled_process_t *process)
+{
+    process->usage.wall_ms = plat_monotonic_ms() - process->start_ms;
+}
+
+static void log_process_usage(const controlled_process_t *process)
+{
+    const process_usage_t *usage = &process->usage;
+
+    if (usage->cpu_valid) {
+        process_log_message("Usage: %lu.%03lu s user, %lu.%03lu s system, %lu KB peak RSS, "
+                           "%lu bytes output, %lu ms wall",
+                           (unsigned long)(usage->user_cpu_us / 1000000),
+                           (unsigned long)(usage->user_cpu_us / 1000 % 1000),
+                           (unsigned long)(usage->system_cpu_us / 1000000),
+                           (unsigned long)(usage->system_cpu_us / 1000 % 1000),
+                           (unsigned long)usage->max_rss_kb,
+                           (unsigned long)usage->output_bytes,
+                           (unsigned long)usage->wall_ms);
+    } else {
+        process_log_message("Usage: %lu bytes output, %lu ms wall",
+                           (unsigned long)usage->output_bytes, (unsigned long)usage->wall_ms);
+    }
+}
+
+static bool finish_controlled_process(controlled_process_t *process, bool result,
+                                      line_view_processor_t view_processor, void *user_data)
+{
+    /* Process any remaining data in line buffer */
+    if (result) {
+        line_splitter_flush_views(&process->reader.splitter, view_processor, user_data);
+    }
+
+#ifndef PLATFORM_AMIGA
+    /* stderr lines written just before exit may still be in their pipe */
+    if (result && !drain_error_output(process)) {
+        result = false;
+    }
+#endif
+
+    /* A line-limit stop leaves the child running, so it has no exit status yet */
+    bool limit_reached = process->reader.splitter.limit_reached;
+    close_output_reader(&process->reader);
+
+    process_log_message("Finished reading process output, result: %s", result ? "success" : "failure");
+
+    /* Collect the exit status from the child that actually ran */
+    if (result && wait_for_process_exit(process)) {
+        process_log_message("Command exit code: %ld", (long)process->exit_code);
+        log_process_usage(process);
+        
+        /* If exit code is non-zero, consider it a warning but not a failure */
+        /* LHA returns non-zero codes for warnings (like file creation errors) */
+        if (process->exit_code != 0) {
+            process_log_message("Warning: Process completed with non-zero exit code: %ld",
+                               (long)process->exit_code);
+        }
+    } else if (result && !limit_reached) {
+        /* Still running, or killed at the exit deadline - not a completed run */
+        result = false;
+    }
+    
+    process_log_message("Process completed with result: %s", result ? "success" : "failure");
+    
+    return result;
+}
+
+static void finish_loop_entry(process_loop_t *loop, process_loop_entry_t *entry, bool result)
+{
+    controlled_process_t *process = entry->process;
+
+#ifndef PLATFORM_AMIGA
+    epoll_ctl(loop->poll_fd, EPOLL_CTL_DEL, process->output_fd, NULL);
+    if (process->error_fd >= 0) {
+        epoll_ctl(loop->poll_fd, EPOLL_CTL_DEL, process->error_fd, NULL);
+    }
+#endif
+
+    result = finish_controlled_process(process, result, entry->view_processor, entry->user_data);
+    if (!result) {
+        loop->failed_count++;
+    }
+
+    entry->in_use = false;
+    loop->active_count--;
+
+    /* Last thing touching the entry - the callback may add a new process */
+    if (entry->done_processor) {
+        entry->done_processor(process, result, entry->user_data);
+    }
+}
+
+static uint32_t stall_timeout_seconds(const process_exec_config_t *config)
+{
+    return config->stall_timeout_seconds > 0 ? config->stall_timeout_seconds
+                                             : config->timeout_seconds;
+}
+
 static void process_log_message(const char *format, ...)
 {
     if (!g_process_logfile) {
@@ -412,51 +1229,86 @@ static bool create_process_pipes(const char *pipe_prefix, BPTR *input_pipe, BPTR
     return true;
 }
 
-static bool spawn_amiga_process(const char *cmd, const char *pipe_name, controlled_process_t *process)
+/* Command handed to the launcher process; it comes back to the parent's
+ * death port carrying the exit code once the command has finished */
+typedef struct {
+    struct Message msg;
+    LONG exit_code;
+    char command[];                   /* Allocated to fit the whole command line */
+} process_death_msg_t;
+
+static void process_launcher_entry(void)
 {
-    char full_cmd[512];
+    struct Process *self = (struct Process *)FindTask(NULL);
+    process_death_msg_t *death_msg;
+    struct TagItem tags[] = {
+        {SYS_Input, 0},
+        {SYS_Output, 0},
+        {TAG_END, 0}
+    };
     
-    /* Build command with output redirection */
-    snprintf(full_cmd, sizeof(full_cmd), "%s >%s", cmd, pipe_name);
+    WaitPort(&self->pr_MsgPort);
+    death_msg = (process_death_msg_t *)GetMsg(&self->pr_MsgPort);
     
-    process_log_message("Spawning process with command: %s", full_cmd);
+    death_msg->exit_code = SystemTagList(death_msg->command, tags);
     
+    /* Reply under Forbid() so the parent cannot free our code before we exit */
+    Forbid();
+    ReplyMsg(&death_msg->msg);
+}
+
+static bool spawn_amiga_process(const char *cmd, const char *const argv[], const char *pipe_name,
+                                controlled_process_t *process)
+{
     /* Initialize exit code fields */
     process->exit_code = 0;
     process->exit_code_valid = false;
     
 #ifdef PLATFORM_AMIGA
-    /* Try a different approach - use RunCommand instead of SystemTagList */
-    /* This might give us better process control */
-    
     /* Get current process for reference */
     struct Process *current_process = (struct Process *)FindTask(NULL);
     process_log_message("Current process: %p", current_process);
     
-    /* Create process tags for SystemTagList */
-    struct TagItem tags[] = {
-        {SYS_Input, 0},
-        {SYS_Output, 0},
-        {SYS_Error, 0},
-        {SYS_Asynch, TRUE},  /* Keep async for now - we'll enhance this in next phase */
-        {TAG_END, 0}
-    };
+    /* Port the launcher replies to once the command has finished */
+    process->death_port = CreateMsgPort();
+    if (!process->death_port) {
+        process_log_message("Failed to create death message port");
+        return false;
+    }
     
-    /* Execute command asynchronously */
-    LONG result = SystemTagList(full_cmd, tags);
-    if (result != 0) {
-        process_log_message("Failed to execute command, immediate error: %ld", result);
-        process->exit_code = result;
-        process->exit_code_valid = true;
+    /* Sized to the command, so long paths and member lists are never cut */
+    size_t command_length = format_amiga_command(NULL, cmd, argv, pipe_name);
+    process_death_msg_t *death_msg = (process_death_msg_t *)AllocVec(sizeof(process_death_msg_t) +
+                                                                   command_length + 1,
+                                                                   MEMF_PUBLIC | MEMF_CLEAR);
+    if (!death_msg) {
+        process_log_message("Failed to allocate death message");
         return false;
     }
+    format_amiga_command(death_msg->command, cmd, argv, pipe_name);
     
-    /* Wait a bit longer for process to start */
-    volatile int delay_counter;
-    for (delay_counter = 0; delay_counter < 500000; delay_counter++) {
-        /* 1 second delay to let process start */
+    process_log_message("Spawning process with command: %s", death_msg->command);
+    
+    death_msg->msg.mn_ReplyPort = process->death_port;
+    death_msg->msg.mn_Length = sizeof(process_death_msg_t);
+    
+    /* Launcher process runs the command synchronously so it owns the exit code */
+    struct Process *launcher = CreateNewProcTags(NP_Entry, (ULONG)process_launcher_entry,
+                                                 NP_Name, (ULONG)"cli_wrapper launcher",
+                                                 NP_StackSize, 8192,
+                                                 TAG_DONE);
+    if (!launcher) {
+        process_log_message("Failed to create launcher process");
+        FreeVec(death_msg);
+        return false;
     }
     
+    PutMsg(&launcher->pr_MsgPort, &death_msg->msg);
+    process->death_msg = death_msg;
+    
+    /* Wait a bit longer for process to start */
+    plat_sleep_ms(1000);
+    
     process_log_message("Attempting to find LHA child process...");
     
     /* Try different possible task names with more attempts */
@@ -475,10 +1327,7 @@ static bool spawn_amiga_process(const char *cmd, const char *pipe_name, controll
                 attempts++;
                 
                 /* Small delay between attempts */
-                volatile int small_delay;
-                for (small_delay = 0; small_delay < 100000; small_delay++) {
-                    /* 200ms delay */
-                }
+                plat_sleep_ms(200);
             }
         }
     }
@@ -506,69 +1355,161 @@ static bool spawn_amiga_process(const char *cmd, const char *pipe_name, controll
 #endif
     
     process->process_running = true;
-    process->death_signal = SIGBREAKF_CTRL_F;  /* Use CTRL+F as death signal */
+    process->death_signal = 1UL << process->death_port->mp_SigBit;
     
     process_log_message("Process spawned successfully");
     return true;
 }
 
+/* Builds "<cmd or quoted argv> >pipe_name"; with dst NULL only the length
+ * (without the terminating NUL) is worked out */
+static size_t format_amiga_command(char *dst, const char *cmd, const char *const argv[],
+                                   const char *pipe_name)
+{
+    size_t length = 0;
+    size_t i;
+
+    if (cmd) {
+        length = strlen(cmd);
+        if (dst) {
+            memcpy(dst, cmd, length);
+        }
+    } else {
+        for (i = 0; argv[i]; i++) {
+            if (i > 0) {
+                if (dst) {
+                    dst[length] = ' ';
+                }
+                length++;
+            }
+            length += format_amiga_arg(dst ? dst + length : NULL, argv[i]);
+        }
+    }
+
+    if (dst) {
+        dst[length] = ' ';
+        dst[length + 1] = '>';
+        strcpy(dst + length + 2, pipe_name);
+    }
+    return length + 2 + strlen(pipe_name);
+}
+
+/* One argument, quoted when the shell would otherwise split or redirect it.
+ * Inside quotes AmigaDOS uses '*' as its escape character. */
+static size_t format_amiga_arg(char *dst, const char *arg)
+{
+    size_t length = 0;
+    bool quote = arg[0] == '\0' || strpbrk(arg, " \t\n\";<>|*") != NULL;
+    const char *pos;
+
+    if (!quote) {
+        length = strlen(arg);
+        if (dst) {
+            memcpy(dst, arg, length);
+        }
+        return length;
+    }
+
+    if (dst) {
+        dst[length] = '"';
+    }
+    length++;
+    for (pos = arg; *pos; pos++) {
+        char escaped = 0;
+
+        if (*pos == '"' || *pos == '*') {
+            escaped = *pos;
+        } else if (*pos == '\n') {
+            escaped = 'N';
+        }
+
+        if (escaped) {
+            if (dst) {
+                dst[length] = '*';
+                dst[length + 1] = escaped;
+            }
+            length += 2;
+        } else {
+            if (dst) {
+                dst[length] = *pos;
+            }
+            length++;
+        }
+    }
+    if (dst) {
+        dst[length] = '"';
+    }
+    return length + 1;
+}
+
+static bool wait_for_process_exit(controlled_process_t *process)
+{
+    if (!process->death_msg) {
+        return process->exit_code_valid;
+    }
+    
+    /* The launcher replies with our message when SystemTagList() returns */
+    WaitPort(process->death_port);
+    process_death_msg_t *death_msg = (process_death_msg_t *)GetMsg(process->death_port);
+    if (!death_msg) {
+        return false;
+    }
+    
+    process->exit_code = death_msg->exit_code;
+    process->exit_code_valid = true;
+    process->process_running = false;
+    record_exit_time(process);
+    
+    FreeVec(death_msg);
+    process->death_msg = NULL;
+    return true;
+}
+
 static bool read_process_output(controlled_process_t *process, 
-                               bool (*line_processor)(const char *, void *), 
-                               void *user_data)
+                               line_view_processor_t view_processor, 
+                               void *user_data,
+                               const process_exec_config_t *config)
 {
     if (!process || !process->output_pipe) {
         return false;
     }
     
-    char buf[128];
-    char line[256];
-    static char line_buffer[512];
-    static size_t line_pos = 0;
+    process_reader_t *reader = &process->reader;
     
-    int empty_reads = 0;
-    const int MAX_EMPTY_READS = 50;
+    uint32_t stall_seconds = stall_timeout_seconds(config);
+    uint64_t last_output_ms = plat_monotonic_ms();
+    plat_backoff_t backoff;
     bool result = true;
     
-    process_log_message("Starting to read process output");
+    plat_backoff_init(&backoff, PLAT_BACKOFF_MIN_MS, PLAT_BACKOFF_MAX_MS);
     
-    while (process->process_running && empty_reads < MAX_EMPTY_READS) {
-        LONG bytes_read = Read(process->output_pipe, buf, sizeof(buf) - 1);
+    while (process->process_running) {
+        LONG bytes_read = Read(process->output_pipe, reader->read_buffer, (LONG)reader->read_size);
         
         if (bytes_read > 0) {
-            buf[bytes_read] = '\0';
-            empty_reads = 0;
+            /* Output is flowing - keep the next idle wait short */
+            plat_backoff_reset(&backoff);
+            last_output_ms = plat_monotonic_ms();
             
-            /* Process character by character to handle line breaks */
-            for (int i = 0; i < bytes_read; i++) {
-                char c = buf[i];
-                
-                if (c == '\n' || c == '\r') {
-                    if (line_pos > 0) {
-                        line_buffer[line_pos] = '\0';
-                        
-                        /* Copy to local buffer and process */
-                        strncpy(line, line_buffer, sizeof(line) - 1);
-                        line[sizeof(line) - 1] = '\0';
-                        
-                        if (line_processor && !line_processor(line, user_data)) {
-                            result = false;
-                            break;
-                        }
-                        
-                        line_pos = 0;
-                    }
-                } else if (line_pos < sizeof(line_buffer) - 1) {
-                    line_buffer[line_pos++] = c;
-                }
+            if (feed_output_chunk(process, (size_t)bytes_read, view_processor, user_data) == READ_STEP_STOP) {
+                result = reader->splitter.limit_reached;
+                break;
             }
         } else if (bytes_read == 0) {
-            empty_reads++;
-            
-            /* Small delay to prevent busy waiting */
-            volatile int delay_counter;
-            for (delay_counter = 0; delay_counter < 100000; delay_counter++) {
-                /* 200ms equivalent busy-wait */
+            /* Empty read after the launcher reported the exit is the real end */
+            if (!process->death_msg || !IsListEmpty(&process->death_port->mp_MsgList)) {
+                process_log_message("End of process output reached");
+                break;
             }
+            if (stall_seconds > 0 && plat_monotonic_ms() - last_output_ms >= (uint64_t)stall_seconds * 1000) {
+                process_log_message("No output from process for %lu seconds, giving up",
+                                   (unsigned long)stall_seconds);
+                result = false;
+                break;
+            }
+            
+            /* Quiet - wait longer each time, but wake as soon as output arrives */
+            plat_wait_readable(process->output_pipe, (int32_t)plat_backoff_next(&backoff));
         } else {
             process_log_message("Error reading from process output pipe");
             result = false;
@@ -576,19 +1517,76 @@ static bool read_process_output(controlled_process_t *process,
         }
     }
     
-    /* Process any remaining data in line buffer */
-    if (line_pos > 0) {
-        line_buffer[line_pos] = '\0';
-        strncpy(line, line_buffer, sizeof(line) - 1);
-        line[sizeof(line) - 1] = '\0';
-        
-        if (line_processor) {
-            line_processor(line, user_data);
+    return result;
+}
+
+static bool send_async_read(controlled_process_t *process)
+{
+    struct FileHandle *fh = (struct FileHandle *)BADDR(process->output_pipe);
+    
+    if (!process->read_port) {
+        process->read_port = CreateMsgPort();
+        process->read_packet = (struct StandardPacket *)AllocDosObject(DOS_STDPKT, NULL);
+        if (!process->read_port || !process->read_packet) {
+            process_log_message("Failed to allocate asynchronous read packet");
+            return false;
         }
     }
     
-    process_log_message("Finished reading process output, result: %s", result ? "success" : "failure");
-    return result;
+    /* Same request Read() makes, but we return before the handler answers */
+    struct DosPacket *packet = &process->read_packet->sp_Pkt;
+    packet->dp_Type = ACTION_READ;
+    packet->dp_Arg1 = fh->fh_Arg1;
+    packet->dp_Arg2 = (LONG)process->reader.read_buffer;
+    packet->dp_Arg3 = (LONG)process->reader.read_size;
+    SendPkt(packet, fh->fh_Type, process->read_port);
+    
+    process->read_pending = true;
+    return true;
+}
+
+static int poll_output_step(controlled_process_t *process, int32_t timeout_ms,
+                            line_view_processor_t view_processor, void *user_data)
+{
+    int32_t waited_ms = 0;
+    
+    if (!process->read_pending && !send_async_read(process)) {
+        return READ_STEP_ERROR;
+    }
+    
+    LONG bytes_read = collect_async_read(process);
+    while (bytes_read < 0) {
+        if (timeout_ms < 0) {
+            WaitPort(process->read_port);
+        } else if (waited_ms < timeout_ms) {
+            /* No timer device here - look again every tick */
+            plat_sleep_ms(20);
+            waited_ms += 20;
+        } else {
+            return READ_STEP_IDLE;
+        }
+        bytes_read = collect_async_read(process);
+    }
+    
+    if (bytes_read == 0) {
+        process->process_running = false;
+        return READ_STEP_EOF;
+    }
+    
+    return feed_output_chunk(process, (size_t)bytes_read, view_processor, user_data);
+}
+
+static LONG collect_async_read(controlled_process_t *process)
+{
+    if (!process->read_pending || !GetMsg(process->read_port)) {
+        return -1;
+    }
+    
+    process->read_pending = false;
+    
+    /* A failed read ends the stream like EOF does */
+    LONG bytes_read = process->read_packet->sp_Pkt.dp_Res1;
+    return bytes_read > 0 ? bytes_read : 0;
 }
 
 static void cleanup_amiga_process(controlled_process_t *process)
@@ -599,6 +1597,20 @@ static void cleanup_amiga_process(controlled_process_t *process)
     
     process_log_message("Cleaning up Amiga process resources");
     
+    /* The pipe must not close under an outstanding read packet */
+    if (process->read_pending) {
+        WaitPort(process->read_port);
+        collect_async_read(process);
+    }
+    if (process->read_packet) {
+        FreeDosObject(DOS_STDPKT, process->read_packet);
+        process->read_packet = NULL;
+    }
+    if (process->read_port) {
+        DeleteMsgPort(process->read_port);
+        process->read_port = NULL;
+    }
+    
     /* Close pipes */
     if (process->input_pipe) {
         Close(process->input_pipe);
@@ -610,6 +1622,16 @@ static void cleanup_amiga_process(controlled_process_t *process)
         process->output_pipe = 0;
     }
     
+    /* Never free the port while the launcher still owes us its reply */
+    if (process->death_msg) {
+        wait_for_process_exit(process);
+    }
+    
+    if (process->death_port) {
+        DeleteMsgPort(process->death_port);
+        process->death_port = NULL;
+    }
+    
     /* Mark process as not running */
     process->process_running = false;
     process->child_process = NULL;
@@ -617,4 +1639,545 @@ static void cleanup_amiga_process(controlled_process_t *process)
     process_log_message("Amiga process cleanup completed");
 }
 
+#else
+
+static bool spawn_host_process(const char *cmd, const char *const argv[],
+                               const process_exec_config_t *config, controlled_process_t *process)
+{
+    bool use_pty = config->use_pty;
+    int pipe_fds[2];
+    int error_fds[2] = {-1, -1};
+    pid_t pid;
+
+    /* Initialize exit code fields */
+    process->exit_code = 0;
+    process->exit_code_valid = false;
+
+    if (use_pty) {
+        /* Same layout as a pipe: [0] is read by us, [1] is the child's stdout */
+        if (!open_host_pty(&pipe_fds[0], &pipe_fds[1])) {
+            return false;
+        }
+    } else if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+        /* Atomically close-on-exec: another thread may spawn at any moment,
+         * and a child holding our write end would keep us from seeing EOF */
+        process_log_message("Failed to create output pipe, errno=%d", errno);
+        return false;
+    }
+
+    if (config->error_processor) {
+        if (pipe2(error_fds, O_CLOEXEC) != 0) {
+            process_log_message("Failed to create error pipe, errno=%d", errno);
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+            return false;
+        }
+        /* Non-blocking, so a stale readiness report can never stall a read */
+        fcntl(error_fds[0], F_SETFL, O_NONBLOCK);
+    }
+
+    if (cmd) {
+        process_log_message("Spawning process with command: /bin/sh -c %s%s%s", cmd,
+                           use_pty ? " (output on pty)" : "",
+                           error_fds[0] >= 0 ? " (stderr captured)" : "");
+    } else {
+        process_log_message("Spawning process directly: %s%s%s", argv[0],
+                           use_pty ? " (output on pty)" : "",
+                           error_fds[0] >= 0 ? " (stderr captured)" : "");
+    }
+
+    /* Every end is close-on-exec; the child gets its own through dup2()
+     * below, which clears the flag on the copy */
+    /* posix_spawn() lets the C library use vfork semantics: no copy of our
+     * address space is made, however large the parent has grown */
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    if (error_fds[1] >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, error_fds[1], STDERR_FILENO);
+    }
+
+    int spawn_error;
+    if (has_limits(&config->limits)) {
+        /* Limits must be set in the child, which posix_spawn() has no hook for */
+        spawn_error = fork_limited_child(cmd, argv, pipe_fds[1], error_fds[1],
+                                         &config->limits, &pid);
+    } else if (argv) {
+        /* posix_spawnp() takes char *const[], but never writes through it */
+        spawn_error = posix_spawnp(&pid, argv[0], &actions, host_spawn_attrs(),
+                                   (char *const *)argv, environ);
+    } else {
+        const char *shell_argv[] = {"sh", "-c", cmd, NULL};
+        spawn_error = posix_spawn(&pid, "/bin/sh", &actions, host_spawn_attrs(),
+                                  (char *const *)shell_argv, environ);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (spawn_error != 0) {
+        process_log_message("Failed to spawn %s, error=%d", argv ? argv[0] : "/bin/sh", spawn_error);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        if (error_fds[0] >= 0) {
+            close(error_fds[0]);
+            close(error_fds[1]);
+        }
+        return false;
+    }
+
+    /* Also set from the parent so the group exists before we signal it,
+     * whichever side runs first (fails harmlessly once the child has exec'd) */
+    setpgid(pid, pid);
+
+    /* Parent keeps only the read end so EOF arrives when the child exits */
+    close(pipe_fds[1]);
+    if (error_fds[1] >= 0) {
+        close(error_fds[1]);
+    }
+
+    process->child_pid = (int32_t)pid;
+    process->output_fd = pipe_fds[0];
+    process->output_is_pty = use_pty;
+    process->error_fd = error_fds[0];
+
+#ifdef SYS_pidfd_open
+    /* Readable once the child exits - lets death waits sleep instead of polling */
+    process->pid_fd = (int)syscall(SYS_pidfd_open, pid, 0);  /* Always close-on-exec */
+#endif
+    process->process_running = true;
+    process->death_signal = SIGBREAKF_CTRL_F;  /* Use CTRL+F as death signal */
+
+    process_log_message("Process spawned successfully, pid=%ld", (long)pid);
+    return true;
+}
+
+static bool has_limits(const process_limits_t *limits)
+{
+    return limits->max_address_space > 0 || limits->max_cpu_seconds > 0 ||
+           limits->max_file_size > 0 || limits->max_open_files > 0;
+}
+
+/* Same child setup as the posix_spawn() path, plus setrlimit() before exec */
+static int fork_limited_child(const char *cmd, const char *const argv[], int output_fd,
+                              int error_fd, const process_limits_t *limits, pid_t *out_pid)
+{
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        return errno;
+    }
+
+    if (pid == 0) {
+        /* Child: only async-signal-safe calls until exec */
+        setpgid(0, 0);
+        dup2(output_fd, STDOUT_FILENO);
+        if (error_fd >= 0) {
+            dup2(error_fd, STDERR_FILENO);
+        }
+
+        apply_child_limit(RLIMIT_AS, limits->max_address_space, 0);
+        /* One second of grace turns an ignored SIGXCPU into SIGKILL */
+        apply_child_limit(RLIMIT_CPU, limits->max_cpu_seconds, 1);
+        apply_child_limit(RLIMIT_FSIZE, limits->max_file_size, 0);
+        apply_child_limit(RLIMIT_NOFILE, limits->max_open_files, 0);
+
+        if (argv) {
+            execvp(argv[0], (char *const *)argv);
+        } else {
+            execl("/bin/sh", "sh", "-c", cmd, (char *)NULL);
+        }
+        _exit(127);
+    }
+
+    *out_pid = pid;
+    return 0;
+}
+
+static void apply_child_limit(int resource, uint64_t value, uint64_t hard_slack)
+{
+    struct rlimit limit;
+
+    if (value == 0 || getrlimit(resource, &limit) != 0) {
+        return;
+    }
+
+    /* Only root may raise a hard limit - never ask for more than we have */
+    if (limit.rlim_max == RLIM_INFINITY || value + hard_slack < (uint64_t)limit.rlim_max) {
+        limit.rlim_max = (rlim_t)(value + hard_slack);
+    }
+    limit.rlim_cur = value < (uint64_t)limit.rlim_max ? (rlim_t)value : limit.rlim_max;
+    setrlimit(resource, &limit);
+}
+
+/* Every child gets its own process group, so pause and resume reach all of
+ * its descendants. The attributes never change and are built once. */
+static posix_spawnattr_t g_spawn_attrs;
+static pthread_once_t g_spawn_attrs_once = PTHREAD_ONCE_INIT;
+
+static void init_spawn_attrs(void)
+{
+    posix_spawnattr_init(&g_spawn_attrs);
+    posix_spawnattr_setflags(&g_spawn_attrs, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&g_spawn_attrs, 0);
+}
+
+/* Threads may spawn their first children at the same time */
+static const posix_spawnattr_t *host_spawn_attrs(void)
+{
+    pthread_once(&g_spawn_attrs_once, init_spawn_attrs);
+    return &g_spawn_attrs;
+}
+
+static bool open_host_pty(int *master_fd, int *slave_fd)
+{
+    struct termios attrs;
+    const char *slave_name;
+
+    /* Close-on-exec from the start, so a child another thread spawns
+     * meanwhile cannot inherit either end */
+    *master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (*master_fd < 0) {
+        process_log_message("Failed to open pseudo-terminal, errno=%d", errno);
+        return false;
+    }
+
+    if (grantpt(*master_fd) != 0 || unlockpt(*master_fd) != 0 ||
+        (slave_name = ptsname(*master_fd)) == NULL) {
+        process_log_message("Failed to set up pseudo-terminal, errno=%d", errno);
+        close(*master_fd);
+        return false;
+    }
+
+    *slave_fd = open(slave_name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (*slave_fd < 0) {
+        process_log_message("Failed to open %s, errno=%d", slave_name, errno);
+        close(*master_fd);
+        return false;
+    }
+
+    /* No LF -> CRLF translation and no echo - only what the child wrote */
+    if (tcgetattr(*slave_fd, &attrs) == 0) {
+        attrs.c_oflag &= ~(tcflag_t)OPOST;
+        attrs.c_lflag &= ~(tcflag_t)ECHO;
+        tcsetattr(*slave_fd, TCSANOW, &attrs);
+    }
+
+    return true;
+}
+
+static bool read_process_output(controlled_process_t *process, 
+                               line_view_processor_t view_processor, 
+                               void *user_data,
+                               const process_exec_config_t *config)
+{
+    if (!process || process->output_fd < 0) {
+        return false;
+    }
+
+    /* Timeout covers the gap between two chunks, not the whole run */
+    uint32_t timeout_seconds = stall_timeout_seconds(config);
+    int32_t timeout_ms = timeout_seconds > 0 ? (int32_t)(timeout_seconds * 1000) : -1;
+
+    while (process->process_running) {
+        int step = poll_output_step(process, timeout_ms, view_processor, user_data);
+
+        if (step == READ_STEP_IDLE && process->paused) {
+            /* Silence is expected while paused */
+            continue;
+        }
+        if (step == READ_STEP_IDLE) {
+            process_log_message("No output from process for %lu seconds, giving up",
+                               (unsigned long)timeout_seconds);
+            return false;
+        }
+        if (step == READ_STEP_STOP) {
+            return process->reader.splitter.limit_reached;
+        }
+        if (step == READ_STEP_ERROR) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int poll_output_step(controlled_process_t *process, int32_t timeout_ms,
+                            line_view_processor_t view_processor, void *user_data)
+{
+    if (process->error_fd >= 0) {
+        /* Both streams in one wait, so neither pipe can fill up and block the child */
+        struct pollfd fds[2];
+        fds[0].fd = process->output_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = process->error_fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        int ready = poll(fds, 2, timeout_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                return READ_STEP_RETRY;
+            }
+            process_log_message("Waiting on process output pipes failed, errno=%d", errno);
+            return READ_STEP_ERROR;
+        }
+        if (ready == 0) {
+            return READ_STEP_IDLE;
+        }
+        /* stdout first - whatever the child wrote there before an error line is kept */
+        int step = READ_STEP_DATA;
+        if (fds[0].revents) {
+            step = read_output_step(process, view_processor, user_data);
+        }
+        if (fds[1].revents && step == READ_STEP_DATA && read_error_step(process) == READ_STEP_STOP) {
+            return READ_STEP_STOP;
+        }
+
+        return step;
+    }
+
+    int ready = plat_wait_readable(process->output_fd, timeout_ms);
+    if (ready < 0) {
+        process_log_message("Waiting on process output pipe failed, errno=%d", errno);
+        return READ_STEP_ERROR;
+    }
+    if (ready == 0) {
+        return READ_STEP_IDLE;
+    }
+
+    return read_output_step(process, view_processor, user_data);
+}
+
+static int read_error_step(controlled_process_t *process)
+{
+    process_reader_t *reader = &process->reader;
+
+    ssize_t bytes_read = read(process->error_fd, reader->read_buffer, reader->read_size);
+    if (bytes_read < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+            return READ_STEP_RETRY;
+        }
+        process_log_message("Error reading from process error pipe, errno=%d", errno);
+    }
+    if (bytes_read <= 0) {
+        /* stderr closed - deliver a last unterminated line and stop watching it */
+        bool keep_going = line_splitter_flush_views(&process->error_splitter,
+                                                    process->error_processor,
+                                                    process->error_user_data);
+        close(process->error_fd);
+        process->error_fd = -1;
+        return keep_going ? READ_STEP_EOF : READ_STEP_STOP;
+    }
+
+    /* Shares the stdout read buffer - stdout lines are never left pointing into it */
+    if (!line_splitter_feed_views(&process->error_splitter, reader->read_buffer, (size_t)bytes_read,
+                                  process->error_processor, process->error_user_data)) {
+        process_log_message("Error line processor stopped %s", process->process_name);
+        return READ_STEP_STOP;
+    }
+
+    return READ_STEP_DATA;
+}
+
+static bool drain_error_output(controlled_process_t *process)
+{
+    int step = READ_STEP_DATA;
+
+    while (process->error_fd >= 0 && step == READ_STEP_DATA) {
+        step = read_error_step(process);
+    }
+
+    return step != READ_STEP_STOP;
+}
+
+static int read_output_step(controlled_process_t *process,
+                            line_view_processor_t view_processor, void *user_data)
+{
+    process_reader_t *reader = &process->reader;
+
+    ssize_t bytes_read = read(process->output_fd, reader->read_buffer, reader->read_size);
+    if (bytes_read < 0 && errno == EIO && process->output_is_pty) {
+        /* A pty master reports the last slave closing as EIO, not EOF */
+        bytes_read = 0;
+    }
+    if (bytes_read < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+            return READ_STEP_RETRY;
+        }
+        process_log_message("Error reading from process output pipe, errno=%d", errno);
+        return READ_STEP_ERROR;
+    }
+    if (bytes_read == 0) {
+        /* All writers closed the pipe - the child is done producing output */
+        process_log_message("End of process output reached");
+        process->process_running = false;
+        return READ_STEP_EOF;
+    }
+
+    /* Output still arriving after a pause was requested */
+    if (process->paused) {
+        process->pause_last_output_ms = plat_monotonic_ms();
+        process->pause_latency_ms = (uint32_t)(process->pause_last_output_ms -
+                                               process->pause_requested_ms);
+    }
+
+    return feed_output_chunk(process, (size_t)bytes_read, view_processor, user_data);
+}
+
+static bool wait_for_process_exit(controlled_process_t *process)
+{
+    if (process->child_pid <= 0) {
+        return process->exit_code_valid;
+    }
+
+    /* Output stopped without EOF (timeout) - a blocking wait could hang */
+    if (process->process_running) {
+        process_log_message("Child %ld has not closed its output, exit code unavailable",
+                           (long)process->child_pid);
+        return false;
+    }
+
+    /* Closing stdout/stderr does not mean exiting: a child may keep running
+     * without output, so the reap gets a deadline like the reads had */
+    uint32_t wait_seconds = process->timeout_seconds > 0 ? process->timeout_seconds
+                                                         : PROCESS_EXIT_WAIT_SECONDS;
+    if (wait_for_death_signal(process, wait_seconds)) {
+        return true;
+    }
+
+    process_log_message("Child %ld still running %lu seconds after closing its output",
+                       (long)process->child_pid, (unsigned long)wait_seconds);
+    terminate_controlled_process(process, PROCESS_EXIT_GRACE_SECONDS);
+    return false;
+}
+
+static bool reap_host_child(controlled_process_t *process)
+{
+    pid_t pid = (pid_t)process->child_pid;
+    pid_t reaped;
+    int status;
+    struct rusage usage;
+
+    /* wait4() hands back the child's rusage along with its status */
+    while ((reaped = wait4(pid, &status, WNOHANG, &usage)) < 0) {
+        if (errno != EINTR) {
+            process_log_message("wait4() failed for child %ld, errno=%d", (long)pid, errno);
+            return false;
+        }
+    }
+    if (reaped == 0) {
+        return false;
+    }
+
+    process->child_pid = 0;
+    record_host_usage(process, &usage);
+
+    if (WIFEXITED(status)) {
+        process->exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        /* Same convention as the shell: 128 + signal number */
+        process_log_message("Child %ld terminated by signal %d", (long)pid, WTERMSIG(status));
+        process->exit_code = 128 + WTERMSIG(status);
+    } else {
+        return false;
+    }
+
+    record_host_end_reason(process, status);
+    process->exit_code_valid = true;
+    return true;
+}
+
+static void record_host_usage(controlled_process_t *process, const struct rusage *usage)
+{
+    process->usage.user_cpu_us = (uint64_t)usage->ru_utime.tv_sec * 1000000 +
+                                 (uint64_t)usage->ru_utime.tv_usec;
+    process->usage.system_cpu_us = (uint64_t)usage->ru_stime.tv_sec * 1000000 +
+                                   (uint64_t)usage->ru_stime.tv_usec;
+#ifdef __APPLE__
+    process->usage.max_rss_kb = (uint64_t)usage->ru_maxrss / 1024;  /* Bytes on macOS */
+#else
+    process->usage.max_rss_kb = (uint64_t)usage->ru_maxrss;
+#endif
+    process->usage.cpu_valid = true;
+    record_exit_time(process);
+}
+
+static void record_host_end_reason(controlled_process_t *process, int status)
+{
+    const process_limits_t *limits = &process->limits;
+    int32_t reason = PROCESS_END_NORMAL;
+
+    if (WIFSIGNALED(status)) {
+        int signal_number = WTERMSIG(status);
+        uint64_t cpu_us = process->usage.user_cpu_us + process->usage.system_cpu_us;
+
+        reason = PROCESS_END_SIGNAL;
+        if (signal_number == SIGXCPU ||
+            (signal_number == SIGKILL && limits->max_cpu_seconds > 0 &&
+             cpu_us >= (uint64_t)limits->max_cpu_seconds * 1000000)) {
+            reason = PROCESS_END_CPU_LIMIT;
+        } else if (signal_number == SIGXFSZ) {
+            reason = PROCESS_END_FILE_LIMIT;
+        } else if (limits->max_address_space > 0 &&
+                   (signal_number == SIGSEGV || signal_number == SIGBUS ||
+                    signal_number == SIGABRT) &&
+                   process->usage.max_rss_kb * 1024 * 100 >=
+                   limits->max_address_space * PROCESS_MEMORY_LIMIT_RSS_PERCENT) {
+            /* A crash is only a guess at the limit, so it needs the child to
+             * have actually been using most of its address space */
+            reason = PROCESS_END_MEMORY_LIMIT;
+        }
+    }
+
+    if (reason == PROCESS_END_MEMORY_LIMIT) {
+        process_log_message("Child crashed with %lu KB resident, probably at its address space limit",
+                           (unsigned long)process->usage.max_rss_kb);
+    } else if (reason >= PROCESS_END_CPU_LIMIT) {
+        process_log_message("Child stopped by its %s limit",
+                           reason == PROCESS_END_CPU_LIMIT ? "CPU time" : "file size");
+    }
+    process->end_reason = reason;
+}
+
+static void cleanup_host_process(controlled_process_t *process)
+{
+    if (!process) {
+        return;
+    }
+
+    process_log_message("Cleaning up host process resources");
+
+    /* Before the pidfd is closed, since the bounded wait below uses it */
+    if (process->child_pid > 0 && !reap_host_child(process)) {
+        /* A child we stopped reading early (callback abort or timeout) may
+         * still be running - kill it rather than wait without a limit. This
+         * only avoids a zombie; its status is cleared with the structure */
+        process_log_message("Child %ld still running, killing it", (long)process->child_pid);
+        if (!force_kill_process(process)) {
+            process_log_message("Child %ld could not be reaped, leaving it", (long)process->child_pid);
+        }
+        process->child_pid = 0;
+    }
+
+    if (process->output_fd >= 0) {
+        close(process->output_fd);
+        process->output_fd = -1;
+    }
+
+    if (process->pid_fd >= 0) {
+        close(process->pid_fd);
+        process->pid_fd = -1;
+    }
+
+    if (process->error_fd >= 0) {
+        close(process->error_fd);
+        process->error_fd = -1;
+    }
+    line_splitter_free(&process->error_splitter);
+
+    process->process_running = false;
+
+    process_log_message("Host process cleanup completed");
+}
+
 #endif
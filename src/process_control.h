@@ -3,17 +3,118 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "line_splitter.h"
 
 #ifdef PLATFORM_AMIGA
 #include <exec/types.h>
 #include <exec/tasks.h>
+#include <exec/ports.h>
 #include <dos/dos.h>
+#include <dos/dosextens.h>
 #endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Bytes requested per read when read_chunk_size is 0. Also the size of the
+ * reader's inline chunk buffer, so Amiga keeps it small for 4 KB stacks. */
+#ifndef PROCESS_DEFAULT_READ_CHUNK
+#ifdef PLATFORM_AMIGA
+#define PROCESS_DEFAULT_READ_CHUNK 512
+#else
+#define PROCESS_DEFAULT_READ_CHUNK 4096
+#endif
+#endif
+
+/* Lines up to this length are assembled without touching the heap */
+#ifndef PROCESS_READER_INLINE_LINE
+#define PROCESS_READER_INLINE_LINE 256
+#endif
+
+/* Longest wait for a killed child to be confirmed dead */
+#ifndef PROCESS_KILL_REAP_SECONDS
+#define PROCESS_KILL_REAP_SECONDS 2
+#endif
+
+/* How long a child may keep running after closing its output, when no
+ * stall timeout is set, before it is terminated */
+#ifndef PROCESS_EXIT_WAIT_SECONDS
+#define PROCESS_EXIT_WAIT_SECONDS 10
+#endif
+
+/* Grace given to such a child between the terminate signal and the kill */
+#ifndef PROCESS_EXIT_GRACE_SECONDS
+#define PROCESS_EXIT_GRACE_SECONDS 1
+#endif
+
+/* Peak RSS, as a percentage of max_address_space, at which a crash is
+ * put down to the limit rather than to a bug in the tool */
+#ifndef PROCESS_MEMORY_LIMIT_RSS_PERCENT
+#define PROCESS_MEMORY_LIMIT_RSS_PERCENT 75
+#endif
+
+/* Processes a single process_loop_t can run at once */
+#ifndef PROCESS_LOOP_MAX_PROCESSES
+#define PROCESS_LOOP_MAX_PROCESSES 32
+#endif
+
+/**
+ * @brief Output reader state owned by one controlled process
+ *
+ * Holds everything the reader keeps between two reads, so no line state is
+ * shared between processes and several can be read at once. With default
+ * sizes both buffers are the inline arrays and reading allocates nothing.
+ */
+typedef struct {
+    line_splitter_t splitter;         /* Partial line and escape state */
+    char *read_buffer;                /* inline_chunk, or heap for larger chunks */
+    size_t read_size;                 /* Bytes requested per read */
+    char inline_chunk[PROCESS_DEFAULT_READ_CHUNK];
+    char inline_line[PROCESS_READER_INLINE_LINE];
+} process_reader_t;
+
+/**
+ * @brief What a child cost to run
+ *
+ * output_bytes counts everything read from the child's output (stdout or
+ * pty, not stderr) and wall_ms runs from spawn to the exit being
+ * collected. CPU times and peak RSS come from wait4() on host and cover the
+ * child and any of its descendants it waited for (the shell and the tool
+ * it ran, for command strings). The Amiga has no per-task accounting, so
+ * cpu_valid stays false there.
+ */
+typedef struct {
+    uint64_t user_cpu_us;             /* CPU time in user mode */
+    uint64_t system_cpu_us;           /* CPU time in the kernel */
+    uint64_t max_rss_kb;              /* Peak resident set size */
+    uint64_t output_bytes;            /* Bytes read from the output pipe */
+    uint64_t wall_ms;                 /* Spawn to exit, 0 until collected */
+    bool cpu_valid;                   /* CPU and RSS fields were filled in */
+} process_usage_t;
+
+/* How a child's run ended, see get_process_end_reason() */
+#define PROCESS_END_NORMAL      0     /* Exited by itself, whatever its exit code */
+#define PROCESS_END_SIGNAL      1     /* Killed by a signal not tied to a limit */
+#define PROCESS_END_CPU_LIMIT   2     /* Ran out of max_cpu_seconds */
+#define PROCESS_END_FILE_LIMIT  3     /* Wrote past max_file_size */
+#define PROCESS_END_MEMORY_LIMIT 4    /* Crashed with its peak RSS near max_address_space */
+
+/**
+ * @brief Resource limits applied to a child before it runs (host only)
+ *
+ * Fields left at 0 mean no limit. A limit above the parent's own hard limit
+ * is lowered to it. Setting any field makes the host backend start the
+ * child with fork() instead of posix_spawn(), since limits have to be set
+ * between the two halves of the spawn.
+ */
+typedef struct {
+    uint64_t max_address_space;       /* Bytes of virtual memory (RLIMIT_AS) */
+    uint32_t max_cpu_seconds;         /* CPU time (RLIMIT_CPU) */
+    uint64_t max_file_size;           /* Bytes in any one file written (RLIMIT_FSIZE) */
+    uint32_t max_open_files;          /* Open descriptors (RLIMIT_NOFILE) */
+} process_limits_t;
+
 /**
  * @brief Process control structure for managing child processes
  */
@@ -23,27 +124,90 @@ typedef struct {
     BPTR input_pipe;                  /* To send commands to child */
     BPTR output_pipe;                 /* To receive output from child */
     ULONG death_signal;               /* Signal mask for death notification */
+    struct MsgPort *death_port;       /* Launcher replies here on exit */
+    void *death_msg;                  /* Outstanding launcher message */
     LONG exit_code;                   /* Exit code from process */
+    struct MsgPort *read_port;        /* Event loop: async read replies */
+    struct StandardPacket *read_packet; /* Event loop: outstanding ACTION_READ */
+    bool read_pending;                /* read_packet not yet replied */
 #else
-    void *child_process;              /* Host stub */
-    void *input_pipe;                 /* Host stub */
-    void *output_pipe;                /* Host stub */
+    void *child_process;              /* Host stub (signals not yet wired) */
+    int32_t child_pid;                /* Host: pid of the spawned shell */
+    int output_fd;                    /* Host: read end of the stdout pipe, or pty master */
+    bool output_is_pty;               /* Host: output_fd is a pty master (EIO means EOF) */
+    int error_fd;                     /* Host: read end of the stderr pipe, -1 if not captured */
+    line_splitter_t error_splitter;   /* Host: partial stderr line */
+    line_view_processor_t error_processor; /* Host: receives stderr lines */
+    void *error_user_data;            /* Host: passed to error_processor */
+    int pid_fd;                       /* Host: pidfd of the child, -1 if unsupported */
+    process_limits_t limits;          /* Host: limits the child was started with */
     uint32_t death_signal;            /* Host stub */
-    int32_t exit_code;                /* Host stub */
+    int32_t exit_code;                /* Exit code from process */
+    uint64_t last_output_ms;          /* Host: monotonic time of the last read */
+    bool paused;                      /* Host: process group is stopped */
+    uint64_t pause_requested_ms;      /* Host: monotonic time of the last pause */
+    uint64_t pause_last_output_ms;    /* Host: last output read after that pause */
+    uint32_t pause_latency_ms;        /* Host: pause request to last output byte */
 #endif
     bool process_running;             /* Current status flag */
     bool exit_code_valid;             /* True if exit_code contains valid data */
+    int32_t end_reason;               /* PROCESS_END_* once the exit is collected */
+    uint64_t start_ms;                /* Monotonic time of the spawn */
+    process_usage_t usage;            /* Resource use, complete once the exit is collected */
     char process_name[32];            /* For debugging */
+    line_view_processor_t view_processor; /* process_start(): receives lines */
+    void *user_data;                  /* process_start(): passed to view_processor */
+    uint32_t timeout_seconds;         /* Stall deadline, also bounds the exit wait (0 = none) */
+    bool output_done;                 /* process_poll(): reading has ended */
+    bool output_result;               /* process_poll(): how reading ended */
+    process_reader_t reader;          /* Output reader state */
 } controlled_process_t;
 
 /**
  * @brief Configuration for process execution
+ *
+ * The reader fields may be left zero: lines are then read in
+ * PROCESS_DEFAULT_READ_CHUNK byte chunks, stored in a buffer that grows to
+ * fit the longest line, and never capped in number.
+ *
+ * A process that produces no output for the stall deadline is given up on.
+ * The deadline is measured on a monotonic clock from the last chunk read,
+ * not counted in polls, so a slow member that pauses output is not cut off
+ * early. Pausing the process suspends it.
+ *
+ * Many tools switch stdout to full buffering when it is a pipe, so progress
+ * lines arrive in 4 KB bursts or only at exit. With use_pty set (host only)
+ * the child writes to a pseudo-terminal instead and line-buffers as it
+ * would on a console. Output post-processing is turned off on the terminal
+ * so lines end in plain LF, and escape sequences are stripped as if
+ * strip_escapes were set. The Amiga backend ignores the flag.
+ *
+ * With error_processor set (host only) the child's stderr goes to a pipe
+ * of its own, read in the same wait as stdout and split into lines with
+ * the same limits. Returning false from error_processor stops the job at
+ * once and the run is reported as failed, so a tool's first error line
+ * can abort it without scanning every stdout line for error text.
+ * Otherwise stderr is inherited as before.
+ *
+ * limits caps what a runaway tool can take (host only). A tool fed a
+ * hostile archive that spins or balloons is stopped by the kernel instead
+ * of starving every other job, and get_process_end_reason() says which
+ * limit ended it.
  */
 typedef struct {
     const char *tool_name;            /* Name of the tool (e.g., "LhA") */
     const char *pipe_prefix;          /* Prefix for pipe names */
     uint32_t timeout_seconds;         /* Timeout for process operations */
+    uint32_t stall_timeout_seconds;   /* Give up after this long without output (0 = timeout_seconds) */
     bool silent_mode;                 /* Suppress output to console */
+    uint32_t read_chunk_size;         /* Bytes per read (0 = default) */
+    uint32_t max_line_length;         /* Longer lines are split (0 = unlimited) */
+    uint32_t max_lines;               /* Stop reading after N lines (0 = unlimited) */
+    bool strip_escapes;               /* Remove ESC sequences before delivery */
+    bool use_pty;                     /* Host: child's stdout is a pseudo-terminal */
+    line_view_processor_t error_processor; /* Host: receives stderr lines (NULL = not captured) */
+    void *error_user_data;            /* Passed to error_processor */
+    process_limits_t limits;          /* Host: resource limits (all 0 = none) */
 } process_exec_config_t;
 
 /**
@@ -53,6 +217,10 @@ typedef struct {
  * specified command. Returns a process handle for signal management and
  * provides bidirectional communication via pipes.
  *
+ * On host builds the command is run through /bin/sh -c in a child started
+ * with posix_spawn(), whose stdout is connected to a pipe; output is read
+ * with poll() and handed to line_processor line by line as it arrives.
+ *
  * @param cmd Complete command string to execute
  * @param line_processor Callback function to process output lines
  * @param user_data User data passed to line processor
@@ -67,9 +235,229 @@ bool execute_controlled_process(const char *cmd,
                                 const process_exec_config_t *config,
                                 controlled_process_t *out_process);
 
+/**
+ * @brief Execute a command, delivering output lines as in-place views
+ *
+ * Same as execute_controlled_process(), but each line is passed as a
+ * pointer/length view into the read buffer instead of being copied into a
+ * separate line buffer first. With config->strip_escapes set, escape
+ * sequences are removed in place before the callback runs.
+ *
+ * @param cmd Complete command string to execute
+ * @param view_processor Callback receiving each line view
+ * @param user_data User data passed to view_processor
+ * @param config Process execution configuration
+ * @param out_process Pointer to receive process control structure
+ * @return true if process created and command executed successfully
+ * @return false if process creation or execution failed
+ */
+bool execute_controlled_process_views(const char *cmd,
+                                      line_view_processor_t view_processor,
+                                      void *user_data,
+                                      const process_exec_config_t *config,
+                                      controlled_process_t *out_process);
+
+/**
+ * @brief Execute a program from an argument vector, without a shell
+ *
+ * Same as execute_controlled_process_views(), but argv is run as is:
+ * argv[0] is looked up in PATH and the arguments reach the program
+ * unchanged, so paths with spaces or shell characters need no quoting and
+ * there is no length limit. On host no intermediate shell is started; the
+ * output redirection is done with file descriptors. A program that cannot
+ * be run makes the call fail at once (with older C libraries it exits with
+ * code 127 instead). On Amiga the arguments are quoted into a
+ * command line, sized to fit, and run through the shell as before.
+ *
+ * @param argv NULL-terminated argument vector; argv[0] is the program
+ * @param view_processor Callback receiving each line view
+ * @param user_data User data passed to view_processor
+ * @param config Process execution configuration
+ * @param out_process Pointer to receive process control structure
+ * @return true if process created and command executed successfully
+ * @return false if process creation or execution failed
+ */
+bool execute_controlled_process_argv(const char *const argv[],
+                                     line_view_processor_t view_processor,
+                                     void *user_data,
+                                     const process_exec_config_t *config,
+                                     controlled_process_t *out_process);
+
+/**
+ * @brief Start a command without waiting for its output
+ *
+ * Spawns the command like execute_controlled_process_views() and returns
+ * at once. Drive it with process_poll() until that returns false, then
+ * call process_finish(). In between, the caller stays in control and may
+ * pause, resume or terminate the process at any time.
+ *
+ * @param cmd Complete command string to execute
+ * @param view_processor Callback receiving each line view
+ * @param user_data User data passed to view_processor
+ * @param config Process execution configuration
+ * @param out_process Process structure; must stay valid until finished
+ * @return true if the process was started
+ * @return false if process creation failed
+ */
+bool process_start(const char *cmd,
+                   line_view_processor_t view_processor,
+                   void *user_data,
+                   const process_exec_config_t *config,
+                   controlled_process_t *out_process);
+
+/**
+ * @brief Start a program from an argument vector without waiting for it
+ *
+ * process_start() for an argument vector, run as by
+ * execute_controlled_process_argv().
+ *
+ * @param argv NULL-terminated argument vector; argv[0] is the program
+ * @param view_processor Callback receiving each line view
+ * @param user_data User data passed to view_processor
+ * @param config Process execution configuration
+ * @param out_process Process structure; must stay valid until finished
+ * @return true if the process was started
+ * @return false if process creation failed
+ */
+bool process_start_argv(const char *const argv[],
+                        line_view_processor_t view_processor,
+                        void *user_data,
+                        const process_exec_config_t *config,
+                        controlled_process_t *out_process);
+
+/**
+ * @brief Read whatever output is available, waiting at most timeout_ms
+ *
+ * Delivers complete lines to the view_processor given to process_start().
+ * Returns after one chunk has been handled or the timeout expired, so the
+ * caller gets control back within timeout_ms even if the process is silent
+ * or paused. On Amiga the wait is checked once per tick (20 ms).
+ *
+ * @param process Process started with process_start()
+ * @param timeout_ms Longest time to wait for output (0 = don't wait, -1 = no limit)
+ * @return true while output may still arrive
+ * @return false once output has ended - call process_finish()
+ */
+bool process_poll(controlled_process_t *process, int32_t timeout_ms);
+
+/**
+ * @brief Complete a process started with process_start()
+ *
+ * Flushes the last partial line and collects the exit status. Calling it
+ * before process_poll() returned false abandons the rest of the output and
+ * reports failure; terminate the process first to have it stop.
+ * Call once, then release the process with cleanup_controlled_process().
+ *
+ * @param process Process started with process_start()
+ * @return true if the output was read to the end (as execute_controlled_process_views())
+ * @return false if reading failed or was abandoned
+ */
+bool process_finish(controlled_process_t *process);
+
+/**
+ * @brief One process driven by a process_loop_t
+ */
+typedef struct {
+    controlled_process_t *process;    /* Caller-owned process structure */
+    line_view_processor_t view_processor; /* Receives this process's lines */
+    void (*done_processor)(controlled_process_t *, bool, void *); /* Called once on finish */
+    void *user_data;                  /* Passed to both callbacks */
+    uint32_t timeout_seconds;         /* Stall deadline (0 = none) */
+    uint64_t last_activity_ms;        /* Host: monotonic time of the last read */
+    bool in_use;                      /* Slot holds a running process */
+} process_loop_entry_t;
+
+/**
+ * @brief Runs many controlled processes from a single thread
+ *
+ * Output from every process is multiplexed through one wait: epoll on host,
+ * one Wait() signal mask over asynchronous read packets on Amiga. Each
+ * process keeps its own reader, callbacks and context.
+ */
+typedef struct {
+    process_loop_entry_t entries[PROCESS_LOOP_MAX_PROCESSES];
+    uint32_t active_count;            /* Slots with a running process */
+    uint32_t failed_count;            /* Processes that finished with failure */
+#ifndef PLATFORM_AMIGA
+    int poll_fd;                      /* Host: epoll instance */
+#endif
+} process_loop_t;
+
+/**
+ * @brief Initialize an empty process loop
+ *
+ * @param loop Loop state to initialize
+ * @return true on success
+ * @return false if the host epoll instance could not be created
+ */
+bool process_loop_init(process_loop_t *loop);
+
+/**
+ * @brief Start a command and add it to the loop
+ *
+ * The command is spawned as with execute_controlled_process_views(), but
+ * returns at once; its lines are delivered from process_loop_wait(). When
+ * the process finishes, its exit status is collected and done_processor (if
+ * any) is called with the result. The slot is free again by then, so
+ * done_processor may add another process.
+ *
+ * @param loop Process loop
+ * @param cmd Complete command string to execute
+ * @param view_processor Callback receiving each line view
+ * @param done_processor Callback run when the process has finished, or NULL
+ * @param user_data User data passed to both callbacks
+ * @param config Process execution configuration
+ * @param out_process Process structure; must stay valid until finished
+ * @return Slot index (>= 0) on success
+ * @return -1 if the loop is full or the process could not be started
+ */
+int process_loop_add(process_loop_t *loop, const char *cmd,
+                     line_view_processor_t view_processor,
+                     void (*done_processor)(controlled_process_t *, bool, void *),
+                     void *user_data,
+                     const process_exec_config_t *config,
+                     controlled_process_t *out_process);
+
+/**
+ * @brief Wait for output from any process in the loop and dispatch it
+ *
+ * Processes that ended or timed out during the call are finished. On Amiga
+ * timeout_ms is ignored and the wait can be broken with Ctrl-C.
+ *
+ * @param loop Process loop
+ * @param timeout_ms Longest time to wait for output (-1 = no limit)
+ * @return Number of processes still running
+ * @return -1 on error or Ctrl-C
+ */
+int process_loop_wait(process_loop_t *loop, int32_t timeout_ms);
+
+/**
+ * @brief Run the loop until every process has finished
+ *
+ * @param loop Process loop
+ * @return true if every process finished successfully
+ * @return false if any failed or the loop was interrupted
+ */
+bool process_loop_run(process_loop_t *loop);
+
+/**
+ * @brief Release loop resources, abandoning processes still running
+ *
+ * Unfinished processes are finished with failure and cleaned up with
+ * cleanup_controlled_process(). Finished processes are left to the caller.
+ *
+ * @param loop Process loop
+ */
+void process_loop_cleanup(process_loop_t *loop);
+
 /**
  * @brief Send pause signal to controlled process
  *
+ * On host builds the child's whole process group is stopped with SIGSTOP.
+ * Output already in the pipe is still delivered; pause_latency_ms tracks
+ * how long after the request the last such byte was read. A paused
+ * process is never given up on for being silent.
+ *
  * @param process Process control structure
  * @return true if signal sent successfully
  * @return false if signal failed or process not running
@@ -79,6 +467,8 @@ bool send_pause_signal(controlled_process_t *process);
 /**
  * @brief Send resume signal to controlled process
  *
+ * On host builds the process group is continued with SIGCONT.
+ *
  * @param process Process control structure
  * @return true if signal sent successfully
  * @return false if signal failed or process not running
@@ -88,6 +478,9 @@ bool send_resume_signal(controlled_process_t *process);
 /**
  * @brief Send terminate signal to controlled process
  *
+ * On host builds the process group gets SIGTERM, followed by SIGCONT if
+ * it is paused so the signal can be acted on.
+ *
  * @param process Process control structure
  * @return true if signal sent successfully
  * @return false if signal failed or process not running
@@ -97,6 +490,12 @@ bool send_terminate_signal(controlled_process_t *process);
 /**
  * @brief Wait for process death signal
  *
+ * Returns once the child has exited and been reaped, with its exit code
+ * stored, or when timeout_seconds have passed on the monotonic clock. On
+ * Linux the wait sleeps on a pidfd; elsewhere the child is checked every
+ * 10 ms. On Amiga the launcher's reply is checked once per tick, and
+ * Ctrl-C ends the wait early.
+ *
  * @param process Process control structure
  * @param timeout_seconds Maximum time to wait (0 = no timeout)
  * @return true if process death detected
@@ -107,12 +506,29 @@ bool wait_for_death_signal(controlled_process_t *process, uint32_t timeout_secon
 /**
  * @brief Force kill process (emergency termination)
  *
+ * Kills the child (its whole process group on host) and waits up to
+ * PROCESS_KILL_REAP_SECONDS for the death to be confirmed.
+ *
  * @param process Process control structure
- * @return true if process killed successfully
- * @return false if kill failed
+ * @return true if process killed and confirmed dead
+ * @return false if kill failed or the death was not confirmed in time
  */
 bool force_kill_process(controlled_process_t *process);
 
+/**
+ * @brief Terminate a process, escalating to a kill after a grace period
+ *
+ * Sends the terminate signal and waits up to grace_seconds for the process
+ * to exit on its own, then falls back to force_kill_process(). Worst case
+ * the call returns after grace_seconds + PROCESS_KILL_REAP_SECONDS.
+ *
+ * @param process Process control structure
+ * @param grace_seconds Time allowed for a clean exit
+ * @return true if the process is confirmed dead
+ * @return false if it could not be confirmed dead
+ */
+bool terminate_controlled_process(controlled_process_t *process, uint32_t grace_seconds);
+
 /**
  * @brief Clean up process control resources
  *
@@ -126,6 +542,10 @@ void cleanup_controlled_process(controlled_process_t *process);
 /**
  * @brief Get the exit code of a completed process
  *
+ * The code is collected from the child that produced the output: wait4()
+ * on host, the launcher's death message on Amiga. A host child killed by a
+ * signal reports 128 + signal number.
+ *
  * @param process Process control structure
  * @param out_exit_code Pointer to receive the exit code
  * @return true if exit code is valid and retrieved
@@ -133,6 +553,39 @@ void cleanup_controlled_process(controlled_process_t *process);
  */
 bool get_process_exit_code(const controlled_process_t *process, int32_t *out_exit_code);
 
+/**
+ * @brief Get the resources a completed process used
+ *
+ * Available once the exit has been collected, like the exit code, and
+ * until cleanup_controlled_process() clears the structure.
+ *
+ * @param process Process control structure
+ * @param out_usage Receives CPU time, peak RSS, output bytes and wall time
+ * @return true if usage was retrieved
+ * @return false if the exit has not been collected yet
+ */
+bool get_process_usage(const controlled_process_t *process, process_usage_t *out_usage);
+
+/**
+ * @brief Get why a completed process ended
+ *
+ * CPU and file size limits are recognised from the signal the kernel sends
+ * (SIGXCPU, or SIGKILL once the CPU time is past the limit; SIGXFSZ). Running
+ * out of address space only makes allocations fail, with no signal of
+ * its own, so a child that dies from SIGSEGV, SIGBUS or SIGABRT is
+ * reported as PROCESS_END_MEMORY_LIMIT only when its peak RSS reached
+ * PROCESS_MEMORY_LIMIT_RSS_PERCENT of max_address_space. That is a
+ * guess - other crashes are PROCESS_END_SIGNAL. A child that handles the
+ * failure and exits with an error code is PROCESS_END_NORMAL. Amiga
+ * children always end normally.
+ *
+ * @param process Process control structure
+ * @param out_reason Receives a PROCESS_END_* code
+ * @return true if the reason is known
+ * @return false if the exit has not been collected yet
+ */
+bool get_process_end_reason(const controlled_process_t *process, int32_t *out_reason);
+
 /**
  * @brief Initialize process control system
  *
@@ -1,5 +1,6 @@
 /* CLI Wrapper Byte-Level Test Demo */
 #include "cli_wrapper.h"
+#include "../src/platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -31,10 +32,7 @@ static void wait_for_input(void) {
         Read(input, buffer, 1);
     } else {
         /* Fallback: 3 second delay */
-        volatile int i;
-        for (i = 0; i < 1500000; i++) {
-            /* 3 second delay */
-        }
+        plat_sleep_ms(3000);
     }
 #else
     getchar();
@@ -113,10 +111,7 @@ int main(void) {
 
         test_log("About to start safety delay");
         /* CRITICAL: Add safety delay between listing and extraction */
-        volatile int safety_delay;
-        for (safety_delay = 0; safety_delay < 500000; safety_delay++) {
-            /* 1 second safety delay */
-        }
+        plat_sleep_ms(1000);
         test_log("Safety delay completed");
         printf("Safety delay completed, starting extraction...\n");
         fflush(stdout);
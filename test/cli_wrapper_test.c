@@ -1,5 +1,6 @@
 /* CLI Wrapper Test - Final Working Version */
 #include "cli_wrapper.h"
+#include "../src/platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -23,10 +24,7 @@ static void wait_for_input(void) {
         Read(input, buffer, 1);
     } else {
         /* Fallback: 3 second delay */
-        volatile int i;
-        for (i = 0; i < 1500000; i++) {
-            /* 3 second delay */
-        }
+        plat_sleep_ms(3000);
     }
 #else
     getchar();
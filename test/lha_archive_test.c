@@ -0,0 +1,433 @@
+/*
+ * LHA Archive Test - Verifies the in-process header reader
+ * Builds small archives with level 0, 1 and 2 headers byte by byte, so the
+ * expected paths, sizes and offsets are known exactly, and checks damaged
+ * archives are refused rather than half-listed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../src/lha_archive.h"
+
+#define TEST_ARCHIVE_FILE "lha_archive_test.tmp"
+#define TEST_BUFFER_SIZE 4096
+
+/* Archive image being assembled */
+typedef struct {
+    uint8_t data[TEST_BUFFER_SIZE];
+    size_t length;
+} test_image_t;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+/* Test helper functions */
+static bool run_test(const char *test_name, bool (*test_func)(void));
+static void put8(test_image_t *image, uint8_t value);
+static void put16(test_image_t *image, uint16_t value);
+static void put32(test_image_t *image, uint32_t value);
+static void put_bytes(test_image_t *image, const void *data, size_t length);
+static void put_common(test_image_t *image, const char *method, uint32_t packed_size,
+                       size_t payload_length, uint32_t timestamp, uint8_t level);
+static void add_level0(test_image_t *image, const char *method, const char *name,
+                       size_t name_length, const char *payload);
+static void add_level1(test_image_t *image, const char *method, const char *dir,
+                       const char *name, const char *payload);
+static void add_level2(test_image_t *image, const char *method, const char *dir,
+                       const char *name, const char *payload);
+static bool write_image(const test_image_t *image);
+static bool payload_at(const lha_member_t *member, const char *expected);
+
+/* Test functions */
+static bool test_level0_headers(void);
+static bool test_level1_headers(void);
+static bool test_level2_headers(void);
+static bool test_archive_totals(void);
+static bool test_damaged_archives(void);
+static bool test_list_command_parsing(void);
+
+size_t __stack = 65536;  /* request a 64 KB stack */
+
+int main(void)
+{
+    printf("=== LHA Archive Test Suite ===\n");
+
+    run_test("Level 0 Headers", test_level0_headers);
+    run_test("Level 1 Headers", test_level1_headers);
+    run_test("Level 2 Headers", test_level2_headers);
+    run_test("Archive Totals", test_archive_totals);
+    run_test("Damaged Archives", test_damaged_archives);
+    run_test("List Command Parsing", test_list_command_parsing);
+
+    remove(TEST_ARCHIVE_FILE);
+
+    printf("\n=== Test Results ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_run - tests_passed);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
+
+static bool run_test(const char *test_name, bool (*test_func)(void))
+{
+    printf("Running test: %s...", test_name);
+
+    tests_run++;
+    bool result = test_func();
+
+    if (result) {
+        printf(" PASSED\n");
+        tests_passed++;
+    } else {
+        printf(" FAILED\n");
+    }
+
+    return result;
+}
+
+static bool test_level0_headers(void)
+{
+    test_image_t image = {{0}, 0};
+    lha_archive_t archive;
+    lha_member_t member;
+    bool result = true;
+
+    /* Amiga LhA stores the filenote after a NUL in the name field */
+    add_level0(&image, "-lh0-", "Disk.info\0A filenote", 20, "icon data");
+    add_level0(&image, "-lh5-", "s\\startup", 9, "packed");
+    put8(&image, 0);
+
+    if (!write_image(&image) || !lha_archive_open(&archive, TEST_ARCHIVE_FILE)) {
+        return false;
+    }
+
+    result = lha_archive_next(&archive, &member) &&
+             strcmp(member.path, "Disk.info") == 0 && strcmp(member.method, "-lh0-") == 0 &&
+             member.level == 0 && member.original_size == 9 * 3 &&
+             member.compressed_size == 9 && payload_at(&member, "icon data");
+    result = result && lha_archive_next(&archive, &member) &&
+             strcmp(member.path, "s/startup") == 0 && strcmp(member.method, "-lh5-") == 0 &&
+             payload_at(&member, "packed");
+    result = result && !lha_archive_next(&archive, &member) && archive.error == LHA_ARCHIVE_OK &&
+             archive.member_count == 2;
+
+    lha_archive_close(&archive);
+    return result;
+}
+
+static bool test_level1_headers(void)
+{
+    test_image_t image = {{0}, 0};
+    lha_archive_t archive;
+    lha_member_t member;
+    bool result = true;
+
+    /* Name in the base header only, then name and directory in extensions */
+    add_level1(&image, "-lh5-", NULL, "ReadMe", "hello");
+    add_level1(&image, "-lh6-", "Game\xff" "Data\xff", "level1.dat", "level data");
+    put8(&image, 0);
+
+    if (!write_image(&image) || !lha_archive_open(&archive, TEST_ARCHIVE_FILE)) {
+        return false;
+    }
+
+    result = lha_archive_next(&archive, &member) && strcmp(member.path, "ReadMe") == 0 &&
+             member.level == 1 && member.os_id == 'A' && member.compressed_size == 5 &&
+             payload_at(&member, "hello");
+    /* The skip size in the header counts the extensions - they are not data */
+    result = result && lha_archive_next(&archive, &member) &&
+             strcmp(member.path, "Game/Data/level1.dat") == 0 &&
+             member.compressed_size == 10 && payload_at(&member, "level data");
+    result = result && !lha_archive_next(&archive, &member) && archive.error == LHA_ARCHIVE_OK;
+
+    lha_archive_close(&archive);
+    return result;
+}
+
+static bool test_level2_headers(void)
+{
+    test_image_t image = {{0}, 0};
+    lha_archive_t archive;
+    lha_member_t member;
+    bool result = true;
+
+    add_level2(&image, "-lhd-", "Game\xff", NULL, "");
+    add_level2(&image, "-lh7-", "Game\xff", "Slave", "slave code");
+    put8(&image, 0);
+
+    if (!write_image(&image) || !lha_archive_open(&archive, TEST_ARCHIVE_FILE)) {
+        return false;
+    }
+
+    result = lha_archive_next(&archive, &member) && member.is_directory &&
+             strcmp(member.path, "Game/") == 0 && member.level == 2;
+    result = result && lha_archive_next(&archive, &member) && !member.is_directory &&
+             strcmp(member.path, "Game/Slave") == 0 && member.crc == 0x1234 &&
+             member.timestamp == 1000000000UL && payload_at(&member, "slave code");
+    result = result && !lha_archive_next(&archive, &member) && archive.error == LHA_ARCHIVE_OK;
+
+    lha_archive_close(&archive);
+    return result;
+}
+
+static bool test_archive_totals(void)
+{
+    test_image_t image = {{0}, 0};
+    uint32_t total = 0;
+    uint32_t file_count = 0;
+
+    /* Every level in one archive; the directory entry is not a file */
+    add_level0(&image, "-lh0-", "a", 1, "1234");
+    add_level1(&image, "-lh5-", "d\xff", "b", "12345678");
+    add_level2(&image, "-lhd-", "d\xff", NULL, "");
+    add_level2(&image, "-lh5-", "d\xff", "c", "12");
+    put8(&image, 0);
+
+    if (!write_image(&image) || !lha_archive_totals(TEST_ARCHIVE_FILE, &total, &file_count)) {
+        return false;
+    }
+
+    /* add_level*() record an original size of three times the payload */
+    return total == (4 + 8 + 2) * 3 && file_count == 3;
+}
+
+static bool test_damaged_archives(void)
+{
+    test_image_t image = {{0}, 0};
+    lha_archive_t archive;
+    lha_member_t member;
+    uint32_t total = 0;
+    bool result = true;
+
+    /* Flipped byte inside a level 0 header fails its checksum */
+    add_level0(&image, "-lh5-", "file", 4, "data");
+    put8(&image, 0);
+    image.data[10] ^= 0x40;
+    if (!write_image(&image) || !lha_archive_open(&archive, TEST_ARCHIVE_FILE)) {
+        return false;
+    }
+    result = !lha_archive_next(&archive, &member) && archive.error == LHA_ARCHIVE_BAD_HEADER;
+    lha_archive_close(&archive);
+
+    /* Packed data cut short by the end of the file */
+    image.length = 0;
+    add_level0(&image, "-lh5-", "file", 4, "some data");
+    image.length -= 3;
+    result = result && write_image(&image) &&
+             !lha_archive_totals(TEST_ARCHIVE_FILE, &total, NULL);
+
+    /* Header level 3 is not supported */
+    image.length = 0;
+    add_level2(&image, "-lh5-", NULL, "file", "data");
+    image.data[20] = 3;
+    result = result && write_image(&image) && lha_archive_open(&archive, TEST_ARCHIVE_FILE) &&
+             !lha_archive_next(&archive, &member) && archive.error == LHA_ARCHIVE_BAD_LEVEL;
+    lha_archive_close(&archive);
+
+    /* Not an archive at all */
+    image.length = 0;
+    put_bytes(&image, "This is a text file, not an archive\n", 36);
+    result = result && write_image(&image) &&
+             !lha_archive_totals(TEST_ARCHIVE_FILE, &total, NULL);
+
+    /* Missing file */
+    remove(TEST_ARCHIVE_FILE);
+    result = result && !lha_archive_totals(TEST_ARCHIVE_FILE, &total, NULL);
+
+    return result;
+}
+
+static bool test_list_command_parsing(void)
+{
+    char path[64];
+    char long_cmd[LHA_MAX_PATH + 32];
+    char long_path[LHA_MAX_PATH * 2];
+    bool result = true;
+
+    /* An archive name too long to hold must not be cut short */
+    strcpy(long_cmd, "lha l ");
+    memset(long_cmd + 6, 'a', LHA_MAX_PATH);
+    strcpy(long_cmd + 6 + LHA_MAX_PATH, ".lha");
+
+    result = result && lha_list_command_archive("lha l assets/test.lha", path, sizeof(path)) &&
+             strcmp(path, "assets/test.lha") == 0;
+    result = result && lha_list_command_archive("C:LhA -n v \"Work:My Games/a.lha\"", path,
+                                                sizeof(path)) &&
+             strcmp(path, "Work:My Games/a.lha") == 0;
+    result = result && lha_list_command_archive("/usr/bin/LHA.exe l a.lha", path, sizeof(path)) &&
+             strcmp(path, "a.lha") == 0;
+
+    /* Anything that is not a plain listing of a whole archive */
+    result = result && !lha_list_command_archive("lha x archive.lha dest/", path, sizeof(path));
+    result = result && !lha_list_command_archive("lha l archive.lha *.info", path, sizeof(path));
+    result = result && !lha_list_command_archive("lha l", path, sizeof(path));
+    result = result && !lha_list_command_archive("unzip -l archive.zip", path, sizeof(path));
+    result = result && !lha_list_command_archive("lhasa l archive.lha", path, sizeof(path));
+    result = result && !lha_list_command_archive("lharc l archive.lha", path, sizeof(path));
+    result = result && !lha_list_command_archive("lha_dump l archive.lha", path, sizeof(path));
+    result = result && !lha_list_command_archive("", path, sizeof(path));
+    result = result && !lha_list_command_archive(long_cmd, long_path, sizeof(long_path));
+
+    return result;
+}
+
+static void put8(test_image_t *image, uint8_t value)
+{
+    image->data[image->length++] = value;
+}
+
+static void put16(test_image_t *image, uint16_t value)
+{
+    put8(image, (uint8_t)(value & 0xFF));
+    put8(image, (uint8_t)(value >> 8));
+}
+
+static void put32(test_image_t *image, uint32_t value)
+{
+    put16(image, (uint16_t)(value & 0xFFFF));
+    put16(image, (uint16_t)(value >> 16));
+}
+
+static void put_bytes(test_image_t *image, const void *data, size_t length)
+{
+    memcpy(image->data + image->length, data, length);
+    image->length += length;
+}
+
+/* Base header fields from the method to the level byte */
+static void put_common(test_image_t *image, const char *method, uint32_t packed_size,
+                       size_t payload_length, uint32_t timestamp, uint8_t level)
+{
+    put_bytes(image, method, 5);
+    put32(image, packed_size);
+    put32(image, (uint32_t)payload_length * 3);
+    put32(image, timestamp);
+    put8(image, level == 2 ? 0x20 : 0);
+    put8(image, level);
+}
+
+static void add_level0(test_image_t *image, const char *method, const char *name,
+                       size_t name_length, const char *payload)
+{
+    size_t start = image->length;
+    size_t payload_length = strlen(payload);
+    size_t i;
+    uint8_t sum = 0;
+
+    put8(image, (uint8_t)(22 + name_length));
+    put8(image, 0);
+    put_common(image, method, (uint32_t)payload_length, payload_length, 0x2C4A9C21UL, 0);
+    put8(image, (uint8_t)name_length);
+    put_bytes(image, name, name_length);
+    put16(image, 0xBEEF);
+
+    for (i = start + 2; i < image->length; i++) {
+        sum = (uint8_t)(sum + image->data[i]);
+    }
+    image->data[start + 1] = sum;
+    put_bytes(image, payload, payload_length);
+}
+
+static void add_level1(test_image_t *image, const char *method, const char *dir,
+                       const char *name, const char *payload)
+{
+    size_t start = image->length;
+    size_t payload_length = strlen(payload);
+    size_t dir_length = dir ? strlen(dir) : 0;
+    size_t name_length = strlen(name);
+    size_t extensions = dir ? (3 + name_length) + (3 + dir_length) : 0;
+    size_t i;
+    uint8_t sum = 0;
+
+    /* With a directory, the name moves to an extension as LHa for UNIX does it */
+    size_t base_name_length = dir ? 0 : name_length;
+
+    put8(image, (uint8_t)(25 + base_name_length));
+    put8(image, 0);
+    put_common(image, method, (uint32_t)(payload_length + extensions), payload_length,
+               0x2C4A9C21UL, 1);
+    put8(image, (uint8_t)base_name_length);
+    put_bytes(image, name, base_name_length);
+    put16(image, 0xBEEF);
+    put8(image, 'A');
+    put16(image, dir ? (uint16_t)(3 + name_length) : 0);
+
+    for (i = start + 2; i < image->length; i++) {
+        sum = (uint8_t)(sum + image->data[i]);
+    }
+    image->data[start + 1] = sum;
+
+    if (dir) {
+        put8(image, 0x01);
+        put_bytes(image, name, name_length);
+        put16(image, (uint16_t)(3 + dir_length));
+        put8(image, 0x02);
+        put_bytes(image, dir, dir_length);
+        put16(image, 0);
+    }
+    put_bytes(image, payload, payload_length);
+}
+
+static void add_level2(test_image_t *image, const char *method, const char *dir,
+                       const char *name, const char *payload)
+{
+    size_t payload_length = strlen(payload);
+    size_t dir_length = dir ? strlen(dir) : 0;
+    size_t name_length = name ? strlen(name) : 0;
+    size_t total = 26 + (name ? 3 + name_length : 0) + (dir ? 3 + dir_length : 0);
+
+    put16(image, (uint16_t)total);
+    put_common(image, method, (uint32_t)payload_length, payload_length, 1000000000UL, 2);
+    put16(image, 0x1234);
+    put8(image, 'U');
+    put16(image, name ? (uint16_t)(3 + name_length) : (dir ? (uint16_t)(3 + dir_length) : 0));
+
+    if (name) {
+        put8(image, 0x01);
+        put_bytes(image, name, name_length);
+        put16(image, dir ? (uint16_t)(3 + dir_length) : 0);
+    }
+    if (dir) {
+        put8(image, 0x02);
+        put_bytes(image, dir, dir_length);
+        put16(image, 0);
+    }
+    put_bytes(image, payload, payload_length);
+}
+
+static bool write_image(const test_image_t *image)
+{
+    FILE *file = fopen(TEST_ARCHIVE_FILE, "wb");
+
+    if (!file) {
+        return false;
+    }
+
+    bool written = fwrite(image->data, 1, image->length, file) == image->length;
+    fclose(file);
+    return written;
+}
+
+/* The recorded data offset really points at the member's packed bytes */
+static bool payload_at(const lha_member_t *member, const char *expected)
+{
+    char data[64];
+    size_t length = strlen(expected);
+    FILE *file = fopen(TEST_ARCHIVE_FILE, "rb");
+    bool match = false;
+
+    if (!file) {
+        return false;
+    }
+    if (fseek(file, (long)member->data_offset, SEEK_SET) == 0 &&
+        fread(data, 1, length, file) == length) {
+        match = memcmp(data, expected, length) == 0 && member->compressed_size == length;
+    }
+    fclose(file);
+    return match;
+}
@@ -0,0 +1,1456 @@
+/*
+ * LHA Decode Test - Verifies the in-process decoder and extractor
+ * There is no LhA to make test archives with, so a small -lh4- to -lh7-
+ * encoder below (greedy matching, LHa's block format) packs known data.
+ * Members are decoded back and compared byte for byte, and damaged data
+ * must be reported rather than written out. assets/lh5_sample.lha is a
+ * fixed sample whose contents and CRCs are known and which libarchive
+ * decodes to the same bytes, so a mistake the encoder and decoder share
+ * still shows.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef PLATFORM_AMIGA
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#include "../src/lha_archive.h"
+#include "../src/lha_crc.h"
+#include "../src/lha_decode.h"
+#include "../src/lha_extract.h"
+#include "../src/lha_source.h"
+
+#define TEST_ARCHIVE_FILE "lha_decode_test.tmp"
+#define TEST_SAMPLE_ARCHIVE "assets/lh5_sample.lha"
+#define TEST_DEST_DIR "lha_decode_out"
+#define TEST_IMAGE_SIZE (1024 * 1024)
+#define TEST_DATA_SIZE (150 * 1024)
+
+/* Encoder alphabet, as in the decoder */
+#define ENC_NC 510
+#define ENC_NT 19
+#define ENC_TBIT 5
+#define ENC_CBIT 9
+#define ENC_MAX_CODE 16
+#define ENC_MAX_MATCH 256
+#define ENC_HASH_SIZE 4096
+#define ENC_MAX_CHAIN 128
+
+/* Symbols per block; small blocks exercise the table reload */
+#define ENC_BLOCK_DEFAULT 16000
+#define ENC_BLOCK_SMALL 300
+
+/* Archive image being assembled */
+typedef struct {
+    uint8_t *data;
+    size_t length;
+} test_image_t;
+
+/* Packed output, MSB first as LhA writes it */
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    uint32_t bits;
+    int bit_count;
+} bit_writer_t;
+
+/* One literal (c < 256) or match (c = 253 + length, p = distance - 1) */
+typedef struct {
+    uint16_t c;
+    uint16_t p;
+} enc_symbol_t;
+
+/* One code length code with its extra bits */
+typedef struct {
+    uint8_t symbol;
+    uint8_t extra_bits;
+    uint16_t extra;
+} enc_t_symbol_t;
+
+/* Decoded bytes collected in memory */
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    uint32_t calls;
+    uint32_t stop_after;              /* Return false on this call (0 = never) */
+} test_sink_t;
+
+/* Bytes and members reported by lha_extract_archive() */
+typedef struct {
+    uint32_t bytes;
+    uint32_t finished;
+    int active;                       /* Callbacks running right now */
+    bool overlapped;                  /* Two ran at once */
+} test_progress_t;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+static uint8_t *g_sample = NULL;
+
+/* Test helper functions */
+static bool run_test(const char *test_name, bool (*test_func)(void));
+static void make_sample(uint8_t *data, size_t length);
+static uint16_t test_crc16(const uint8_t *data, size_t length);
+static void put_bits(bit_writer_t *writer, int count, uint32_t value);
+static void flush_bits(bit_writer_t *writer);
+static void huffman_lengths(const uint32_t *freq, int n, uint8_t *len);
+static void make_codes(const uint8_t *len, int n, uint16_t *code);
+static int used_symbols(const uint32_t *freq, int n, int *out_only);
+static int distance_code(uint16_t p);
+static void write_pt_len(bit_writer_t *writer, const uint8_t *len, int n, int nbit, int i_special);
+static size_t make_t_symbols(const uint8_t *c_len, enc_t_symbol_t *out);
+static void send_block(bit_writer_t *writer, const enc_symbol_t *symbols, size_t count,
+                       int np, int pbit);
+static size_t encode(const char *method, const uint8_t *data, size_t length, size_t block_symbols,
+                     uint8_t *out);
+static void put8(test_image_t *image, uint8_t value);
+static void put16(test_image_t *image, uint16_t value);
+static void put32(test_image_t *image, uint32_t value);
+static void put_bytes(test_image_t *image, const void *data, size_t length);
+static size_t add_member(test_image_t *image, const char *method, const char *dir,
+                         const char *name, const uint8_t *data, size_t length,
+                         size_t block_symbols);
+static size_t add_member_mode(test_image_t *image, const char *method, const char *dir,
+                              const char *name, const uint8_t *data, size_t length,
+                              size_t block_symbols, uint16_t unix_mode);
+static bool write_image(const test_image_t *image);
+static bool open_first_member(lha_source_t *source, lha_member_t *member);
+static bool sink_output(const uint8_t *data, size_t length, void *user_data);
+static int decode_first(test_sink_t *sink);
+static bool round_trip(const char *method, const uint8_t *data, size_t length,
+                       size_t block_symbols);
+static bool decode_all_members(lha_source_t *source, const uint8_t *data, size_t length,
+                               uint32_t expected_members);
+static bool file_matches(const char *path, const uint8_t *data, size_t length);
+static bool file_exists(const char *path);
+static void count_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                           void *user_data);
+static void remove_outputs(void);
+
+/* Test functions */
+static bool test_lh5_round_trip(void);
+static bool test_lh6_lh7_round_trip(void);
+static bool test_lh4_and_stored(void);
+static bool test_single_symbol_blocks(void);
+static bool test_crc_mismatch(void);
+static bool test_damaged_stream(void);
+static bool test_output_stop(void);
+static bool test_extract_archive(void);
+static bool test_extract_not_handled(void);
+static bool test_extract_command_parsing(void);
+static bool test_parallel_extract(void);
+static bool test_source_kinds(void);
+static bool test_crc_slices(void);
+static bool test_archive_integrity(void);
+static bool test_restored_attributes(void);
+static bool test_sample_archive(void);
+
+size_t __stack = 65536;  /* request a 64 KB stack */
+
+int main(void)
+{
+    printf("=== LHA Decode Test Suite ===\n");
+
+    g_sample = (uint8_t *)malloc(TEST_DATA_SIZE);
+    if (!g_sample) {
+        printf("ERROR: Out of memory\n");
+        return 1;
+    }
+    make_sample(g_sample, TEST_DATA_SIZE);
+
+    run_test("LH5 Round Trip", test_lh5_round_trip);
+    run_test("LH6/LH7 Round Trip", test_lh6_lh7_round_trip);
+    run_test("LH4 and Stored Members", test_lh4_and_stored);
+    run_test("Single Symbol Blocks", test_single_symbol_blocks);
+    run_test("CRC Mismatch", test_crc_mismatch);
+    run_test("Damaged Stream", test_damaged_stream);
+    run_test("Output Stop", test_output_stop);
+    run_test("Extract Archive", test_extract_archive);
+    run_test("Extract Not Handled", test_extract_not_handled);
+    run_test("Extract Command Parsing", test_extract_command_parsing);
+    run_test("Parallel Extract", test_parallel_extract);
+    run_test("Source Kinds", test_source_kinds);
+    run_test("CRC-16 Slice-by-8", test_crc_slices);
+    run_test("Archive Integrity Test", test_archive_integrity);
+    run_test("Restored Attributes", test_restored_attributes);
+    run_test("Checked-in LH5 Archive", test_sample_archive);
+
+    remove_outputs();
+    remove(TEST_ARCHIVE_FILE);
+    free(g_sample);
+
+    printf("\n=== Test Results ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_run - tests_passed);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
+
+static bool run_test(const char *test_name, bool (*test_func)(void))
+{
+    printf("Running test: %s...", test_name);
+
+    tests_run++;
+    bool result = test_func();
+
+    if (result) {
+        printf(" PASSED\n");
+        tests_passed++;
+    } else {
+        printf(" FAILED\n");
+    }
+
+    return result;
+}
+
+static bool test_lh5_round_trip(void)
+{
+    return round_trip("-lh5-", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT) &&
+           round_trip("-lh5-", g_sample, 1000, ENC_BLOCK_DEFAULT);
+}
+
+static bool test_lh6_lh7_round_trip(void)
+{
+    /* The sample repeats a block 50 KB later, which only -lh7- can reach */
+    return round_trip("-lh6-", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT) &&
+           round_trip("-lh7-", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT) &&
+           round_trip("-lh6-", g_sample, TEST_DATA_SIZE, ENC_BLOCK_SMALL);
+}
+
+static bool test_lh4_and_stored(void)
+{
+    return round_trip("-lh4-", g_sample, 20000, ENC_BLOCK_SMALL) &&
+           round_trip("-lh0-", g_sample, 20000, 0) &&
+           round_trip("-lh5-", g_sample, 0, ENC_BLOCK_DEFAULT);
+}
+
+static bool test_single_symbol_blocks(void)
+{
+    uint8_t same[5000];
+    uint8_t one = 'x';
+
+    /* One literal and one distance code; then a block of a single literal */
+    memset(same, 'A', sizeof(same));
+    return round_trip("-lh5-", same, sizeof(same), ENC_BLOCK_DEFAULT) &&
+           round_trip("-lh5-", &one, 1, ENC_BLOCK_DEFAULT);
+}
+
+static bool test_crc_mismatch(void)
+{
+    test_image_t image = {NULL, 0};
+    test_sink_t sink = {NULL, 0, 0, 0, 0};
+    bool result;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    add_member(&image, "-lh5-", NULL, "file", g_sample, 30000, ENC_BLOCK_DEFAULT);
+    put8(&image, 0);
+    image.data[21] ^= 0x01;           /* Level 2 header CRC field */
+
+    result = write_image(&image) && decode_first(&sink) == LHA_DECODE_BAD_CRC &&
+             sink.length == 30000 && memcmp(sink.data, g_sample, 30000) == 0;
+
+    free(sink.data);
+    free(image.data);
+    return result;
+}
+
+static bool test_damaged_stream(void)
+{
+    test_image_t image = {NULL, 0};
+    test_image_t damaged = {NULL, 0};
+    bool result = true;
+    int i;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    damaged.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data || !damaged.data) {
+        free(image.data);
+        free(damaged.data);
+        return false;
+    }
+    size_t header = add_member(&image, "-lh5-", NULL, "file", g_sample, 30000, ENC_BLOCK_SMALL);
+    size_t packed = image.length - header;
+    put8(&image, 0);
+
+    /* Bytes flipped in the packed data: reported, never a crash */
+    for (i = 0; i < 32 && result; i++) {
+        test_sink_t sink = {NULL, 0, 0, 0, 0};
+        memcpy(damaged.data, image.data, image.length);
+        damaged.length = image.length;
+        damaged.data[header + (size_t)i * 97 % packed] ^= (uint8_t)(0x5A + i);
+        damaged.data[header + (size_t)i * 31 % packed] ^= 0xFF;
+        result = write_image(&damaged) && decode_first(&sink) != LHA_DECODE_OK;
+        free(sink.data);
+    }
+
+    /* Packed data cut short: the header says less than the stream needs */
+    if (result) {
+        test_sink_t sink = {NULL, 0, 0, 0, 0};
+        uint32_t shorter = (uint32_t)(packed / 2);
+        image.data[7] = (uint8_t)(shorter & 0xFF);
+        image.data[8] = (uint8_t)((shorter >> 8) & 0xFF);
+        image.data[9] = (uint8_t)((shorter >> 16) & 0xFF);
+        image.data[10] = (uint8_t)(shorter >> 24);
+        image.length = header + shorter;
+        put8(&image, 0);
+        result = write_image(&image) && decode_first(&sink) == LHA_DECODE_BAD_DATA;
+        free(sink.data);
+    }
+
+    free(image.data);
+    free(damaged.data);
+    return result;
+}
+
+static bool test_output_stop(void)
+{
+    test_image_t image = {NULL, 0};
+    test_sink_t sink = {NULL, 0, 0, 0, 2};
+    bool result;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    add_member(&image, "-lh7-", NULL, "file", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT);
+    put8(&image, 0);
+
+    /* Output comes a window (64 KB) at a time, so the second call is mid-member */
+    result = write_image(&image) && decode_first(&sink) == LHA_DECODE_STOPPED && sink.calls == 2;
+
+    free(sink.data);
+    free(image.data);
+    return result;
+}
+
+static bool test_extract_archive(void)
+{
+    test_image_t image = {NULL, 0};
+    test_progress_t progress = {0, 0, 0, false};
+    bool result;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    add_member(&image, "-lhd-", "Game\xff", NULL, NULL, 0, 0);
+    add_member(&image, "-lh5-", "Game\xff" "Data\xff", "level.dat", g_sample, 70000, ENC_BLOCK_DEFAULT);
+    add_member(&image, "-lh0-", NULL, "ReadMe", g_sample + 100, 500, 0);
+    put8(&image, 0);
+    remove_outputs();
+
+    result = write_image(&image) &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR "/", true,
+                                 count_progress, &progress) == LHA_EXTRACT_OK;
+    result = result && file_matches(TEST_DEST_DIR "/Game/Data/level.dat", g_sample, 70000) &&
+             file_matches(TEST_DEST_DIR "/ReadMe", g_sample + 100, 500);
+    /* Progress is exact: every decoded byte, then one report per member */
+    result = result && progress.bytes == 70000 + 500 && progress.finished == 2;
+
+    /* "e" writes every file straight into the destination */
+    remove_outputs();
+    result = result &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, false, NULL, NULL) ==
+                 LHA_EXTRACT_OK &&
+             file_matches(TEST_DEST_DIR "/level.dat", g_sample, 70000) &&
+             file_matches(TEST_DEST_DIR "/ReadMe", g_sample + 100, 500);
+
+    /* A damaged member fails the run and is not left behind */
+    remove_outputs();
+    image.length = 0;
+    size_t header = add_member(&image, "-lh5-", NULL, "ReadMe", g_sample, 30000, ENC_BLOCK_DEFAULT);
+    image.data[header + 40] ^= 0xFF;
+    put8(&image, 0);
+    result = result && write_image(&image) &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, NULL, NULL) ==
+                 LHA_EXTRACT_FAILED &&
+             !file_exists(TEST_DEST_DIR "/ReadMe");
+
+    remove_outputs();
+    free(image.data);
+    return result;
+}
+
+static bool test_extract_not_handled(void)
+{
+    test_image_t image = {NULL, 0};
+    bool result;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    remove_outputs();
+
+    /* -lh1- (dynamic Huffman) is left to LhA; nothing may be written first */
+    add_member(&image, "-lh0-", NULL, "first", g_sample, 100, 0);
+    size_t second = image.length;
+    add_member(&image, "-lh0-", NULL, "second", g_sample, 100, 0);
+    memcpy(image.data + second + 2, "-lh1-", 5);
+    put8(&image, 0);
+    result = write_image(&image) &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, NULL, NULL) ==
+                 LHA_EXTRACT_NOT_HANDLED &&
+             !file_exists(TEST_DEST_DIR "/first");
+
+    /* Paths leaving the destination */
+    image.length = 0;
+    add_member(&image, "-lh0-", "..\xff", "escape", g_sample, 100, 0);
+    put8(&image, 0);
+    result = result && write_image(&image) &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, NULL, NULL) ==
+                 LHA_EXTRACT_NOT_HANDLED;
+
+    /* Not an archive, and no archive at all */
+    image.length = 0;
+    put_bytes(&image, "plain text\n", 11);
+    result = result && write_image(&image) &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, NULL, NULL) ==
+                 LHA_EXTRACT_NOT_HANDLED;
+    remove(TEST_ARCHIVE_FILE);
+    result = result &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, NULL, NULL) ==
+                 LHA_EXTRACT_NOT_HANDLED;
+
+    remove_outputs();
+    free(image.data);
+    return result;
+}
+
+static bool test_extract_command_parsing(void)
+{
+    char path[64];
+    char dest[64];
+    char long_cmd[LHA_MAX_PATH + 32];
+    char long_dest[LHA_MAX_PATH * 2];
+    bool keep_paths = false;
+    bool result = true;
+
+    /* A destination too long to hold must not be cut short */
+    strcpy(long_cmd, "lha x a.lha ");
+    memset(long_cmd + 12, 'd', LHA_MAX_PATH);
+    strcpy(long_cmd + 12 + LHA_MAX_PATH, "/");
+
+    result = result && lha_extract_command_archive("lha x -m -n assets/a.lha test/", path,
+                                                   sizeof(path), dest, sizeof(dest),
+                                                   &keep_paths) &&
+             strcmp(path, "assets/a.lha") == 0 && strcmp(dest, "test/") == 0 && keep_paths;
+    result = result && lha_extract_command_archive("C:LhA -q e \"Work:My Games/a.lha\"", path,
+                                                   sizeof(path), dest, sizeof(dest),
+                                                   &keep_paths) &&
+             strcmp(path, "Work:My Games/a.lha") == 0 && dest[0] == '\0' && !keep_paths;
+    result = result && lha_extract_command_archive("lha x a.lha RAM:", path, sizeof(path), dest,
+                                                   sizeof(dest), &keep_paths) &&
+             strcmp(dest, "RAM:") == 0;
+
+    /* Patterns, other commands and options that change what is written */
+    result = result && !lha_extract_command_archive("lha x a.lha dest/ *.info", path,
+                                                    sizeof(path), dest, sizeof(dest), &keep_paths);
+    result = result && !lha_extract_command_archive("lha x a.lha readme.txt", path,
+                                                    sizeof(path), dest, sizeof(dest), &keep_paths);
+    result = result && !lha_extract_command_archive("lha l a.lha", path, sizeof(path), dest,
+                                                    sizeof(dest), &keep_paths);
+    result = result && !lha_extract_command_archive("lha -a x a.lha", path, sizeof(path), dest,
+                                                    sizeof(dest), &keep_paths);
+    result = result && !lha_extract_command_archive("cd tmp && lha x a.lha", path, sizeof(path),
+                                                    dest, sizeof(dest), &keep_paths);
+    result = result && !lha_extract_command_archive("lha x", path, sizeof(path), dest,
+                                                    sizeof(dest), &keep_paths);
+    result = result && !lha_extract_command_archive(long_cmd, path, sizeof(path), long_dest,
+                                                    sizeof(long_dest), &keep_paths);
+
+    return result;
+}
+
+static bool test_parallel_extract(void)
+{
+    static const char *const names[] = {
+        "Volume.001", "Volume.002", "Volume.003", "Cmp1.001", "Cmp2.001", "Cmp3.001",
+        "Disk.info", "ReadMe", "first", "second"
+    };
+    test_image_t image = {NULL, 0};
+    test_progress_t progress = {0, 0, 0, false};
+    uint32_t expected_bytes = 0;
+    bool result;
+    int i;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    remove_outputs();
+
+    /* Members of different sizes and methods, some in a directory */
+    add_member(&image, "-lhd-", "Game\xff", NULL, NULL, 0, 0);
+    for (i = 0; i < 10; i++) {
+        static const char *const methods[] = {"-lh5-", "-lh6-", "-lh7-", "-lh0-"};
+        size_t length = 2000 + (size_t)i * 7000;
+        add_member(&image, methods[i % 4], i < 6 ? "Game\xff" : NULL, names[i],
+                   g_sample + i * 1000, length, ENC_BLOCK_DEFAULT);
+        expected_bytes += (uint32_t)length;
+    }
+    put8(&image, 0);
+
+    result = write_image(&image) &&
+             lha_extract_archive_parallel(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, 4,
+                                          count_progress, &progress) == LHA_EXTRACT_OK;
+    for (i = 0; i < 10 && result; i++) {
+        char path[128];
+        snprintf(path, sizeof(path), "%s/%s%s", TEST_DEST_DIR, i < 6 ? "Game/" : "", names[i]);
+        result = file_matches(path, g_sample + i * 1000, 2000 + (size_t)i * 7000);
+    }
+    /* Progress adds up across workers, one callback at a time */
+    result = result && progress.bytes == expected_bytes && progress.finished == 10 &&
+             !progress.overlapped;
+
+    /* The same name twice: the later member still wins */
+    remove_outputs();
+    image.length = 0;
+    add_member(&image, "-lh5-", NULL, "ReadMe", g_sample, 50000, ENC_BLOCK_DEFAULT);
+    add_member(&image, "-lh5-", NULL, "first", g_sample, 3000, ENC_BLOCK_DEFAULT);
+    add_member(&image, "-lh6-", NULL, "ReadMe", g_sample + 500, 1000, ENC_BLOCK_DEFAULT);
+    put8(&image, 0);
+    result = result && write_image(&image) &&
+             lha_extract_archive_parallel(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, 0, NULL, NULL) ==
+                 LHA_EXTRACT_OK &&
+             file_matches(TEST_DEST_DIR "/ReadMe", g_sample + 500, 1000) &&
+             file_matches(TEST_DEST_DIR "/first", g_sample, 3000);
+
+    remove_outputs();
+    free(image.data);
+    return result;
+}
+
+static bool test_source_kinds(void)
+{
+    static const int kinds[] = {LHA_SOURCE_MMAP, LHA_SOURCE_FILE};
+    test_image_t image = {NULL, 0};
+    lha_source_t source;
+    lha_archive_t archive;
+    lha_member_t member;
+    bool result = true;
+    size_t i;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    add_member(&image, "-lh5-", NULL, "packed", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT);
+    add_member(&image, "-lh0-", NULL, "stored", g_sample, TEST_DATA_SIZE, 0);
+    put8(&image, 0);
+    result = write_image(&image);
+
+    /* Every kind must give the same bytes */
+    for (i = 0; i < sizeof(kinds) / sizeof(kinds[0]) && result; i++) {
+        result = lha_source_open(&source, TEST_ARCHIVE_FILE, kinds[i]) &&
+                 source.kind == kinds[i] && source.size == image.length &&
+                 decode_all_members(&source, g_sample, TEST_DATA_SIZE, 2);
+        lha_source_close(&source);
+        if (!result) {
+            printf(" [%s]", lha_source_kind_name(kinds[i]));
+        }
+    }
+    lha_source_open_memory(&source, image.data, (uint32_t)image.length);
+    result = result && source.kind == LHA_SOURCE_MEMORY &&
+             decode_all_members(&source, g_sample, TEST_DATA_SIZE, 2);
+
+    /* A buffer cut short inside the stored data is a read error, not the end */
+    lha_source_open_memory(&source, image.data, (uint32_t)image.length - 100);
+    result = result && lha_archive_open_source(&archive, &source) &&
+             lha_archive_next(&archive, &member) && !lha_archive_next(&archive, &member) &&
+             archive.error == LHA_ARCHIVE_IO;
+    lha_archive_close(&archive);
+
+    result = result && !lha_source_open(&source, "lha_decode_missing.tmp", LHA_SOURCE_AUTO);
+    lha_source_close(&source);
+
+    free(image.data);
+    return result;
+}
+
+static bool test_crc_slices(void)
+{
+    size_t offset;
+    size_t length;
+    size_t split;
+
+    /* Every alignment, and lengths around the 8-byte steps */
+    for (offset = 0; offset < 8; offset++) {
+        for (length = 0; length <= 70; length++) {
+            if (lha_crc16_update(0, g_sample + offset, length) !=
+                test_crc16(g_sample + offset, length)) {
+                printf(" [offset %lu, length %lu]", (unsigned long)offset, (unsigned long)length);
+                return false;
+            }
+        }
+    }
+
+    /* Continuing from a partial CRC matches doing it in one go */
+    uint16_t whole = test_crc16(g_sample, 1000);
+    for (split = 0; split <= 1000; split += 37) {
+        uint16_t crc = lha_crc16_update(0, g_sample, split);
+        if (lha_crc16_update(crc, g_sample + split, 1000 - split) != whole) {
+            printf(" [split %lu]", (unsigned long)split);
+            return false;
+        }
+    }
+
+    return lha_crc16_update(0, g_sample, TEST_DATA_SIZE) == test_crc16(g_sample, TEST_DATA_SIZE) &&
+           lha_crc16_update(0x1234, NULL, 10) == 0x1234;
+}
+
+static bool test_archive_integrity(void)
+{
+    static const int expected[] = {
+        LHA_DECODE_OK, LHA_DECODE_BAD_CRC, LHA_DECODE_UNSUPPORTED, LHA_DECODE_OK, LHA_DECODE_OK
+    };
+    test_image_t image = {NULL, 0};
+    lha_test_report_t report;
+    size_t bad;
+    size_t old;
+    bool result;
+    uint32_t i;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    remove_outputs();
+
+    add_member(&image, "-lh5-", NULL, "good", g_sample, 50000, ENC_BLOCK_DEFAULT);
+    bad = image.length;
+    add_member(&image, "-lh6-", NULL, "bad", g_sample + 1000, 30000, ENC_BLOCK_DEFAULT);
+    image.data[bad + 21] ^= 0x01;     /* Level 2 header CRC field */
+    old = image.length;
+    add_member(&image, "-lh0-", NULL, "old", g_sample, 100, 0);
+    memcpy(image.data + old + 2, "-lh1-", 5);
+    add_member(&image, "-lhd-", "Dir\xff", NULL, NULL, 0, 0);
+    add_member(&image, "-lh7-", NULL, "large", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT);
+    put8(&image, 0);
+
+    /* Results come back in archive order, whatever order the workers took */
+    result = write_image(&image) &&
+             lha_test_archive(TEST_ARCHIVE_FILE, 3, &report) == LHA_EXTRACT_FAILED &&
+             report.member_count == 5 && report.failed_count == 2 &&
+             report.archive_error == LHA_ARCHIVE_OK;
+    for (i = 0; result && i < report.member_count; i++) {
+        result = report.members[i].result == expected[i];
+    }
+    result = result && strcmp(report.members[1].member.path, "bad") == 0 &&
+             !file_exists(TEST_DEST_DIR);
+    lha_test_report_free(&report);
+
+    /* Cut off inside the last member: the ones before it are still tested */
+    image.length -= 1000;
+    result = result && write_image(&image) &&
+             lha_test_archive(TEST_ARCHIVE_FILE, 1, &report) == LHA_EXTRACT_FAILED &&
+             report.member_count == 4 && report.archive_error == LHA_ARCHIVE_IO &&
+             report.members[0].result == LHA_DECODE_OK;
+    lha_test_report_free(&report);
+
+    /* A sound archive passes */
+    image.length = 0;
+    add_member(&image, "-lh5-", NULL, "good", g_sample, 50000, ENC_BLOCK_DEFAULT);
+    add_member(&image, "-lh7-", NULL, "large", g_sample, TEST_DATA_SIZE, ENC_BLOCK_DEFAULT);
+    put8(&image, 0);
+    result = result && write_image(&image) &&
+             lha_test_archive(TEST_ARCHIVE_FILE, 0, &report) == LHA_EXTRACT_OK &&
+             report.member_count == 2 && report.failed_count == 0;
+    lha_test_report_free(&report);
+
+    result = result &&
+             lha_test_archive("lha_decode_missing.tmp", 0, &report) == LHA_EXTRACT_NOT_HANDLED &&
+             report.member_count == 0 && report.members == NULL;
+
+    free(image.data);
+    return result;
+}
+
+static bool test_restored_attributes(void)
+{
+#ifdef PLATFORM_AMIGA
+    /* Native extraction leaves protection bits and dates to LhA here */
+    return true;
+#else
+    test_image_t image = {NULL, 0};
+    struct stat info;
+    bool result;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    /* add_member() stamps every member with Unix time 1000000000 */
+    add_member_mode(&image, "-lh5-", NULL, "first", g_sample, 5000, ENC_BLOCK_DEFAULT, 0100640);
+    add_member(&image, "-lh0-", NULL, "second", g_sample, 100, 0);
+    put8(&image, 0);
+    remove_outputs();
+
+    result = write_image(&image) &&
+             lha_extract_archive(TEST_ARCHIVE_FILE, TEST_DEST_DIR, true, NULL, NULL) ==
+                 LHA_EXTRACT_OK;
+    result = result && stat(TEST_DEST_DIR "/first", &info) == 0 &&
+             info.st_mtime == 1000000000 && (info.st_mode & 07777) == 0640;
+    /* No mode stored: the file keeps what it was created with */
+    result = result && stat(TEST_DEST_DIR "/second", &info) == 0 &&
+             info.st_mtime == 1000000000 && (info.st_mode & 0200) != 0;
+
+    remove_outputs();
+    free(image.data);
+    return result;
+#endif
+}
+
+/* Text-like data with short and long repeats, a random stretch and a run */
+static void make_sample(uint8_t *data, size_t length)
+{
+    static const char *const words[] = {
+        "Amiga ", "disk ", "LhA ", "archive ", "the ", "game ", "of ", "and ",
+        "install ", "WHDLoad ", "slave ", "\n", "data ", "icon ", "A10 ", "tank "
+    };
+    uint32_t seed = 12345;
+    size_t pos = 0;
+
+    while (pos < length) {
+        seed = seed * 1103515245UL + 12345;
+        uint32_t pick = (seed >> 16) & 0x7FFF;
+
+        if (pos >= 60000 && pos < 61000) {
+            data[pos++] = (uint8_t)(pick >> 3);          /* Little to match */
+        } else if (pos >= 110000 && pos < 111000) {
+            data[pos] = data[pos - 50000];              /* Only -lh7- reaches this far */
+            pos++;
+        } else if (pos >= 120000 && pos < 121000) {
+            data[pos++] = 0;                             /* Overlapping copy, distance 1 */
+        } else {
+            const char *word = words[pick & 15];
+            while (*word && pos < length) {
+                data[pos++] = (uint8_t)*word++;
+            }
+        }
+    }
+}
+
+static uint16_t test_crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0;
+    size_t i;
+    int bit;
+
+    for (i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static void put_bits(bit_writer_t *writer, int count, uint32_t value)
+{
+    while (count-- > 0) {
+        writer->bits = (writer->bits << 1) | ((value >> count) & 1);
+        if (++writer->bit_count == 8) {
+            writer->data[writer->length++] = (uint8_t)writer->bits;
+            writer->bits = 0;
+            writer->bit_count = 0;
+        }
+    }
+}
+
+static void flush_bits(bit_writer_t *writer)
+{
+    if (writer->bit_count > 0) {
+        put_bits(writer, 8 - writer->bit_count, 0);
+    }
+}
+
+/* Huffman code lengths, flattened by halving counts until none exceeds 16 */
+static void huffman_lengths(const uint32_t *freq, int n, uint8_t *len)
+{
+    uint32_t weight[2 * ENC_NC];
+    int parent[2 * ENC_NC];
+    bool active[2 * ENC_NC];
+    uint32_t scaled[ENC_NC];
+    int i;
+
+    for (i = 0; i < n; i++) {
+        scaled[i] = freq[i];
+    }
+
+    for (;;) {
+        int nodes = n;
+        int max_len = 0;
+
+        for (i = 0; i < n; i++) {
+            weight[i] = scaled[i];
+            parent[i] = -1;
+            active[i] = scaled[i] > 0;
+        }
+        for (;;) {
+            int a = -1;
+            int b = -1;
+            for (i = 0; i < nodes; i++) {
+                if (!active[i]) {
+                    continue;
+                }
+                if (a < 0 || weight[i] < weight[a]) {
+                    b = a;
+                    a = i;
+                } else if (b < 0 || weight[i] < weight[b]) {
+                    b = i;
+                }
+            }
+            if (b < 0) {
+                break;
+            }
+            weight[nodes] = weight[a] + weight[b];
+            parent[nodes] = -1;
+            active[nodes] = true;
+            parent[a] = nodes;
+            parent[b] = nodes;
+            active[a] = false;
+            active[b] = false;
+            nodes++;
+        }
+
+        for (i = 0; i < n; i++) {
+            int depth = 0;
+            int node = i;
+            if (scaled[i] == 0) {
+                len[i] = 0;
+                continue;
+            }
+            while (parent[node] >= 0) {
+                node = parent[node];
+                depth++;
+            }
+            len[i] = (uint8_t)depth;
+            if (depth > max_len) {
+                max_len = depth;
+            }
+        }
+        if (max_len <= ENC_MAX_CODE) {
+            return;
+        }
+        for (i = 0; i < n; i++) {
+            if (scaled[i] > 0) {
+                scaled[i] = (scaled[i] + 1) / 2;
+            }
+        }
+    }
+}
+
+/* Canonical codes, shorter codes first and symbols in order within a length */
+static void make_codes(const uint8_t *len, int n, uint16_t *code)
+{
+    uint32_t count[ENC_MAX_CODE + 2] = {0};
+    uint32_t start[ENC_MAX_CODE + 2];
+    int i;
+
+    for (i = 0; i < n; i++) {
+        count[len[i]]++;
+    }
+    start[1] = 0;
+    for (i = 1; i <= ENC_MAX_CODE; i++) {
+        start[i + 1] = (start[i] + count[i]) << 1;
+    }
+    for (i = 0; i < n; i++) {
+        code[i] = len[i] ? (uint16_t)start[len[i]]++ : 0;
+    }
+}
+
+static int used_symbols(const uint32_t *freq, int n, int *out_only)
+{
+    int used = 0;
+    int i;
+
+    *out_only = 0;
+    for (i = 0; i < n; i++) {
+        if (freq[i] > 0) {
+            used++;
+            *out_only = i;
+        }
+    }
+    return used;
+}
+
+/* Number of significant bits in a distance */
+static int distance_code(uint16_t p)
+{
+    int bits = 0;
+
+    while (p) {
+        bits++;
+        p >>= 1;
+    }
+    return bits;
+}
+
+static void write_pt_len(bit_writer_t *writer, const uint8_t *len, int n, int nbit, int i_special)
+{
+    int i = 0;
+
+    while (n > 0 && len[n - 1] == 0) {
+        n--;
+    }
+    put_bits(writer, nbit, (uint32_t)n);
+    while (i < n) {
+        int k = len[i++];
+        if (k <= 6) {
+            put_bits(writer, 3, (uint32_t)k);
+        } else {
+            put_bits(writer, k - 3, (1u << (k - 3)) - 2);
+        }
+        if (i == i_special) {
+            while (i < 6 && len[i] == 0) {
+                i++;
+            }
+            put_bits(writer, 2, (uint32_t)((i - 3) & 3));
+        }
+    }
+}
+
+/* Literal/length code lengths as code length codes, runs of zeros folded */
+static size_t make_t_symbols(const uint8_t *c_len, enc_t_symbol_t *out)
+{
+    size_t count = 0;
+    int n = ENC_NC;
+    int i = 0;
+
+    while (n > 0 && c_len[n - 1] == 0) {
+        n--;
+    }
+    while (i < n) {
+        int k = c_len[i++];
+        if (k != 0) {
+            out[count].symbol = (uint8_t)(k + 2);
+            out[count++].extra_bits = 0;
+            continue;
+        }
+        int run = 1;
+        while (i < n && c_len[i] == 0) {
+            i++;
+            run++;
+        }
+        if (run <= 2) {
+            while (run-- > 0) {
+                out[count].symbol = 0;
+                out[count++].extra_bits = 0;
+            }
+        } else if (run <= 18) {
+            out[count].symbol = 1;
+            out[count].extra_bits = 4;
+            out[count++].extra = (uint16_t)(run - 3);
+        } else if (run == 19) {
+            out[count].symbol = 0;
+            out[count++].extra_bits = 0;
+            out[count].symbol = 1;
+            out[count].extra_bits = 4;
+            out[count++].extra = 15;
+        } else {
+            out[count].symbol = 2;
+            out[count].extra_bits = ENC_CBIT;
+            out[count++].extra = (uint16_t)(run - 20);
+        }
+    }
+    return count;
+}
+
+static void send_block(bit_writer_t *writer, const enc_symbol_t *symbols, size_t count,
+                       int np, int pbit)
+{
+    uint32_t c_freq[ENC_NC] = {0};
+    uint32_t p_freq[ENC_NC] = {0};
+    uint32_t t_freq[ENC_NT] = {0};
+    uint8_t c_len[ENC_NC] = {0};
+    uint8_t p_len[ENC_NT] = {0};
+    uint8_t t_len[ENC_NT] = {0};
+    uint16_t c_code[ENC_NC];
+    uint16_t p_code[ENC_NT];
+    uint16_t t_code[ENC_NT];
+    enc_t_symbol_t t_symbols[2 * ENC_NC];
+    size_t i;
+    int only;
+
+    for (i = 0; i < count; i++) {
+        c_freq[symbols[i].c]++;
+        if (symbols[i].c >= 256) {
+            p_freq[distance_code(symbols[i].p)]++;
+        }
+    }
+
+    put_bits(writer, 16, (uint32_t)count);
+
+    if (used_symbols(c_freq, ENC_NC, &only) >= 2) {
+        huffman_lengths(c_freq, ENC_NC, c_len);
+        size_t t_count = make_t_symbols(c_len, t_symbols);
+        for (i = 0; i < t_count; i++) {
+            t_freq[t_symbols[i].symbol]++;
+        }
+        if (used_symbols(t_freq, ENC_NT, &only) >= 2) {
+            huffman_lengths(t_freq, ENC_NT, t_len);
+            write_pt_len(writer, t_len, ENC_NT, ENC_TBIT, 3);
+        } else {
+            put_bits(writer, ENC_TBIT, 0);
+            put_bits(writer, ENC_TBIT, (uint32_t)only);
+        }
+        make_codes(t_len, ENC_NT, t_code);
+
+        int n = ENC_NC;
+        while (n > 0 && c_len[n - 1] == 0) {
+            n--;
+        }
+        put_bits(writer, ENC_CBIT, (uint32_t)n);
+        for (i = 0; i < t_count; i++) {
+            put_bits(writer, t_len[t_symbols[i].symbol], t_code[t_symbols[i].symbol]);
+            put_bits(writer, t_symbols[i].extra_bits, t_symbols[i].extra);
+        }
+    } else {
+        put_bits(writer, ENC_TBIT, 0);
+        put_bits(writer, ENC_TBIT, 0);
+        put_bits(writer, ENC_CBIT, 0);
+        put_bits(writer, ENC_CBIT, (uint32_t)only);
+    }
+    make_codes(c_len, ENC_NC, c_code);
+
+    if (used_symbols(p_freq, np, &only) >= 2) {
+        huffman_lengths(p_freq, np, p_len);
+        write_pt_len(writer, p_len, np, pbit, -1);
+    } else {
+        put_bits(writer, pbit, 0);
+        put_bits(writer, pbit, (uint32_t)only);
+    }
+    make_codes(p_len, np, p_code);
+
+    for (i = 0; i < count; i++) {
+        uint16_t c = symbols[i].c;
+        put_bits(writer, c_len[c], c_code[c]);
+        if (c >= 256) {
+            int pc = distance_code(symbols[i].p);
+            put_bits(writer, p_len[pc], p_code[pc]);
+            if (pc > 1) {
+                put_bits(writer, pc - 1, symbols[i].p);
+            }
+        }
+    }
+}
+
+/* Pack data with method into out; returns the packed size */
+static size_t encode(const char *method, const uint8_t *data, size_t length, size_t block_symbols,
+                     uint8_t *out)
+{
+    bit_writer_t writer = {out, 0, 0, 0};
+    int dicbit = strcmp(method, "-lh4-") == 0 ? 12 : strcmp(method, "-lh5-") == 0 ? 13 :
+                 strcmp(method, "-lh6-") == 0 ? 15 : 16;
+    int np = dicbit <= 13 ? 14 : dicbit + 1;
+    int pbit = dicbit <= 13 ? 4 : 5;
+    size_t max_distance = (size_t)1 << dicbit;
+    int32_t *head = (int32_t *)malloc(sizeof(int32_t) * ENC_HASH_SIZE);
+    int32_t *prev = (int32_t *)malloc(sizeof(int32_t) * (length + 1));
+    enc_symbol_t *symbols = (enc_symbol_t *)malloc(sizeof(enc_symbol_t) * block_symbols);
+    size_t count = 0;
+    size_t pos = 0;
+    size_t i;
+
+    if (strcmp(method, "-lh0-") == 0) {
+        memcpy(out, data, length);
+        free(head);
+        free(prev);
+        free(symbols);
+        return length;
+    }
+
+    for (i = 0; i < ENC_HASH_SIZE; i++) {
+        head[i] = -1;
+    }
+
+    while (pos < length) {
+        size_t best_length = 0;
+        size_t best_distance = 0;
+
+        if (pos + 3 <= length) {
+            uint32_t hash = ((uint32_t)data[pos] * 506832829u ^ (uint32_t)data[pos + 1] * 2654435761u ^
+                             data[pos + 2]) % ENC_HASH_SIZE;
+            int32_t candidate = head[hash];
+            int chain = 0;
+            while (candidate >= 0 && pos - (size_t)candidate <= max_distance &&
+                   chain++ < ENC_MAX_CHAIN) {
+                size_t match = 0;
+                while (match < ENC_MAX_MATCH && pos + match < length &&
+                       data[candidate + match] == data[pos + match]) {
+                    match++;
+                }
+                if (match > best_length) {
+                    best_length = match;
+                    best_distance = pos - (size_t)candidate;
+                }
+                candidate = prev[candidate];
+            }
+            prev[pos] = head[hash];
+            head[hash] = (int32_t)pos;
+        }
+
+        if (best_length >= 3) {
+            symbols[count].c = (uint16_t)(253 + best_length);
+            symbols[count].p = (uint16_t)(best_distance - 1);
+            /* Positions inside the match go into the chains too */
+            for (i = 1; i < best_length && pos + i + 3 <= length; i++) {
+                uint32_t hash = ((uint32_t)data[pos + i] * 506832829u ^
+                                 (uint32_t)data[pos + i + 1] * 2654435761u ^
+                                 data[pos + i + 2]) % ENC_HASH_SIZE;
+                prev[pos + i] = head[hash];
+                head[hash] = (int32_t)(pos + i);
+            }
+            pos += best_length;
+        } else {
+            symbols[count].c = data[pos];
+            symbols[count].p = 0;
+            pos++;
+        }
+        if (++count == block_symbols) {
+            send_block(&writer, symbols, count, np, pbit);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        send_block(&writer, symbols, count, np, pbit);
+    }
+    flush_bits(&writer);
+
+    free(head);
+    free(prev);
+    free(symbols);
+    return writer.length;
+}
+
+static void put8(test_image_t *image, uint8_t value)
+{
+    image->data[image->length++] = value;
+}
+
+static void put16(test_image_t *image, uint16_t value)
+{
+    put8(image, (uint8_t)(value & 0xFF));
+    put8(image, (uint8_t)(value >> 8));
+}
+
+static void put32(test_image_t *image, uint32_t value)
+{
+    put16(image, (uint16_t)(value & 0xFFFF));
+    put16(image, (uint16_t)(value >> 16));
+}
+
+static void put_bytes(test_image_t *image, const void *data, size_t length)
+{
+    memcpy(image->data + image->length, data, length);
+    image->length += length;
+}
+
+/* Level 2 header followed by the packed data; returns where the data starts */
+static size_t add_member(test_image_t *image, const char *method, const char *dir,
+                         const char *name, const uint8_t *data, size_t length,
+                         size_t block_symbols)
+{
+    return add_member_mode(image, method, dir, name, data, length, block_symbols, 0);
+}
+
+/* Level 2 member; a Unix mode extension is added when unix_mode is not 0 */
+static size_t add_member_mode(test_image_t *image, const char *method, const char *dir,
+                              const char *name, const uint8_t *data, size_t length,
+                              size_t block_symbols, uint16_t unix_mode)
+{
+    size_t dir_length = dir ? strlen(dir) : 0;
+    size_t name_length = name ? strlen(name) : 0;
+    size_t total = 26 + (name ? 3 + name_length : 0) + (dir ? 3 + dir_length : 0) +
+                   (unix_mode ? 5 : 0);
+    size_t start = image->length;
+
+    /* Header first with a zero packed size, patched once the data is in */
+    put16(image, (uint16_t)total);
+    put_bytes(image, method, 5);
+    put32(image, 0);
+    put32(image, (uint32_t)length);
+    put32(image, 1000000000UL);
+    put8(image, 0x20);
+    put8(image, 2);
+    put16(image, length ? test_crc16(data, length) : 0);
+    put8(image, 'U');
+    if (unix_mode) {
+        put16(image, 5);
+        put8(image, 0x50);
+        put16(image, unix_mode);
+    }
+    put16(image, name ? (uint16_t)(3 + name_length) : (dir ? (uint16_t)(3 + dir_length) : 0));
+    if (name) {
+        put8(image, 0x01);
+        put_bytes(image, name, name_length);
+        put16(image, dir ? (uint16_t)(3 + dir_length) : 0);
+    }
+    if (dir) {
+        put8(image, 0x02);
+        put_bytes(image, dir, dir_length);
+        put16(image, 0);
+    }
+
+    size_t data_start = image->length;
+    size_t packed = data ? encode(method, data, length, block_symbols, image->data + data_start) : 0;
+    image->length += packed;
+    image->data[start + 7] = (uint8_t)(packed & 0xFF);
+    image->data[start + 8] = (uint8_t)((packed >> 8) & 0xFF);
+    image->data[start + 9] = (uint8_t)((packed >> 16) & 0xFF);
+    image->data[start + 10] = (uint8_t)((packed >> 24) & 0xFF);
+    return data_start;
+}
+
+static bool write_image(const test_image_t *image)
+{
+    FILE *file = fopen(TEST_ARCHIVE_FILE, "wb");
+
+    if (!file) {
+        return false;
+    }
+
+    bool written = fwrite(image->data, 1, image->length, file) == image->length;
+    fclose(file);
+    return written;
+}
+
+static bool open_first_member(lha_source_t *source, lha_member_t *member)
+{
+    lha_archive_t archive;
+
+    if (!lha_source_open(source, TEST_ARCHIVE_FILE, LHA_SOURCE_DEFAULT)) {
+        return false;
+    }
+    /* The reader borrows the source, which stays open for the decoder */
+    if (!lha_archive_open_source(&archive, source) || !lha_archive_next(&archive, member)) {
+        lha_archive_close(&archive);
+        lha_source_close(source);
+        return false;
+    }
+    lha_archive_close(&archive);
+    return true;
+}
+
+static bool sink_output(const uint8_t *data, size_t length, void *user_data)
+{
+    test_sink_t *sink = (test_sink_t *)user_data;
+
+    sink->calls++;
+    if (sink->stop_after && sink->calls == sink->stop_after) {
+        return false;
+    }
+    if (sink->length + length > sink->capacity) {
+        size_t capacity = (sink->length + length) * 2;
+        uint8_t *grown = (uint8_t *)realloc(sink->data, capacity);
+        if (!grown) {
+            return false;
+        }
+        sink->data = grown;
+        sink->capacity = capacity;
+    }
+    memcpy(sink->data + sink->length, data, length);
+    sink->length += length;
+    return true;
+}
+
+/* Decode the first member of the test archive into sink */
+static int decode_first(test_sink_t *sink)
+{
+    lha_source_t source;
+    lha_member_t member;
+
+    if (!open_first_member(&source, &member)) {
+        return -1;
+    }
+    int result = lha_decode_member(&source, &member, sink_output, sink);
+    lha_source_close(&source);
+    return result;
+}
+
+static bool round_trip(const char *method, const uint8_t *data, size_t length,
+                       size_t block_symbols)
+{
+    test_image_t image = {NULL, 0};
+    test_sink_t sink = {NULL, 0, 0, 0, 0};
+    bool result;
+
+    image.data = (uint8_t *)malloc(TEST_IMAGE_SIZE);
+    if (!image.data) {
+        return false;
+    }
+    add_member(&image, method, NULL, "file", data, length, block_symbols);
+    put8(&image, 0);
+
+    result = write_image(&image) && decode_first(&sink) == LHA_DECODE_OK &&
+             sink.length == length && (length == 0 || memcmp(sink.data, data, length) == 0);
+    if (!result) {
+        printf(" [%s, %lu bytes]", method, (unsigned long)length);
+    }
+
+    free(sink.data);
+    free(image.data);
+    return result;
+}
+
+/* Walk source and decode every member; each must come out as data */
+static bool decode_all_members(lha_source_t *source, const uint8_t *data, size_t length,
+                               uint32_t expected_members)
+{
+    lha_archive_t archive;
+    lha_member_t member;
+    bool result = lha_archive_open_source(&archive, source);
+
+    while (result && lha_archive_next(&archive, &member)) {
+        test_sink_t sink = {NULL, 0, 0, 0, 0};
+        result = lha_decode_member(source, &member, sink_output, &sink) == LHA_DECODE_OK &&
+                 sink.length == length && memcmp(sink.data, data, length) == 0;
+        free(sink.data);
+    }
+
+    result = result && archive.error == LHA_ARCHIVE_OK &&
+             archive.member_count == expected_members;
+    lha_archive_close(&archive);
+    return result;
+}
+
+static bool file_matches(const char *path, const uint8_t *data, size_t length)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t buffer[4096];
+    size_t offset = 0;
+    size_t got;
+    bool match = true;
+
+    if (!file) {
+        return false;
+    }
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        if (offset + got > length || memcmp(buffer, data + offset, got) != 0) {
+            match = false;
+            break;
+        }
+        offset += got;
+    }
+    fclose(file);
+    return match && offset == length;
+}
+
+static bool file_exists(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+static void count_progress(const lha_member_t *member, uint32_t new_bytes, bool finished,
+                           void *user_data)
+{
+    test_progress_t *progress = (test_progress_t *)user_data;
+
+    (void)member;
+    if (++progress->active > 1) {
+        progress->overlapped = true;
+    }
+    progress->bytes += new_bytes;
+    if (finished) {
+        progress->finished++;
+    }
+    progress->active--;
+}
+
+/* remove() also takes empty directories, deepest first */
+static void remove_outputs(void)
+{
+    static const char *const game_files[] = {
+        "Volume.001", "Volume.002", "Volume.003", "Cmp1.001", "Cmp2.001", "Cmp3.001"
+    };
+    char path[128];
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        snprintf(path, sizeof(path), "%s/Game/%s", TEST_DEST_DIR, game_files[i]);
+        remove(path);
+    }
+    remove(TEST_DEST_DIR "/Disk.info");
+    remove(TEST_DEST_DIR "/Game/Data/level.dat");
+    remove(TEST_DEST_DIR "/Game/Data");
+    remove(TEST_DEST_DIR "/Game");
+    remove(TEST_DEST_DIR "/level.dat");
+    remove(TEST_DEST_DIR "/ReadMe");
+    remove(TEST_DEST_DIR "/first");
+    remove(TEST_DEST_DIR "/second");
+    remove(TEST_DEST_DIR);
+}
+
+/* Level 1 headers with Unix mode and time extensions, as LHa for UNIX
+ * writes them; manual.txt is the first 4 KB of assets/LhA.manual.txt */
+static bool test_sample_archive(void)
+{
+    static const struct {
+        const char *path;
+        uint32_t size;
+        uint16_t crc;
+        uint16_t unix_mode;
+        uint32_t offset;              /* Where text is found in the member */
+        const char *text;
+    } expected[] = {
+        {"manual.txt", 4096, 0x8F0E, 0100644, 0x31, "LhA User's Guide\n"},
+        {"hello.txt", 28, 0x5885, 0100600, 0, "Hello from the LH5 fixture.\n"}
+    };
+    lha_archive_t archive;
+    lha_member_t member;
+    uint32_t count = 0;
+    bool result = true;
+
+    if (!lha_archive_open(&archive, TEST_SAMPLE_ARCHIVE)) {
+        printf("   %s is missing\n", TEST_SAMPLE_ARCHIVE);
+        return false;
+    }
+
+    while (result && lha_archive_next(&archive, &member)) {
+        test_sink_t sink = {NULL, 0, 0, 0, 0};
+        size_t text_length;
+
+        if (count >= sizeof(expected) / sizeof(expected[0])) {
+            result = false;
+            break;
+        }
+        text_length = strlen(expected[count].text);
+        result = strcmp(member.method, "-lh5-") == 0 && member.level == 1 &&
+                 member.os_id == 'U' && strcmp(member.path, expected[count].path) == 0 &&
+                 member.original_size == expected[count].size &&
+                 member.crc == expected[count].crc &&
+                 member.unix_mode == expected[count].unix_mode &&
+                 member.unix_time && member.timestamp == 1710000000UL;
+
+        /* The decoder checks the CRC itself; the test checks it again */
+        result = result &&
+                 lha_decode_member(archive.source, &member, sink_output, &sink) == LHA_DECODE_OK &&
+                 sink.length == expected[count].size &&
+                 test_crc16(sink.data, sink.length) == expected[count].crc &&
+                 memcmp(sink.data + expected[count].offset, expected[count].text, text_length) == 0;
+        free(sink.data);
+        count++;
+    }
+
+    result = result && archive.error == LHA_ARCHIVE_OK && count == 2;
+    lha_archive_close(&archive);
+    return result;
+}
@@ -0,0 +1,271 @@
+/*
+ * LHA Source Benchmark - Compares the archive access strategies (mapped
+ * file, pread() into buffers, whole archive in memory) on large generated
+ * archives: once with many small members, where the header walk dominates,
+ * and once with a few large ones, where moving packed data does. Members
+ * are stored (-lh0-) so the decoder cost is the CRC and the copying alone.
+ *
+ * The archives are written and then read back while still in the page
+ * cache, so the numbers are the access overhead rather than disk speed.
+ */
+
+#define _POSIX_C_SOURCE 200809L       /* clock_gettime() */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/lha_archive.h"
+#include "../src/lha_decode.h"
+#include "../src/lha_source.h"
+
+#define BENCH_ARCHIVE_FILE "lha_source_bench.tmp"
+#define BENCH_DEFAULT_RUNS 5
+
+/* Level 0 header: fixed part, name length byte, name, CRC */
+#define BENCH_HEADER_FIXED 22
+
+/* One generated archive */
+typedef struct {
+    const char *name;
+    uint32_t members;
+    uint32_t min_size;
+    uint32_t max_size;
+} bench_archive_t;
+
+static const bench_archive_t bench_archives[] = {
+    {"20000 x 0-4 KB", 20000, 0, 4096},
+    {"64 x 1 MB", 64, 1024 * 1024, 1024 * 1024}
+};
+
+/* Internal helper functions */
+static uint64_t now_ns(void);
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length);
+static bool write_archive(const bench_archive_t *spec, uint64_t *out_bytes);
+static bool open_kind(lha_source_t *source, int kind, uint8_t **out_buffer);
+static bool walk_headers(lha_source_t *source);
+static bool decode_all(lha_source_t *source);
+static void run_kind(int kind, int runs, uint64_t bytes);
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_RUNS;
+    static const int kinds[] = {LHA_SOURCE_MMAP, LHA_SOURCE_FILE, LHA_SOURCE_MEMORY};
+    size_t a;
+    size_t k;
+
+    if (runs <= 0) {
+        printf("Usage: %s [runs]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== LHA Source Benchmark ===\n");
+    printf("Best of %d runs (milliseconds; MB/s over the whole archive)\n", runs);
+
+    for (a = 0; a < sizeof(bench_archives) / sizeof(bench_archives[0]); a++) {
+        uint64_t bytes = 0;
+
+        if (!write_archive(&bench_archives[a], &bytes)) {
+            printf("ERROR: Could not write %s\n", BENCH_ARCHIVE_FILE);
+            remove(BENCH_ARCHIVE_FILE);
+            return 1;
+        }
+        printf("\n%s (%.1f MB)\n", bench_archives[a].name, (double)bytes / (1024.0 * 1024.0));
+        printf("%-8s %10s %10s %10s %10s\n", "source", "open", "walk", "decode", "MB/s");
+        for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+            run_kind(kinds[k], runs, bytes);
+        }
+    }
+
+    remove(BENCH_ARCHIVE_FILE);
+    return 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length)
+{
+    size_t i;
+    int bit;
+
+    for (i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (bit = 0; bit < 8; bit++) {
+            crc = (uint16_t)((crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1);
+        }
+    }
+    return crc;
+}
+
+/* Stored members with level 0 headers; contents come from one pool of
+ * pseudo-random bytes so writing stays quick */
+static bool write_archive(const bench_archive_t *spec, uint64_t *out_bytes)
+{
+    FILE *file = fopen(BENCH_ARCHIVE_FILE, "wb");
+    uint8_t *pool = (uint8_t *)malloc(spec->max_size + 1);
+    uint32_t seed = 12345;
+    uint64_t bytes = 0;
+    bool ok = file && pool;
+    uint32_t i;
+
+    for (i = 0; ok && i <= spec->max_size; i++) {
+        seed = seed * 1103515245u + 12345u;
+        pool[i] = (uint8_t)(seed >> 16);
+    }
+
+    for (i = 0; ok && i < spec->members; i++) {
+        uint8_t header[BENCH_HEADER_FIXED + 16 + 2];
+        char name[16];
+        uint32_t span = spec->max_size - spec->min_size;
+        uint32_t size;
+        uint32_t start;
+        size_t name_length;
+        size_t total;
+        size_t j;
+        uint8_t sum = 0;
+
+        seed = seed * 1103515245u + 12345u;
+        size = spec->min_size + (span ? (seed >> 8) % (span + 1) : 0);
+        start = (seed >> 4) % (spec->max_size - size + 1);
+        name_length = (size_t)snprintf(name, sizeof(name), "f%05lu.dat", (unsigned long)i);
+        total = BENCH_HEADER_FIXED + name_length + 2;
+        uint16_t crc = crc16(0, pool + start, size);
+
+        header[0] = (uint8_t)(total - 2);
+        memcpy(header + 2, "-lh0-", 5);
+        for (j = 0; j < 4; j++) {
+            header[7 + j] = (uint8_t)(size >> (8 * j));
+            header[11 + j] = (uint8_t)(size >> (8 * j));
+            header[15 + j] = 0;
+        }
+        header[19] = 0x20;
+        header[20] = 0;
+        header[21] = (uint8_t)name_length;
+        memcpy(header + BENCH_HEADER_FIXED, name, name_length);
+        header[BENCH_HEADER_FIXED + name_length] = (uint8_t)(crc & 0xFF);
+        header[BENCH_HEADER_FIXED + name_length + 1] = (uint8_t)(crc >> 8);
+        for (j = 2; j < total; j++) {
+            sum = (uint8_t)(sum + header[j]);
+        }
+        header[1] = sum;
+
+        ok = fwrite(header, 1, total, file) == total &&
+             fwrite(pool + start, 1, size, file) == size;
+        bytes += total + size;
+    }
+
+    ok = ok && fputc(0, file) != EOF;
+    bytes++;
+    if (file && fclose(file) != 0) {
+        ok = false;
+    }
+    free(pool);
+    *out_bytes = bytes;
+    return ok;
+}
+
+/* The memory kind loads the whole file first, which counts as its open */
+static bool open_kind(lha_source_t *source, int kind, uint8_t **out_buffer)
+{
+    *out_buffer = NULL;
+    if (kind != LHA_SOURCE_MEMORY) {
+        return lha_source_open(source, BENCH_ARCHIVE_FILE, kind);
+    }
+
+    FILE *file = fopen(BENCH_ARCHIVE_FILE, "rb");
+    long size = -1;
+    bool ok = false;
+
+    if (file && fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 &&
+        fseek(file, 0, SEEK_SET) == 0) {
+        *out_buffer = (uint8_t *)malloc((size_t)size);
+        ok = *out_buffer && fread(*out_buffer, 1, (size_t)size, file) == (size_t)size;
+    }
+    if (file) {
+        fclose(file);
+    }
+    if (!ok) {
+        free(*out_buffer);
+        *out_buffer = NULL;
+        return false;
+    }
+    lha_source_open_memory(source, *out_buffer, (uint32_t)size);
+    return true;
+}
+
+static bool walk_headers(lha_source_t *source)
+{
+    lha_archive_t archive;
+    lha_member_t member;
+
+    lha_archive_open_source(&archive, source);
+    while (lha_archive_next(&archive, &member)) {
+    }
+    lha_archive_close(&archive);
+    return archive.error == LHA_ARCHIVE_OK;
+}
+
+/* Every member through the decoder with its output discarded */
+static bool decode_all(lha_source_t *source)
+{
+    lha_archive_t archive;
+    lha_member_t member;
+    bool ok = true;
+
+    lha_archive_open_source(&archive, source);
+    while (ok && lha_archive_next(&archive, &member)) {
+        ok = lha_decode_member(source, &member, NULL, NULL) == LHA_DECODE_OK;
+    }
+    ok = ok && archive.error == LHA_ARCHIVE_OK;
+    lha_archive_close(&archive);
+    return ok;
+}
+
+static void run_kind(int kind, int runs, uint64_t bytes)
+{
+    uint64_t best_open = UINT64_MAX;
+    uint64_t best_walk = UINT64_MAX;
+    uint64_t best_decode = UINT64_MAX;
+    int i;
+
+    for (i = 0; i < runs; i++) {
+        lha_source_t source;
+        uint8_t *buffer;
+        uint64_t start = now_ns();
+
+        if (!open_kind(&source, kind, &buffer)) {
+            printf("%-8s could not be opened\n", lha_source_kind_name(kind));
+            return;
+        }
+        uint64_t opened = now_ns();
+        bool ok = walk_headers(&source);
+        uint64_t walked = now_ns();
+        ok = ok && decode_all(&source);
+        uint64_t decoded = now_ns();
+        lha_source_close(&source);
+        free(buffer);
+
+        if (!ok) {
+            printf("%-8s failed to read the archive\n", lha_source_kind_name(kind));
+            return;
+        }
+        if (opened - start < best_open) best_open = opened - start;
+        if (walked - opened < best_walk) best_walk = walked - opened;
+        if (decoded - walked < best_decode) best_decode = decoded - walked;
+    }
+
+    /* Throughput of a full pass: open, walk and decode */
+    double total_s = (double)(best_open + best_walk + best_decode) / 1e9;
+    printf("%-8s %10.2f %10.2f %10.2f %10.0f\n", lha_source_kind_name(kind),
+           (double)best_open / 1e6, (double)best_walk / 1e6, (double)best_decode / 1e6,
+           total_s > 0 ? (double)bytes / (1024.0 * 1024.0) / total_s : 0.0);
+}
@@ -0,0 +1,167 @@
+/*
+ * Line Scan Benchmark - Compares the scalar and SIMD delimiter/ESC scanners
+ * on recorded LhA output, both as a bare scan and driving the line splitter
+ * the way the host reader does (4096-byte reads, views, escape stripping).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/line_scan.h"
+#include "../src/line_splitter.h"
+
+#define BENCH_EXTRACT_LOG "assets/lha-extract.txt"
+#define BENCH_CATALOG_SIZE (4 * 1024 * 1024)
+#define BENCH_REPLAYS 20
+#define BENCH_READ_SIZE 4096
+
+/* Internal helper functions */
+static uint32_t scan_all(const char *data, size_t size, bool find_escape);
+static uint32_t split_all(const char *data, size_t size);
+static bool count_view(const char *line, size_t length, void *user_data);
+static void run_level(int level, const char *catalog, size_t size);
+static char *load_file(const char *path, size_t *out_size);
+
+int main(int argc, char **argv)
+{
+    size_t size;
+    size_t offset;
+    char *data = load_file(argc > 1 ? argv[1] : BENCH_EXTRACT_LOG, &size);
+    int level;
+
+    if (!data || size == 0) {
+        printf("ERROR: Could not read %s\n", argc > 1 ? argv[1] : BENCH_EXTRACT_LOG);
+        free(data);
+        return 1;
+    }
+
+    /* Repeat the recording into one large catalog listing */
+    char *catalog = (char *)malloc(BENCH_CATALOG_SIZE);
+    if (!catalog) {
+        free(data);
+        return 1;
+    }
+    for (offset = 0; offset < BENCH_CATALOG_SIZE; offset += size) {
+        size_t len = BENCH_CATALOG_SIZE - offset < size ? BENCH_CATALOG_SIZE - offset : size;
+        memcpy(catalog + offset, data, len);
+    }
+
+    printf("=== Line Scan Benchmark ===\n");
+    printf("Input: %lu bytes of recorded output x %d replays, best level: %s\n\n",
+           (unsigned long)BENCH_CATALOG_SIZE, BENCH_REPLAYS,
+           line_scan_level_name(line_scan_best_level()));
+
+    for (level = LINE_SCAN_SCALAR; level <= line_scan_best_level(); level++) {
+        run_level(level, catalog, BENCH_CATALOG_SIZE);
+    }
+
+    free(catalog);
+    free(data);
+    return 0;
+}
+
+static uint32_t scan_all(const char *data, size_t size, bool find_escape)
+{
+    const char *end = data + size;
+    uint32_t hits = 0;
+
+    while (data < end) {
+        const char *hit = line_scan_next(data, (size_t)(end - data), find_escape);
+        if (!hit) {
+            break;
+        }
+        hits++;
+        data = hit + 1;
+    }
+
+    return hits;
+}
+
+static bool count_view(const char *line, size_t length, void *user_data)
+{
+    (void)line;
+    (void)length;
+    (*(uint32_t *)user_data)++;
+    return true;
+}
+
+static uint32_t split_all(const char *data, size_t size)
+{
+    static char read_buffer[BENCH_READ_SIZE];
+    line_splitter_t splitter;
+    uint32_t lines = 0;
+    size_t offset = 0;
+
+    if (!line_splitter_init_growable(&splitter, 0)) {
+        return 0;
+    }
+    line_splitter_set_strip_escapes(&splitter, true);
+
+    while (offset < size) {
+        size_t len = size - offset < sizeof(read_buffer) ? size - offset : sizeof(read_buffer);
+        /* Stands in for read() filling the buffer the views point into */
+        memcpy(read_buffer, data + offset, len);
+        line_splitter_feed_views(&splitter, read_buffer, len, count_view, &lines);
+        offset += len;
+    }
+    line_splitter_flush_views(&splitter, count_view, &lines);
+    line_splitter_free(&splitter);
+
+    return lines;
+}
+
+static void run_level(int level, const char *catalog, size_t size)
+{
+    uint32_t scan_hits = 0;
+    uint32_t lines = 0;
+    int replay;
+
+    line_scan_use_level(level);
+
+    clock_t start_time = clock();
+    for (replay = 0; replay < BENCH_REPLAYS; replay++) {
+        scan_hits = scan_all(catalog, size, false);
+    }
+    clock_t scan_time = clock();
+    for (replay = 0; replay < BENCH_REPLAYS; replay++) {
+        lines = split_all(catalog, size);
+    }
+    clock_t end_time = clock();
+
+    double total_bytes = (double)size * BENCH_REPLAYS;
+    double scan_seconds = (double)(scan_time - start_time) / CLOCKS_PER_SEC;
+    double split_seconds = (double)(end_time - scan_time) / CLOCKS_PER_SEC;
+
+    printf("%-6s  CR/LF scan: %8.1f MB/s (%lu hits)   split+strip: %8.1f MB/s (%lu lines)\n",
+           line_scan_level_name(level),
+           scan_seconds > 0.0 ? total_bytes / scan_seconds / 1e6 : 0.0,
+           (unsigned long)scan_hits,
+           split_seconds > 0.0 ? total_bytes / split_seconds / 1e6 : 0.0,
+           (unsigned long)lines);
+}
+
+static char *load_file(const char *path, size_t *out_size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = (char *)malloc(size > 0 ? (size_t)size : 1);
+    if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *out_size = data ? (size_t)size : 0;
+    return data;
+}
@@ -0,0 +1,191 @@
+/*
+ * Line Splitter Benchmark - Replays recorded LhA output through the old
+ * per-character reader and the memchr-based line splitter and reports
+ * throughput in bytes/sec for each.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/line_splitter.h"
+#include "../src/line_scan.h"
+
+#define BENCH_EXTRACT_LOG "assets/lha-extract.txt"
+#define BENCH_REPLAYS 20000
+
+/* Internal helper functions */
+static bool count_line(const char *line, void *user_data);
+static void legacy_split(const char *data, size_t size, size_t chunk_size, uint32_t *lines);
+static void splitter_split(const char *data, size_t size, size_t chunk_size, uint32_t *lines);
+static void view_split(const char *data, size_t size, size_t chunk_size, uint32_t *lines);
+static bool count_view(const char *line, size_t length, void *user_data);
+static void run_case(const char *name, const char *data, size_t size, size_t chunk_size,
+                     void (*split)(const char *, size_t, size_t, uint32_t *));
+static char *load_file(const char *path, size_t *out_size);
+
+int main(int argc, char **argv)
+{
+    size_t size;
+    char *data = load_file(argc > 1 ? argv[1] : BENCH_EXTRACT_LOG, &size);
+
+    if (!data) {
+        printf("ERROR: Could not read %s\n", argc > 1 ? argv[1] : BENCH_EXTRACT_LOG);
+        return 1;
+    }
+
+    line_scan_init();
+    printf("=== Line Splitter Benchmark ===\n");
+    printf("Input: %lu bytes x %d replays\n\n", (unsigned long)size, BENCH_REPLAYS);
+
+    run_case("legacy per-char, 63-byte reads ", data, size, 63, legacy_split);
+    run_case("splitter,        63-byte reads ", data, size, 63, splitter_split);
+    run_case("splitter,        4096-byte reads", data, size, 4096, splitter_split);
+    run_case("views+strip,     4096-byte reads", data, size, 4096, view_split);
+
+    free(data);
+    return 0;
+}
+
+static bool count_line(const char *line, void *user_data)
+{
+    (void)line;
+    (*(uint32_t *)user_data)++;
+    return true;
+}
+
+/* The reader as it was: strlen() per appended character, 120-char cap */
+static void legacy_split(const char *data, size_t size, size_t chunk_size, uint32_t *lines)
+{
+    char buf[64];
+    char partial_line[128] = {0};
+    size_t offset = 0;
+
+    while (offset < size) {
+        size_t len = size - offset < chunk_size ? size - offset : chunk_size;
+        memcpy(buf, data + offset, len);
+        buf[len] = '\0';
+        offset += len;
+
+        char *buffer_ptr = buf;
+        while (*buffer_ptr) {
+            char ch = *buffer_ptr++;
+
+            if (ch == '\n' || ch == '\r') {
+                if (strlen(partial_line) > 0) {
+                    count_line(partial_line, lines);
+                    partial_line[0] = '\0';
+                }
+            } else {
+                size_t line_len = strlen(partial_line);
+                if (line_len < 120) {
+                    partial_line[line_len] = ch;
+                    partial_line[line_len + 1] = '\0';
+                } else {
+                    count_line(partial_line, lines);
+                    partial_line[0] = ch;
+                    partial_line[1] = '\0';
+                }
+            }
+        }
+    }
+
+    if (strlen(partial_line) > 0) {
+        count_line(partial_line, lines);
+    }
+}
+
+static void splitter_split(const char *data, size_t size, size_t chunk_size, uint32_t *lines)
+{
+    char line_buffer[512];
+    line_splitter_t splitter;
+    size_t offset = 0;
+
+    line_splitter_init(&splitter, line_buffer, sizeof(line_buffer));
+
+    while (offset < size) {
+        size_t len = size - offset < chunk_size ? size - offset : chunk_size;
+        line_splitter_feed(&splitter, data + offset, len, count_line, lines);
+        offset += len;
+    }
+
+    line_splitter_flush(&splitter, count_line, lines);
+}
+
+static bool count_view(const char *line, size_t length, void *user_data)
+{
+    (void)line;
+    (void)length;
+    (*(uint32_t *)user_data)++;
+    return true;
+}
+
+/* Zero-copy views with in-place escape stripping, as the readers use it */
+static void view_split(const char *data, size_t size, size_t chunk_size, uint32_t *lines)
+{
+    static char read_buffer[4096];
+    char line_buffer[512];
+    line_splitter_t splitter;
+    size_t offset = 0;
+
+    line_splitter_init(&splitter, line_buffer, sizeof(line_buffer));
+    line_splitter_set_strip_escapes(&splitter, true);
+
+    while (offset < size) {
+        size_t len = size - offset < chunk_size ? size - offset : chunk_size;
+        if (len > sizeof(read_buffer)) {
+            len = sizeof(read_buffer);
+        }
+        /* Stands in for read() filling the buffer the views point into */
+        memcpy(read_buffer, data + offset, len);
+        line_splitter_feed_views(&splitter, read_buffer, len, count_view, lines);
+        offset += len;
+    }
+
+    line_splitter_flush_views(&splitter, count_view, lines);
+}
+
+static void run_case(const char *name, const char *data, size_t size, size_t chunk_size,
+                     void (*split)(const char *, size_t, size_t, uint32_t *))
+{
+    uint32_t lines = 0;
+    int replay;
+
+    clock_t start_time = clock();
+    for (replay = 0; replay < BENCH_REPLAYS; replay++) {
+        split(data, size, chunk_size, &lines);
+    }
+    clock_t end_time = clock();
+
+    double seconds = (double)(end_time - start_time) / CLOCKS_PER_SEC;
+    double total_bytes = (double)size * BENCH_REPLAYS;
+
+    printf("%s: %8.1f MB/s (%lu lines, %.3f s)\n", name,
+           seconds > 0.0 ? total_bytes / seconds / 1e6 : 0.0,
+           (unsigned long)(lines / BENCH_REPLAYS), seconds);
+}
+
+static char *load_file(const char *path, size_t *out_size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = (char *)malloc(size > 0 ? (size_t)size : 1);
+    if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *out_size = data ? (size_t)size : 0;
+    return data;
+}
@@ -0,0 +1,589 @@
+/*
+ * Line Splitter Test - Verifies line assembly across read chunk boundaries
+ * Replays recorded LhA output through the splitter in several chunk sizes
+ * and checks every chunking yields exactly the same lines.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../src/line_splitter.h"
+#include "../src/line_scan.h"
+
+#define TEST_EXTRACT_LOG "assets/lha-extract.txt"
+#define MAX_CAPTURED_LINES 128
+
+/* Collects delivered lines so chunkings can be compared */
+typedef struct {
+    char lines[MAX_CAPTURED_LINES][128];
+    int count;
+    int stop_after;
+} capture_context_t;
+
+static int tests_run = 0;
+static int tests_passed = 0;
+
+/* Test helper functions */
+static bool run_test(const char *test_name, bool (*test_func)(void));
+static bool capture_line(const char *line, void *user_data);
+static bool capture_view(const char *line, size_t length, void *user_data);
+static bool split_in_chunks(const char *data, size_t size, size_t chunk_size,
+                            capture_context_t *ctx);
+static bool strip_in_chunks(const char *data, size_t size, size_t chunk_size,
+                            capture_context_t *ctx);
+static char *load_file(const char *path, size_t *out_size);
+
+/* Test functions */
+static bool test_basic_lines(void);
+static bool test_line_spanning_chunks(void);
+static bool test_forced_split(void);
+static bool test_processor_stop(void);
+static bool test_recorded_output_chunkings(void);
+static bool test_growable_long_line(void);
+static bool test_line_limit(void);
+static bool test_zero_copy_views(void);
+static bool test_in_place_escape_stripping(void);
+static bool test_escape_split_across_chunks(void);
+static bool test_scan_levels_agree(void);
+static bool test_inline_buffer_spill(void);
+
+size_t __stack = 65536;  /* request a 64 KB stack */
+
+int main(void)
+{
+    printf("=== Line Splitter Test Suite ===\n");
+
+    run_test("Basic Lines", test_basic_lines);
+    run_test("Line Spanning Chunks", test_line_spanning_chunks);
+    run_test("Forced Split", test_forced_split);
+    run_test("Processor Stop", test_processor_stop);
+    run_test("Recorded Output Chunkings", test_recorded_output_chunkings);
+    run_test("Growable Long Line", test_growable_long_line);
+    run_test("Line Limit", test_line_limit);
+    run_test("Zero-Copy Views", test_zero_copy_views);
+    run_test("In-Place Escape Stripping", test_in_place_escape_stripping);
+    run_test("Escape Split Across Chunks", test_escape_split_across_chunks);
+    run_test("Scan Levels Agree", test_scan_levels_agree);
+    run_test("Inline Buffer Spill", test_inline_buffer_spill);
+
+    printf("\n=== Test Results ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_run - tests_passed);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}
+
+static bool run_test(const char *test_name, bool (*test_func)(void))
+{
+    printf("Running test: %s...", test_name);
+
+    tests_run++;
+    bool result = test_func();
+
+    if (result) {
+        printf(" PASSED\n");
+        tests_passed++;
+    } else {
+        printf(" FAILED\n");
+    }
+
+    return result;
+}
+
+static bool capture_line(const char *line, void *user_data)
+{
+    capture_context_t *ctx = (capture_context_t *)user_data;
+
+    if (ctx->count < MAX_CAPTURED_LINES) {
+        strncpy(ctx->lines[ctx->count], line, sizeof(ctx->lines[0]) - 1);
+        ctx->lines[ctx->count][sizeof(ctx->lines[0]) - 1] = '\0';
+    }
+    ctx->count++;
+
+    return ctx->stop_after == 0 || ctx->count < ctx->stop_after;
+}
+
+static bool capture_view(const char *line, size_t length, void *user_data)
+{
+    /* Views must be terminated at their length */
+    if (line[length] != '\0' || strlen(line) != length) {
+        return false;
+    }
+    return capture_line(line, user_data);
+}
+
+static bool split_in_chunks(const char *data, size_t size, size_t chunk_size,
+                            capture_context_t *ctx)
+{
+    char line_buffer[128];
+    line_splitter_t splitter;
+    size_t offset = 0;
+
+    line_splitter_init(&splitter, line_buffer, sizeof(line_buffer));
+
+    while (offset < size) {
+        size_t len = size - offset < chunk_size ? size - offset : chunk_size;
+        if (!line_splitter_feed(&splitter, data + offset, len, capture_line, ctx)) {
+            return false;
+        }
+        offset += len;
+    }
+
+    return line_splitter_flush(&splitter, capture_line, ctx);
+}
+
+/* Feeds copies of each chunk as views with escape stripping on */
+static bool strip_in_chunks(const char *data, size_t size, size_t chunk_size,
+                            capture_context_t *ctx)
+{
+    static char chunk[4096];
+    char line_buffer[128];
+    line_splitter_t splitter;
+    size_t offset = 0;
+
+    line_splitter_init(&splitter, line_buffer, sizeof(line_buffer));
+    line_splitter_set_strip_escapes(&splitter, true);
+
+    while (offset < size) {
+        size_t len = size - offset < chunk_size ? size - offset : chunk_size;
+        if (len > sizeof(chunk)) {
+            len = sizeof(chunk);
+        }
+        memcpy(chunk, data + offset, len);
+        if (!line_splitter_feed_views(&splitter, chunk, len, capture_view, ctx)) {
+            return false;
+        }
+        offset += len;
+    }
+
+    return line_splitter_flush_views(&splitter, capture_view, ctx);
+}
+
+static char *load_file(const char *path, size_t *out_size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *data = (char *)malloc(size > 0 ? (size_t)size : 1);
+    if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *out_size = data ? (size_t)size : 0;
+    return data;
+}
+
+static bool test_basic_lines(void)
+{
+    static capture_context_t ctx;
+    const char *data = "first\nsecond\r\n\r\nthird";
+
+    memset(&ctx, 0, sizeof(ctx));
+    if (!split_in_chunks(data, strlen(data), strlen(data), &ctx)) {
+        return false;
+    }
+
+    return ctx.count == 3 &&
+           strcmp(ctx.lines[0], "first") == 0 &&
+           strcmp(ctx.lines[1], "second") == 0 &&
+           strcmp(ctx.lines[2], "third") == 0;
+}
+
+static bool test_line_spanning_chunks(void)
+{
+    static capture_context_t ctx;
+    const char *data = " Extracting: (   10380)  A10TankKiller3Disk/data/A10\n";
+
+    /* One byte per chunk is the worst case for carrying partial lines */
+    memset(&ctx, 0, sizeof(ctx));
+    if (!split_in_chunks(data, strlen(data), 1, &ctx)) {
+        return false;
+    }
+
+    return ctx.count == 1 &&
+           strcmp(ctx.lines[0], " Extracting: (   10380)  A10TankKiller3Disk/data/A10") == 0;
+}
+
+static bool test_forced_split(void)
+{
+    static capture_context_t ctx;
+    char data[300];
+
+    memset(data, 'x', sizeof(data) - 1);
+    data[sizeof(data) - 1] = '\n';
+
+    /* 299 chars through a 128-byte buffer: 127 + 127 + 45 */
+    memset(&ctx, 0, sizeof(ctx));
+    if (!split_in_chunks(data, sizeof(data), 64, &ctx)) {
+        return false;
+    }
+
+    return ctx.count == 3 &&
+           strlen(ctx.lines[0]) == 127 &&
+           strlen(ctx.lines[1]) == 127 &&
+           strlen(ctx.lines[2]) == 45;
+}
+
+static bool test_processor_stop(void)
+{
+    static capture_context_t ctx;
+    const char *data = "one\ntwo\nthree\nfour\n";
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.stop_after = 2;
+
+    /* Feed must report the stop and deliver nothing after it */
+    if (split_in_chunks(data, strlen(data), 5, &ctx)) {
+        return false;
+    }
+
+    return ctx.count == 2 && strcmp(ctx.lines[1], "two") == 0;
+}
+
+static bool test_recorded_output_chunkings(void)
+{
+    static capture_context_t reference;
+    static capture_context_t ctx;
+    static const size_t chunk_sizes[] = {1, 7, 63, 128, 4096};
+    size_t size;
+    size_t i;
+    int line;
+    bool result = true;
+
+    char *data = load_file(TEST_EXTRACT_LOG, &size);
+    if (!data) {
+        printf(" (missing %s)", TEST_EXTRACT_LOG);
+        return false;
+    }
+
+    /* Whole file in one chunk is the reference splitting */
+    memset(&reference, 0, sizeof(reference));
+    split_in_chunks(data, size, size, &reference);
+
+    for (i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]) && result; i++) {
+        memset(&ctx, 0, sizeof(ctx));
+        split_in_chunks(data, size, chunk_sizes[i], &ctx);
+
+        if (ctx.count != reference.count) {
+            result = false;
+            break;
+        }
+        for (line = 0; line < ctx.count && line < MAX_CAPTURED_LINES; line++) {
+            if (strcmp(ctx.lines[line], reference.lines[line]) != 0) {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    free(data);
+    return result && reference.count > 30;
+}
+
+static bool test_growable_long_line(void)
+{
+    static capture_context_t ctx;
+    static char data[2001];
+    line_splitter_t splitter;
+    size_t offset;
+    bool result;
+
+    memset(data, 'p', sizeof(data) - 1);
+    data[sizeof(data) - 1] = '\n';
+
+    /* A 2000-char path must arrive as one line, whatever the chunk size */
+    memset(&ctx, 0, sizeof(ctx));
+    if (!line_splitter_init_growable(&splitter, 0)) {
+        return false;
+    }
+    for (offset = 0; offset < sizeof(data); offset += 100) {
+        line_splitter_feed(&splitter, data + offset, 100 < sizeof(data) - offset ? 100 : sizeof(data) - offset,
+                           capture_line, &ctx);
+    }
+    line_splitter_flush(&splitter, capture_line, &ctx);
+    result = ctx.count == 1 && splitter.forced_splits == 0 && splitter.capacity >= sizeof(data);
+    line_splitter_free(&splitter);
+    if (!result) {
+        return false;
+    }
+
+    /* With a length cap the same line is split at the cap */
+    memset(&ctx, 0, sizeof(ctx));
+    if (!line_splitter_init_growable(&splitter, 1000)) {
+        return false;
+    }
+    line_splitter_feed(&splitter, data, sizeof(data), capture_line, &ctx);
+    result = ctx.count == 2 && splitter.forced_splits == 1 && splitter.capacity == 1001;
+    line_splitter_free(&splitter);
+
+    return result && splitter.buffer == NULL;
+}
+
+static bool test_line_limit(void)
+{
+    static capture_context_t ctx;
+    const char *data = "one\ntwo\nthree\nfour\n";
+    line_splitter_t splitter;
+    bool fed;
+
+    memset(&ctx, 0, sizeof(ctx));
+    if (!line_splitter_init_growable(&splitter, 0)) {
+        return false;
+    }
+    line_splitter_set_line_limit(&splitter, 3);
+
+    /* The limit stops the feed and is distinguishable from a callback stop */
+    fed = line_splitter_feed(&splitter, data, strlen(data), capture_line, &ctx);
+    line_splitter_free(&splitter);
+
+    return !fed && splitter.limit_reached && ctx.count == 3 &&
+           strcmp(ctx.lines[2], "three") == 0;
+}
+
+/* Records where each view points so the test can tell copies from views */
+typedef struct {
+    const char *pointers[8];
+    int count;
+} view_pointer_context_t;
+
+static bool record_view_pointer(const char *line, size_t length, void *user_data)
+{
+    view_pointer_context_t *ctx = (view_pointer_context_t *)user_data;
+
+    (void)length;
+    if (ctx->count < 8) {
+        ctx->pointers[ctx->count] = line;
+    }
+    ctx->count++;
+    return true;
+}
+
+static bool test_zero_copy_views(void)
+{
+    static view_pointer_context_t ctx;
+    char chunk1[] = "alpha\nbeta\ngam";
+    char chunk2[] = "ma\ndelta\n";
+    char line_buffer[64];
+    line_splitter_t splitter;
+
+    memset(&ctx, 0, sizeof(ctx));
+    line_splitter_init(&splitter, line_buffer, sizeof(line_buffer));
+
+    if (!line_splitter_feed_views(&splitter, chunk1, strlen(chunk1), record_view_pointer, &ctx) ||
+        !line_splitter_feed_views(&splitter, chunk2, strlen(chunk2), record_view_pointer, &ctx) ||
+        !line_splitter_flush_views(&splitter, record_view_pointer, &ctx)) {
+        return false;
+    }
+
+    /* Lines inside a chunk point into it; only the spanning line is copied */
+    return ctx.count == 4 &&
+           ctx.pointers[0] == chunk1 &&
+           ctx.pointers[1] == chunk1 + 6 &&
+           ctx.pointers[2] == line_buffer &&
+           ctx.pointers[3] == chunk2 + 3 &&
+           strcmp(chunk1, "alpha") == 0;
+}
+
+static bool test_in_place_escape_stripping(void)
+{
+    static capture_context_t views;
+    static capture_context_t adapted;
+    char data[] = "\033[0m\033[K Extracting: (   10380)  A10\n\033[1mbold\033[0m\r\n\033[K\n";
+    char copy[sizeof(data)];
+    line_view_adapter_t adapter;
+    line_splitter_t splitter;
+
+    memcpy(copy, data, sizeof(data));
+
+    /* Stripped through the view API... */
+    memset(&views, 0, sizeof(views));
+    if (!line_splitter_init_growable(&splitter, 0)) {
+        return false;
+    }
+    line_splitter_set_strip_escapes(&splitter, true);
+    line_splitter_feed_views(&splitter, data, strlen(data), capture_view, &views);
+    line_splitter_free(&splitter);
+
+    /* ...and through the adapter for NUL-terminated callbacks */
+    memset(&adapted, 0, sizeof(adapted));
+    adapter.line_processor = capture_line;
+    adapter.user_data = &adapted;
+    if (!line_splitter_init_growable(&splitter, 0)) {
+        return false;
+    }
+    line_splitter_set_strip_escapes(&splitter, true);
+    line_splitter_feed_views(&splitter, copy, strlen(copy), line_view_adapter, &adapter);
+    line_splitter_free(&splitter);
+
+    /* A line that was only escape codes is skipped like an empty line */
+    return views.count == 2 && adapted.count == 2 &&
+           strcmp(views.lines[0], " Extracting: (   10380)  A10") == 0 &&
+           strcmp(views.lines[1], "bold") == 0 &&
+           strcmp(adapted.lines[1], "bold") == 0;
+}
+
+static bool test_escape_split_across_chunks(void)
+{
+    static capture_context_t reference;
+    static capture_context_t ctx;
+    const char *straddle = "abc\033[0;1";
+    const char *straddle_tail = "mdef\033";
+    const char *straddle_end = "[K\n";
+    char line_buffer[64];
+    line_splitter_t splitter;
+    size_t size;
+    size_t chunk_size;
+    int line;
+    bool result = true;
+
+    /* The classic failure: "[K" arriving in the read after its ESC */
+    memset(&ctx, 0, sizeof(ctx));
+    line_splitter_init(&splitter, line_buffer, sizeof(line_buffer));
+    line_splitter_set_strip_escapes(&splitter, true);
+    line_splitter_feed(&splitter, straddle, strlen(straddle), capture_line, &ctx);
+    line_splitter_feed(&splitter, straddle_tail, strlen(straddle_tail), capture_line, &ctx);
+    line_splitter_feed(&splitter, straddle_end, strlen(straddle_end), capture_line, &ctx);
+    if (ctx.count != 1 || strcmp(ctx.lines[0], "abcdef") != 0) {
+        return false;
+    }
+
+    char *data = load_file(TEST_EXTRACT_LOG, &size);
+    if (!data) {
+        printf(" (missing %s)", TEST_EXTRACT_LOG);
+        return false;
+    }
+
+    /* Every chunk size cuts some escape sequence somewhere */
+    memset(&reference, 0, sizeof(reference));
+    strip_in_chunks(data, size, size, &reference);
+
+    for (chunk_size = 1; chunk_size <= 64 && result; chunk_size++) {
+        memset(&ctx, 0, sizeof(ctx));
+        strip_in_chunks(data, size, chunk_size, &ctx);
+
+        if (ctx.count != reference.count) {
+            result = false;
+            break;
+        }
+        for (line = 0; line < ctx.count && line < MAX_CAPTURED_LINES; line++) {
+            if (strcmp(ctx.lines[line], reference.lines[line]) != 0 ||
+                strchr(ctx.lines[line], 27) != NULL) {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    free(data);
+    return result && reference.count > 30;
+}
+
+static bool test_scan_levels_agree(void)
+{
+    static char data[256];
+    static capture_context_t reference;
+    static capture_context_t ctx;
+    const int best = line_scan_best_level();
+    size_t size;
+    size_t start;
+    size_t i;
+    int level;
+    int line;
+    bool result = true;
+
+    /* Sparse specials at every offset and alignment the vector loops see */
+    memset(data, 'a', sizeof(data));
+    data[37] = 27;
+    data[100] = '\r';
+    data[161] = '\n';
+
+    for (start = 0; start < 64 && result; start++) {
+        size = sizeof(data) - start;
+        const char *expect_lines = memchr(data + start, '\r', size);
+        const char *expect_escapes = data + start <= data + 37 ? data + 37 : expect_lines;
+        if (!expect_lines) {
+            expect_lines = memchr(data + start, '\n', size);
+        }
+
+        for (level = LINE_SCAN_SCALAR; level <= best; level++) {
+            line_scan_use_level(level);
+            if (line_scan_next(data + start, size, false) != expect_lines ||
+                line_scan_next(data + start, size, true) != expect_escapes ||
+                line_scan_next(data + 162, sizeof(data) - 162, true) != NULL) {
+                result = false;
+            }
+        }
+    }
+
+    /* The splitter itself must not care which scanner it runs on */
+    char *recorded = load_file(TEST_EXTRACT_LOG, &size);
+    if (!recorded) {
+        printf(" (missing %s)", TEST_EXTRACT_LOG);
+        line_scan_use_level(best);
+        return false;
+    }
+
+    line_scan_use_level(LINE_SCAN_SCALAR);
+    memset(&reference, 0, sizeof(reference));
+    strip_in_chunks(recorded, size, 61, &reference);
+
+    for (level = LINE_SCAN_SCALAR + 1; level <= best && result; level++) {
+        line_scan_use_level(level);
+        for (i = 1; i <= 128 && result; i += 31) {
+            memset(&ctx, 0, sizeof(ctx));
+            strip_in_chunks(recorded, size, i, &ctx);
+            if (ctx.count != reference.count) {
+                result = false;
+            }
+            for (line = 0; line < ctx.count && line < MAX_CAPTURED_LINES && result; line++) {
+                result = strcmp(ctx.lines[line], reference.lines[line]) == 0;
+            }
+        }
+    }
+
+    line_scan_use_level(best);
+    free(recorded);
+    printf(" (up to %s)", line_scan_level_name(best));
+    return result;
+}
+
+static bool test_inline_buffer_spill(void)
+{
+    static capture_context_t ctx;
+    char inline_line[16];
+    line_splitter_t splitter;
+    bool result;
+
+    memset(&ctx, 0, sizeof(ctx));
+    line_splitter_init_growable_from(&splitter, inline_line, sizeof(inline_line), 0);
+
+    /* Short lines spanning chunks stay in the caller's buffer */
+    line_splitter_feed(&splitter, "short", 5, capture_line, &ctx);
+    line_splitter_feed(&splitter, " one\n", 5, capture_line, &ctx);
+    if (splitter.owns_buffer || splitter.buffer != inline_line) {
+        return false;
+    }
+
+    /* A longer one moves to the heap with its partial contents intact */
+    line_splitter_feed(&splitter, "0123456789", 10, capture_line, &ctx);
+    line_splitter_feed(&splitter, "abcdefghijklmnopqrstuvwxyz\n", 27, capture_line, &ctx);
+    result = splitter.owns_buffer && splitter.forced_splits == 0 &&
+             ctx.count == 2 &&
+             strcmp(ctx.lines[0], "short one") == 0 &&
+             strcmp(ctx.lines[1], "0123456789abcdefghijklmnopqrstuvwxyz") == 0;
+
+    line_splitter_free(&splitter);
+    return result;
+}
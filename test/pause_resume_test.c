@@ -13,6 +13,7 @@
 
 /* Include the process control system */
 #include "../src/process_control.h"
+#include "../src/platform.h"
 
 /* Test configuration */
 #define TEST_ARCHIVE "assets/A10TankKiller_v2.0_3Disk.lha"
@@ -58,7 +59,7 @@ int main(void)
 #ifdef PLATFORM_AMIGA
         "Amiga (7MHz - Real Process Control Test)"
 #else
-        "Host (stubbed)"
+        "Host (POSIX process group signals)"
 #endif
     );
 
@@ -139,6 +140,9 @@ int main(void)
     printf("Output after quit: %s\n", ctx.output_after_quit ? "yes" : "no");
     printf("Lines after quit: %lu\n", (unsigned long)ctx.lines_after_quit);
     printf("Completion detected: %s\n", ctx.completion_detected ? "yes" : "no");
+#ifndef PLATFORM_AMIGA
+    printf("Pause latency: %lu ms\n", (unsigned long)process.pause_latency_ms);
+#endif
 
     test_log("Final results: processed=%lu, pause_point=%lu, pause_req=%s, quit_req=%s, output_after_quit=%s, lines_after_quit=%lu, complete=%s",
              (unsigned long)ctx.processed_files, (unsigned long)ctx.files_at_pause,
@@ -394,14 +398,10 @@ static bool pause_resume_line_processor(const char *line, void *user_data)
             test_log("Simulating user cancel prompt (3 seconds)");
             
             /* Wait 3 seconds to simulate user decision time */
-            volatile int delay_counter;
             int seconds_remaining = 3;
             
             while (seconds_remaining > 0) {
-                /* Wait approximately 1 second */
-                for (delay_counter = 0; delay_counter < 500000; delay_counter++) {
-                    /* 1 second equivalent busy-wait */
-                }
+                plat_sleep_ms(1000);
                 
                 printf("User prompt: Cancel process? (Y/n) - %d seconds...\n", seconds_remaining);
                 test_log("User prompt simulation: %d seconds remaining", seconds_remaining);
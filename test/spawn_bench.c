@@ -0,0 +1,188 @@
+/*
+ * Spawn Latency Benchmark - Runs a trivial stand-in tool many times through
+ * the controlled process API and reports spawn-to-first-line and
+ * spawn-to-exit latency percentiles. For small archives, starting the tool
+ * is the most expensive step, so this is what to watch for regressions.
+ *
+ * An optional second argument makes the parent touch that many MB first:
+ * fork() has to copy page tables for all of it, posix_spawn() does not.
+ */
+
+#define _POSIX_C_SOURCE 200809L       /* clock_gettime() */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../src/process_control.h"
+
+#define BENCH_DEFAULT_RUNS 500
+
+/* Nanosecond clock for latencies well below a millisecond */
+#define BENCH_NS_PER_US 1000ULL
+
+/* Per-run timing shared with the line callbacks */
+typedef struct {
+    uint64_t start_ns;
+    uint64_t first_line_ns;
+    uint32_t lines;
+} bench_run_t;
+
+/* Internal helper functions */
+static uint64_t now_ns(void);
+static bool first_line(const char *line, void *user_data);
+static bool first_line_view(const char *line, size_t length, void *user_data);
+static void run_case(const char *name, const char *cmd, const char *const argv[], int runs);
+static int compare_u64(const void *a, const void *b);
+static uint64_t percentile(const uint64_t *sorted, int count, int pct);
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_RUNS;
+    int ballast_mb = argc > 2 ? atoi(argv[2]) : 0;
+    const char *const echo_argv[] = {"echo", "stand-in", NULL};
+    char *ballast = NULL;
+
+    if (runs <= 0 || ballast_mb < 0) {
+        printf("Usage: %s [runs] [parent ballast MB]\n", argv[0]);
+        return 1;
+    }
+
+    /* Resident memory in the parent, as a long-running frontend would have */
+    if (ballast_mb > 0) {
+        ballast = (char *)malloc((size_t)ballast_mb * 1024 * 1024);
+        if (!ballast) {
+            printf("ERROR: Could not allocate %d MB ballast\n", ballast_mb);
+            return 1;
+        }
+        memset(ballast, 1, (size_t)ballast_mb * 1024 * 1024);
+    }
+
+    if (!process_control_init()) {
+        printf("ERROR: Could not initialize process control\n");
+        return 1;
+    }
+
+    printf("=== Spawn Latency Benchmark ===\n");
+    printf("Runs per case: %d, parent ballast: %d MB (microseconds)\n\n", runs, ballast_mb);
+    printf("%-28s %-14s %8s %8s %8s %8s\n", "case", "latency", "p50", "p90", "p99", "max");
+
+    /* The stand-in prints one line and exits, so the spawn is all there is */
+    run_case("shell string (sh -c echo)", "echo stand-in", NULL, runs);
+    run_case("argv, no shell (echo)", NULL, echo_argv, runs);
+
+    process_control_cleanup();
+    free(ballast);
+    return 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static bool first_line(const char *line, void *user_data)
+{
+    bench_run_t *run = (bench_run_t *)user_data;
+
+    (void)line;
+    if (run->lines++ == 0) {
+        run->first_line_ns = now_ns();
+    }
+    return true;
+}
+
+static bool first_line_view(const char *line, size_t length, void *user_data)
+{
+    (void)length;
+    return first_line(line, user_data);
+}
+
+static void run_case(const char *name, const char *cmd, const char *const argv[], int runs)
+{
+    process_exec_config_t config = {
+        .tool_name = "Bench",
+        .pipe_prefix = "spawn_bench",
+        .timeout_seconds = 10,
+        .silent_mode = true
+    };
+    uint64_t *first_us = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)runs);
+    uint64_t *exit_us = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)runs);
+    int failures = 0;
+    int done = 0;
+    int i;
+
+    if (!first_us || !exit_us) {
+        printf("ERROR: Out of memory\n");
+        free(first_us);
+        free(exit_us);
+        return;
+    }
+
+    for (i = 0; i < runs; i++) {
+        controlled_process_t process;
+        bench_run_t run = {0, 0, 0};
+        bool ok;
+
+        run.start_ns = now_ns();
+        if (cmd) {
+            ok = execute_controlled_process(cmd, first_line, &run, &config, &process);
+        } else {
+            ok = execute_controlled_process_argv(argv, first_line_view, &run, &config, &process);
+        }
+        uint64_t exit_ns = now_ns();
+        cleanup_controlled_process(&process);
+
+        if (!ok || run.lines == 0) {
+            failures++;
+            continue;
+        }
+        first_us[done] = (run.first_line_ns - run.start_ns) / BENCH_NS_PER_US;
+        exit_us[done] = (exit_ns - run.start_ns) / BENCH_NS_PER_US;
+        done++;
+    }
+
+    if (done > 0) {
+        qsort(first_us, (size_t)done, sizeof(uint64_t), compare_u64);
+        qsort(exit_us, (size_t)done, sizeof(uint64_t), compare_u64);
+
+        printf("%-28s %-14s %8lu %8lu %8lu %8lu\n", name, "first line",
+               (unsigned long)percentile(first_us, done, 50),
+               (unsigned long)percentile(first_us, done, 90),
+               (unsigned long)percentile(first_us, done, 99),
+               (unsigned long)first_us[done - 1]);
+        printf("%-28s %-14s %8lu %8lu %8lu %8lu\n", "", "exit",
+               (unsigned long)percentile(exit_us, done, 50),
+               (unsigned long)percentile(exit_us, done, 90),
+               (unsigned long)percentile(exit_us, done, 99),
+               (unsigned long)exit_us[done - 1]);
+    }
+    if (failures > 0) {
+        printf("%-28s %d of %d runs failed\n", "", failures, runs);
+    }
+
+    free(first_us);
+    free(exit_us);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+/* Nearest-rank percentile of an ascending array */
+static uint64_t percentile(const uint64_t *sorted, int count, int pct)
+{
+    int rank = (count * pct + 99) / 100;
+
+    return sorted[rank > 0 ? rank - 1 : 0];
+}